@@ -10,6 +10,8 @@
 
 isr_t interrupt_handlers[256];
 
+static isr_exception_t exception_handlers[32];
+
 /* Can't do this with a loop because we need the address
  * of the function names */
 void isr_install() {
@@ -121,6 +123,12 @@ char * exception_messages[] = {
 };
 
 void isr_handler(registers_t r) {
+    isr_exception_t handler = exception_handlers[r.int_no];
+
+    if (handler && !handler(&r)) {
+        return;
+    }
+
     print_trace(&r);
     printf("ISR %u (err 0x%X)\n", r.int_no, r.err_code);
     printf("%s\n", exception_messages[r.int_no]);
@@ -129,7 +137,7 @@ void isr_handler(registers_t r) {
             printf("Tried to access address %p\n", r.eax);
         } break;
         case 14: {
-            printf("Tried to access address: %p\n", r.eax);
+            printf("Tried to access address: %p\n", r.cr2);
             switch (r.err_code) {
                 case 0:
                     puts("Supervisory process tried to read a non-present page entry\n");
@@ -181,6 +189,14 @@ void register_interrupt_handler(uint8_t n, isr_t handler) {
     interrupt_handlers[n] = handler;
 }
 
+void register_exception_handler(uint8_t n, isr_exception_t handler) {
+    if (n >= 32) {
+        return;
+    }
+
+    exception_handlers[n] = handler;
+}
+
 void irq_handler(registers_t r) {
     /* After every interrupt we need to send an EOI to the PICs
      * or they will not send another interrupt again */
@@ -8,8 +8,9 @@ mmu_enable_paging:
 
     call mmu_change_dir
 
+    ; PG and WP, kernel writes to read only pages fault for copy on write
     mov eax, cr0
-    or  eax, 0x80000000
+    or  eax, 0x80010000
     mov cr0, eax
 
     pop eax
@@ -17,6 +18,64 @@ mmu_enable_paging:
 
     ret
 
+; bool mmu_pse_supported();
+global mmu_pse_supported
+mmu_pse_supported:
+    push ebx
+
+    ; PSE is bit 3 of edx for cpuid leaf 1
+    mov eax, 1
+    cpuid
+    mov eax, edx
+    shr eax, 3
+    and eax, 1
+
+    pop ebx
+
+    ret
+
+; void mmu_enable_pse();
+global mmu_enable_pse
+mmu_enable_pse:
+    push eax
+
+    mov eax, cr4
+    or  eax, 0x10
+    mov cr4, eax
+
+    pop eax
+
+    ret
+
+; bool mmu_pge_supported();
+global mmu_pge_supported
+mmu_pge_supported:
+    push ebx
+
+    ; PGE is bit 13 of edx for cpuid leaf 1
+    mov eax, 1
+    cpuid
+    mov eax, edx
+    shr eax, 13
+    and eax, 1
+
+    pop ebx
+
+    ret
+
+; void mmu_enable_global_pages();
+global mmu_enable_global_pages
+mmu_enable_global_pages:
+    push eax
+
+    mov eax, cr4
+    or  eax, 0x80
+    mov cr4, eax
+
+    pop eax
+
+    ret
+
 ; void mmu_disable_paging();
 global mmu_disable_paging
 mmu_disable_paging:
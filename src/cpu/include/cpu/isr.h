@@ -74,6 +74,15 @@ extern void irq16();
 
 #define IRQ16 48 // System call
 
+#define ISR_PAGE_FAULT 14
+
+// Page fault error code
+enum PAGE_FAULT_FLAG {
+    PAGE_FAULT_FLAG_PRESENT = 0x1, // Protection fault, page was present
+    PAGE_FAULT_FLAG_WRITE   = 0x2,
+    PAGE_FAULT_FLAG_USER    = 0x4,
+};
+
 /* Struct which aggregates many registers */
 typedef struct {
     uint32_t cr0, cr2, cr3, cr4;
@@ -92,6 +101,20 @@ extern _Noreturn void kernel_exit();
 typedef void (*isr_t)(registers_t *);
 void register_interrupt_handler(uint8_t n, isr_t handler);
 
+typedef int (*isr_exception_t)(registers_t *);
+
+/**
+ * @brief Register a handler for cpu exception `n`.
+ *
+ * The handler returns 0 if it resolved the exception, in which case the
+ * faulting instruction is run again. Any other value falls through to the
+ * kernel panic.
+ *
+ * @param n exception number, less than 32
+ * @param handler handler function or 0 to remove
+ */
+void register_exception_handler(uint8_t n, isr_exception_t handler);
+
 void print_trace(registers_t * r);
 
 void disable_interrupts();
@@ -15,6 +15,13 @@
 #define MMU_DIR_RW_USER   (MMU_DIR_RW | MMU_DIR_FLAG_USER_SUPERVISOR)
 #define MMU_TABLE_RW_USER (MMU_TABLE_RW | MMU_DIR_FLAG_USER_SUPERVISOR)
 
+// Kept in the TLB across cr3 reloads once global pages are enabled
+#define MMU_TABLE_RW_GLOBAL (MMU_TABLE_RW | MMU_TABLE_FLAG_GLOBAL)
+
+// Size of a large page, mapped by a directory entry with
+// MMU_DIR_FLAG_PAGE_SIZE when PSE is enabled
+#define MMU_LARGE_PAGE_SIZE 0x400000
+
 enum MMU_DIR_FLAG {
     MMU_DIR_FLAG_PRESENT         = 0x1,
     MMU_DIR_FLAG_READ_WRITE      = 0x2,
@@ -35,6 +42,7 @@ enum MMU_TABLE_FLAG {
     MMU_TABLE_FLAG_DIRTY           = 0x40,
     MMU_TABLE_FLAG_PAT             = 0x80,
     MMU_TABLE_FLAG_GLOBAL          = 0x100,
+    MMU_TABLE_FLAG_COW             = 0x200, // Available bit, read only page shared until written
 };
 
 typedef uint32_t mmu_entry_t;
@@ -66,6 +74,34 @@ uint32_t mmu_table_get_flags(mmu_table_t * table, size_t i);
 
 void mmu_flush_tlb(uint32_t addr);
 
+/**
+ * @brief Check cpuid for PSE (4 MiB page) support.
+ *
+ * @return true if the cpu supports PSE
+ */
+extern bool mmu_pse_supported(void);
+
+/**
+ * @brief Enable PSE so directory entries with `MMU_DIR_FLAG_PAGE_SIZE` map
+ * 4 MiB pages.
+ */
+extern void mmu_enable_pse(void);
+
+/**
+ * @brief Check cpuid for PGE (global page) support.
+ *
+ * @return true if the cpu supports PGE
+ */
+extern bool mmu_pge_supported(void);
+
+/**
+ * @brief Enable PGE so table entries with `MMU_TABLE_FLAG_GLOBAL` are not
+ * flushed from the TLB when cr3 is loaded. They are still flushed by
+ * `mmu_flush_tlb`.
+ */
+extern void mmu_enable_global_pages(void);
+
+// Also enables write protect, kernel writes to read only pages fault
 extern void     mmu_enable_paging(uint32_t addr);
 extern void     mmu_disable_paging(void);
 extern bool     mmu_paging_enabled(void);
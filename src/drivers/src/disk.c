@@ -39,7 +39,7 @@ disk_t * disk_open(int id, enum DISK_DRIVER driver) {
         disk->driver = driver;
 
         disk->buff_size = DISK_BUFFER_SIZE;
-        disk->buff      = kmalloc(disk->buff_size);
+        disk->buff      = kmalloc_aligned(disk->buff_size, PAGE_SIZE);
         if (!disk->buff) {
             kfree(disk);
             return 0;
@@ -3,10 +3,12 @@
 #include <stdint.h>
 
 #include "kernel.h"
+#include "libc/arena.h"
 #include "libc/memory.h"
 #include "libc/proc.h"
 #include "libc/stdio.h"
 #include "libc/string.h"
+#include "memory_cache.h"
 
 typedef struct {
     char filename[100];
@@ -32,10 +34,12 @@ typedef struct {
 } tar_file_t;
 
 struct tar_fs {
-    disk_t *     disk;
-    size_t       file_count;
-    tar_file_t * files;
-} __attribute__((packed));
+    disk_t *       disk;
+    size_t         file_count;
+    tar_file_t *   files;
+    memory_cache_t file_cache;
+    arena_t        arena;
+};
 
 struct tar_fs_file {
     tar_fs_t *   tar;
@@ -56,15 +60,33 @@ tar_fs_t * tar_open(disk_t * disk) {
 
     tar_fs_t * tar = kmalloc(sizeof(tar_fs_t));
     if (tar) {
+        if (memory_cache_init(&tar->file_cache, kernel_get_memory(), sizeof(tar_fs_file_t), 0)) {
+            kfree(tar);
+            return 0;
+        }
+
+        // Everything loaded for the mount is released together in tar_close
+        if (arena_create(&tar->arena, ARENA_CHUNK_SIZE)) {
+            memory_cache_destroy(&tar->file_cache);
+            kfree(tar);
+            return 0;
+        }
+
         tar->disk       = disk;
         tar->file_count = count_files(tar);
-        tar->files      = kmalloc(sizeof(tar_file_t) * tar->file_count);
+        tar->files      = arena_alloc(&tar->arena, sizeof(tar_file_t) * tar->file_count);
         load_headers(tar);
     }
     return tar;
 }
 
 void tar_close(tar_fs_t * tar) {
+    if (!tar) {
+        return;
+    }
+
+    arena_free(&tar->arena);
+    memory_cache_destroy(&tar->file_cache);
     kfree(tar);
 }
 
@@ -92,6 +114,19 @@ size_t tar_file_size(tar_fs_t * tar, size_t i) {
     return tar->files[i].size;
 }
 
+int tar_file_index(tar_fs_t * tar, const char * filename) {
+    if (!tar || !filename) {
+        return -1;
+    }
+
+    tar_file_t * file = find_filename(tar, filename);
+    if (!file) {
+        return -1;
+    }
+
+    return file->index;
+}
+
 tar_stat_t * tar_stat_file_i(tar_fs_t * tar, size_t i, tar_stat_t * stat) {
     if (!tar || !stat || i > tar->file_count) {
         return 0;
@@ -135,23 +170,44 @@ tar_fs_file_t * tar_file_open(tar_fs_t * tar, const char * filename) {
         return 0;
     }
 
-    tar_fs_file_t * file = kmalloc(sizeof(tar_fs_file_t));
+    tar_file_t * tar_file = find_filename(tar, filename);
+    if (!tar_file) {
+        return 0;
+    }
+
+    tar_fs_file_t * file = memory_cache_alloc(&tar->file_cache);
     if (file) {
         file->tar  = tar;
-        file->file = find_filename(tar, filename);
+        file->file = tar_file;
         file->pos  = 0;
-        file->size = file->file->size;
+        file->size = tar_file->size;
+    }
+    return file;
+}
 
-        if (!file->file) {
-            kfree(file);
-            return 0;
-        }
+tar_fs_file_t * tar_file_open_i(tar_fs_t * tar, size_t i) {
+    if (!tar || i >= tar->file_count) {
+        return 0;
+    }
+
+    tar_file_t * tar_file = &tar->files[i];
+
+    tar_fs_file_t * file = memory_cache_alloc(&tar->file_cache);
+    if (file) {
+        file->tar  = tar;
+        file->file = tar_file;
+        file->pos  = 0;
+        file->size = tar_file->size;
     }
     return file;
 }
 
 void tar_file_close(tar_fs_file_t * file) {
-    kfree(file);
+    if (!file) {
+        return;
+    }
+
+    memory_cache_free(&file->tar->file_cache, file);
 }
 
 bool tar_file_seek(tar_fs_file_t * file, int offset, enum TAR_SEEK_ORIGIN origin) {
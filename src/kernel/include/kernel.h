@@ -9,18 +9,21 @@
 #include "drivers/tar.h"
 #include "ebus.h"
 #include "memory_alloc.h"
+#include "memory_cache.h"
 #include "process.h"
 #include "process_manager.h"
 
 typedef struct _kernel {
-    uint32_t   ram_table_addr;
-    uint32_t   cr3;
-    process_t  proc;
-    proc_man_t pm;
-    memory_t   kernel_memory;
-    ebus_t     event_bus;
-    disk_t *   disk;
-    tar_fs_t * tar;
+    uint32_t       ram_table_addr;
+    uint32_t       cr3;
+    uint32_t       heap_start_page;
+    process_t      proc;
+    proc_man_t     pm;
+    memory_t       kernel_memory;
+    memory_cache_t proc_cache;
+    ebus_t         event_bus;
+    disk_t *       disk;
+    tar_fs_t *     tar;
 } kernel_t;
 
 /**
@@ -43,6 +46,7 @@ mmu_dir_t * get_kernel_dir();
  */
 mmu_table_t * get_kernel_table();
 
+memory_t * kernel_get_memory();
 disk_t *   kernel_get_disk();
 tar_fs_t * kernel_get_tar();
 
@@ -60,6 +64,24 @@ int kernel_add_task(process_t * proc);
 int kernel_next_task();
 int kernel_close_process(process_t * proc);
 
+/**
+ * @brief Allocate memory for a new process from the kernel's process cache.
+ *
+ * The process is not initialized, call `process_create` before use.
+ *
+ * @return process_t* pointer to the process or 0 for fail
+ */
+process_t * kernel_alloc_process();
+
+/**
+ * @brief Return memory for a process to the kernel's process cache.
+ *
+ * Call `process_free` first to release the process resources.
+ *
+ * @param proc pointer returned by `kernel_alloc_process`
+ */
+void kernel_free_process(process_t * proc);
+
 typedef int (*_proc_call_t)(void * data);
 
 int kernel_call_as_proc(int pid, _proc_call_t fn, void * data);
@@ -67,6 +89,7 @@ int kernel_call_as_proc(int pid, _proc_call_t fn, void * data);
 int kernel_switch_task(int next_pid);
 
 void * kmalloc(size_t size);
+void * kmalloc_aligned(size_t size, size_t align);
 void * krealloc(void * ptr, size_t size);
 void   kfree(void * ptr);
 
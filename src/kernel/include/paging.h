@@ -6,16 +6,39 @@
 #include "addr.h"
 #include "cpu/mmu.h"
 
+// Number of physical pages allocated or freed together by one ram call
+#define PAGING_BATCH_SIZE 32
+
+// Largest range of removed pages flushed one page at a time, larger ranges
+// reload the page directory instead
+#define PAGING_FLUSH_MAX_PAGES 32
+
+// Number of zeroed pages kept ready by the idle task
+#define PAGING_ZERO_POOL_SIZE 64
+
 /**
  * @brief Setup paging called by kernel main.
  */
 void paging_init();
 
+/**
+ * @brief Enable 4 MiB large pages if the cpu supports PSE.
+ *
+ * Once enabled, `paging_add_pages` maps each whole, 4 MiB aligned table of a
+ * range with a single large page directory entry.
+ *
+ * @return int 0 if large pages are enabled
+ */
+int paging_enable_large_pages();
+
 /**
  * @brief Map `paddr` to a temporary page and return the virtual address.
  *
  * If `paddr` has already been allocated, return that address and increment the
- * use counter.
+ * use counter. Slots are found by a hash of `paddr`. A slot keeps its mapping
+ * after the counter reaches 0, so mapping the same address again is a hit
+ * without touching the page table. Otherwise the least recently freed slot is
+ * reassigned and only then is its old translation flushed.
  *
  * @param paddr physical address to map
  * @return void* pointer to the virtual page address
@@ -40,6 +63,23 @@ void paging_temp_free(uint32_t paddr);
  */
 size_t paging_temp_available();
 
+/**
+ * @brief Get the number of `paging_temp_map` calls that found `paddr` already
+ * mapped.
+ *
+ * @return size_t number of hits since `paging_init`
+ */
+size_t paging_temp_hits();
+
+/**
+ * @brief Get the number of `paging_temp_map` calls that needed a new slot.
+ *
+ * Includes calls that failed because every slot was in use.
+ *
+ * @return size_t number of misses since `paging_init`
+ */
+size_t paging_temp_misses();
+
 /**
  * @brief Identity map a range of pages.
  *
@@ -70,6 +110,21 @@ int paging_id_map_page(size_t page);
  *
  * The range is end inclusive, ie a page will be added for end.
  *
+ * Physical pages are allocated `PAGING_BATCH_SIZE` at a time with
+ * `paging_alloc_zeroed_n`, so every page is zeroed.
+ *
+ * When large pages are enabled and `dir` is `VADDR_RECURSIVE_DIR`, a directory
+ * entry that is not present and is fully covered by the range becomes a 4 MiB
+ * page of physically contiguous memory instead of a table. It is zeroed in one
+ * pass through its new mapping. If that memory can't be found, or `dir` is any
+ * other directory, 4 KiB pages are used. Pages inside an existing large page
+ * are left alone.
+ *
+ * Each table is mapped once for the run of pages it holds. If `dir` is
+ * `VADDR_RECURSIVE_DIR`, the tables of the active directory are edited through
+ * the recursive mapping. Tables of any other directory are mapped to temp
+ * pages.
+ *
  * @param dir pointer to the page directory
  * @param start first page index
  * @param end last page index (inclusive)
@@ -83,6 +138,17 @@ int paging_add_pages(mmu_dir_t * dir, size_t start, size_t end);
  * The range is end inclusive, ie a page will be freed for end.
  *
  * This function does not free the page tables, it only frees their pages.
+ * Physical pages are freed `PAGING_BATCH_SIZE` at a time. Like
+ * `paging_add_pages`, each table is mapped once per run and the tables of the
+ * active directory are edited through the recursive mapping when `dir` is
+ * `VADDR_RECURSIVE_DIR`. For the active directory, ranges of up to
+ * `PAGING_FLUSH_MAX_PAGES` flush each removed page and larger ranges reload the
+ * page directory once at the end. Other directories are not flushed, except
+ * for pages of the kernel table, which are global, shared by every directory
+ * and always flushed one at a time.
+ *
+ * A large page covered by the range is freed whole. A large page that is only
+ * partly covered is first split into a table of 4 KiB pages.
  *
  * @param dir pointer to the page directory
  * @param start first page index
@@ -94,6 +160,9 @@ int paging_remove_pages(mmu_dir_t * dir, size_t start, size_t end);
 /**
  * @brief Add a table to the current page directory.
  *
+ * The table page comes from `paging_alloc_zeroed`, so it does not need to be
+ * cleared.
+ *
  * @param dir pointer to the page directory
  * @param dir_i table index in page directory
  * @return int 0 for success
@@ -109,4 +178,118 @@ int paging_add_table(mmu_dir_t * dir, size_t dir_i);
  */
 int paging_remove_table(mmu_dir_t * dir, size_t dir_i);
 
+/**
+ * @brief Share the pages of table `dir_i` in `src` with `dst` as copy on write.
+ *
+ * `dst` gets a new table with the same pages. Writable pages are made read
+ * only with `MMU_TABLE_FLAG_COW` in both tables, and every page gets one more
+ * frame reference. A large page in `src` is split into a table first. If this
+ * fails part way through, `dst` keeps the pages that were shared so they are
+ * released with it.
+ *
+ * The TLB is not flushed. `changed` is set when a writable page of `src` is
+ * made read only and is never cleared, so it can be shared by several calls.
+ * If `src` is the active directory, the caller must reload it when `changed`
+ * is set.
+ *
+ * @param src pointer to the page directory to share from
+ * @param dst pointer to the page directory to share with
+ * @param dir_i table index in page directory
+ * @param changed set to 1 if any entry of `src` was made read only
+ * @return int 0 for success
+ */
+int paging_share_table(mmu_dir_t * src, mmu_dir_t * dst, size_t dir_i, int * changed);
+
+/**
+ * @brief Copy the pages of table `dir_i` in `src` into pages of `dst`.
+ *
+ * Pages that are already present in `dst` are written over, missing pages and
+ * the table itself are allocated.
+ *
+ * @param src pointer to the page directory to copy from
+ * @param dst pointer to the page directory to copy to
+ * @param dir_i table index in page directory
+ * @return int 0 for success
+ */
+int paging_copy_table(mmu_dir_t * src, mmu_dir_t * dst, size_t dir_i);
+
+/**
+ * @brief Make a copy on write page writable.
+ *
+ * The page is copied to a new page unless this was the last reference to it.
+ *
+ * @param dir pointer to the page directory
+ * @param page page index of the write
+ * @return int 0 for success, -1 if the page is not copy on write
+ */
+int paging_copy_on_write(mmu_dir_t * dir, size_t page);
+
+/**
+ * @brief Clear the dirty flag of a present page.
+ *
+ * The cpu sets `MMU_TABLE_FLAG_DIRTY` again on the next write to the page.
+ *
+ * @param dir pointer to the page directory
+ * @param page page index
+ * @return int 0 for success
+ */
+int paging_clean_page(mmu_dir_t * dir, size_t page);
+
+/**
+ * @brief Remove pages from `start` to `end` (inclusive) that were not written
+ * since `paging_clean_page`.
+ *
+ * Only pages without `MMU_TABLE_FLAG_DIRTY` are removed, tables are kept.
+ * Large pages are skipped.
+ *
+ * @param dir pointer to the page directory
+ * @param start first page index
+ * @param end last page index
+ * @return int number of pages removed or -1 for failure
+ */
+int paging_drop_clean_pages(mmu_dir_t * dir, size_t start, size_t end);
+
+/**
+ * @brief Allocate a zeroed page and return it's physical address.
+ *
+ * The page is taken from the zero pool if it has any. Otherwise a new page is
+ * allocated and zeroed through a temp page.
+ *
+ * @return uint32_t physical address of the page or 0 for failure
+ */
+uint32_t paging_alloc_zeroed();
+
+/**
+ * @brief Allocate `count` zeroed pages and write their physical addresses to
+ * `out`.
+ *
+ * Pages are taken from the zero pool first, the rest are allocated with
+ * `ram_page_alloc_n` and zeroed through a temp page. Either all `count` pages
+ * are allocated or none are.
+ *
+ * @param out pointer to an array of at least `count` page addresses
+ * @param count number of pages to allocate
+ * @return int 0 for success
+ */
+int paging_alloc_zeroed_n(uint32_t * out, size_t count);
+
+/**
+ * @brief Zero up to `count` new pages and add them to the zero pool.
+ *
+ * This is called by the idle task to do the zeroing off the critical path.
+ * Interrupts are disabled while each page is zeroed and added, and enabled
+ * again after, so it must only be called with interrupts enabled.
+ *
+ * @param count maximum number of pages to add
+ * @return size_t number of pages added
+ */
+size_t paging_zero_pool_fill(size_t count);
+
+/**
+ * @brief Get the number of zeroed pages in the zero pool.
+ *
+ * @return size_t number of pages
+ */
+size_t paging_zero_pool_count();
+
 #endif // KERNEL_PAGING_H
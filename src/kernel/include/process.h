@@ -4,10 +4,17 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "drivers/tar.h"
 #include "ebus.h"
 #include "libc/datastruct/array.h"
 #include "memory_alloc.h"
 
+// Max number of reserved page ranges for each process
+#define PROCESS_RESERVED_MAX 8
+
+// Max number of files mapped by each process
+#define PROCESS_FILE_MAP_MAX 4
+
 typedef void (*signals_master_cb_t)(int);
 
 enum HANDLE_TYPE {
@@ -20,6 +27,18 @@ typedef struct _handle {
     int type;
 } handle_t;
 
+typedef struct _process_range {
+    uint32_t start; // first page
+    uint32_t count; // 0 if this range is not used
+} process_range_t;
+
+typedef struct _process_file_map {
+    uint32_t   start; // first page
+    uint32_t   count; // 0 if this map is not used
+    tar_fs_t * tar;
+    size_t     file_i; // index of the file in tar
+} process_file_map_t;
+
 enum PROCESS_STATE {
     PROCESS_STATE_STARTING = 0,
     PROCESS_STATE_LOADING,
@@ -40,7 +59,11 @@ typedef struct _process {
     uint32_t next_heap_page;
     uint32_t stack_page_count;
 
-    // TODO heap & stack limits
+    // Pages are added to these ranges on first touch
+    process_range_t reserved[PROCESS_RESERVED_MAX];
+
+    // Pages are read from these files on first touch
+    process_file_map_t file_maps[PROCESS_FILE_MAP_MAX];
 
     signals_master_cb_t signals_callback;
     arr_t               io_handles; // array<handle_t>
@@ -55,7 +78,9 @@ typedef struct _process {
 /**
  * @brief Create a new process and it's page directory.
  *
- * Allocates pages for the isr stack and 1 for the user stack.
+ * Allocates pages for the isr stack and 1 for the user stack. The rest of the
+ * user stack, down to the recursive mapping, is reserved and added by
+ * `process_page_fault` on first touch.
  *
  * @param proc pointer to the process object
  * @return int 0 for success
@@ -72,6 +97,21 @@ int process_create(process_t * proc);
  */
 int process_free(process_t * proc);
 
+/**
+ * @brief Create `child` as a copy of `proc` that shares its heap.
+ *
+ * Heap pages are shared copy on write, so a page is only copied when one of
+ * the processes writes to it. The stack table is copied right away, because
+ * a write fault on the stack would have no stack left for the fault handler.
+ * The child starts with no io handles or events.
+ *
+ * @param proc pointer to the process to copy, its directory must be active
+ * @param child pointer to the new process object
+ * @param esp stack pointer the child resumes from in `switch_task`
+ * @return int 0 for success
+ */
+int process_fork(process_t * proc, process_t * child, uint32_t esp);
+
 /**
  * @brief Set the entry point or eip of the process.
  *
@@ -105,6 +145,77 @@ int process_resume(process_t * proc, const ebus_event_t * event);
  */
 void * process_add_pages(process_t * proc, size_t count);
 
+/**
+ * @brief Reserve `count` pages at the end of the process heap without
+ * allocating them.
+ *
+ * Each page is allocated by `process_page_fault` the first time it is touched.
+ *
+ * @param proc pointer to the process object
+ * @param count number of pages to reserve
+ * @return pointer to the first reserved page in virtual memory
+ */
+void * process_reserve_pages(process_t * proc, size_t count);
+
+/**
+ * @brief Remove `count` pages from the process heap and free their memory.
+ *
+ * The pages must be inside the heap. If they are at the end of the heap, the
+ * next call to `process_add_pages` will start from `addr`. Reserved pages in
+ * the range are no longer reserved.
+ *
+ * @param proc pointer to the process object
+ * @param addr virtual address of the first page, must be page aligned
+ * @param count number of pages to remove
+ * @return int 0 for success
+ */
+int process_remove_pages(process_t * proc, void * addr, size_t count);
+
+/**
+ * @brief Map file `file_i` of `tar` at the end of the process heap.
+ *
+ * No pages are added here. Each page is read from the file the first time it
+ * is touched, and bytes past the end of the file are zero. Writes are not
+ * saved to the file.
+ *
+ * @param proc pointer to the process object
+ * @param tar pointer to the tar filesystem, which must outlive the map
+ * @param file_i index of the file in `tar`
+ * @return pointer to the first page of the file in virtual memory
+ */
+void * process_map_file(process_t * proc, tar_fs_t * tar, size_t file_i);
+
+/**
+ * @brief Remove a file map and free its pages.
+ *
+ * @param proc pointer to the process object
+ * @param addr pointer returned by `process_map_file`
+ * @return int 0 for success
+ */
+int process_unmap_file(process_t * proc, void * addr);
+
+/**
+ * @brief Free the pages of mapped files that were not written.
+ *
+ * The pages stay mapped and are read from the file again when next touched.
+ *
+ * @param proc pointer to the process object
+ * @return int number of pages freed or -1 for failure
+ */
+int process_drop_file_pages(process_t * proc);
+
+/**
+ * @brief Add the page holding `vaddr` if it is reserved by the process.
+ *
+ * Called for page faults on pages that are not present. Pages of mapped files
+ * are read from the file, which needs `proc` to be the active process.
+ *
+ * @param proc pointer to the process object
+ * @param vaddr virtual address that caused the fault
+ * @return int 0 if the page was added
+ */
+int process_page_fault(process_t * proc, uint32_t vaddr);
+
 /**
  * @brief Add a single page to expand the process stack
  *
@@ -148,4 +259,14 @@ extern void        set_active_task(process_t * active);
 extern process_t * get_active_task(void);
 extern void        switch_task(process_t * proc);
 
+/**
+ * @brief Fork the active task into `child` with `process_fork`.
+ *
+ * The child resumes from this call when it is first switched to.
+ *
+ * @param child pointer to the new process object
+ * @return int 0 in the parent, 1 in the child or -1 for failure
+ */
+extern int fork_task(process_t * child);
+
 #endif // KERNEL_PROCESS_H
@@ -18,6 +18,17 @@ typedef struct _ram_table {
     ram_table_entry_t entries[REGION_TABLE_SIZE];
 } __attribute__((packed)) ram_table_t;
 
+// Frame reference count in the low bits, flags in the high bits
+#define RAM_FRAME_REF_MASK  0x0fff
+#define RAM_FRAME_FLAG_MASK 0xf000
+
+enum RAM_FRAME_FLAG {
+    // Frame was in use before the frame database was initialized
+    RAM_FRAME_FLAG_KERNEL = 0x1000,
+};
+
+typedef uint16_t ram_frame_t;
+
 /**
  * @brief Initialize physical memory allocator.
  *
@@ -43,6 +54,10 @@ int ram_init(ram_table_t * ram_table, void * bitmasks);
  *
  * `base` must be page aligned.
  *
+ * Regions only hold 32 bit physical addresses. Memory starting at or above
+ * 4 GiB is rejected and memory crossing 4 GiB is cut short, the kernel's 32 bit
+ * page tables can't map it.
+ *
  * @param base address of the memory
  * @param length size in bytes of the memory
  * @return int 0 for success
@@ -73,7 +88,8 @@ size_t ram_max_pages();
 /**
  * @brief Allocate a single page and return it's physical address.
  *
- * The address will always be page aligned.
+ * The address will always be page aligned. The bitmask is searched 32 pages
+ * at a time, starting from where the last page of the region was found.
  *
  * Paging / virtual memory MUST BE ENABLED. If this function is called without
  * paging, bad things will happen. There is no check for paging enabled /
@@ -106,9 +122,150 @@ uint32_t ram_page_palloc();
  * paging, bad things will happen. There is no check for paging enabled /
  * disabled state.
  *
+ * Once the frame database is initialized, this drops one reference and the
+ * page is only freed when no references are left.
+ *
  * @param addr physical address of the page
  * @return int 0 for success
  */
 int ram_page_free(uint32_t addr);
 
+/**
+ * @brief Allocate `count` pages and write their physical addresses to `out`.
+ *
+ * The pages are not contiguous. All pages are found in one pass over the
+ * region table, taking every free page of a bitmask word at once. Either all
+ * `count` pages are allocated or none are.
+ *
+ * Paging / virtual memory MUST BE ENABLED. If this function is called without
+ * paging, bad things will happen. There is no check for paging enabled /
+ * disabled state.
+ *
+ * @param out pointer to an array of at least `count` page addresses
+ * @param count number of pages to allocate
+ * @return int 0 for success
+ */
+int ram_page_alloc_n(uint32_t * out, size_t count);
+
+/**
+ * @brief Free `count` pages allocated by ram_page_alloc or ram_page_alloc_n.
+ *
+ * The region of the last page is kept, so pages from the same region are
+ * freed without searching the region table again. Invalid or already free
+ * pages are skipped and the rest are still freed. Like `ram_page_free`, pages
+ * with other references are not freed once the frame database is initialized.
+ *
+ * Paging / virtual memory MUST BE ENABLED. If this function is called without
+ * paging, bad things will happen. There is no check for paging enabled /
+ * disabled state.
+ *
+ * @param addrs pointer to an array of `count` physical page addresses
+ * @param count number of pages to free
+ * @return int 0 for success, -1 if any page could not be freed
+ */
+int ram_page_free_n(const uint32_t * addrs, size_t count);
+
+/**
+ * @brief Allocate `count` pages in a row and return the physical address of
+ * the first.
+ *
+ * The address will always be aligned to `align` bytes. `align` must be a power
+ * of 2, values below `PAGE_SIZE` are treated as `PAGE_SIZE`. The pages are all
+ * taken from a single region. When a used page is found, the search skips to
+ * the next aligned page after it, so fragmented regions are not scanned once
+ * per candidate.
+ *
+ * Paging / virtual memory MUST BE ENABLED. If this function is called without
+ * paging, bad things will happen. There is no check for paging enabled /
+ * disabled state.
+ *
+ * @param count number of pages to allocate
+ * @param align alignment of the physical address in bytes
+ * @return uint32_t address of the first page or 0 for failure
+ */
+uint32_t ram_page_alloc_range(size_t count, size_t align);
+
+/**
+ * @brief Free pages allocated by ram_page_alloc_range.
+ *
+ * Any range of used pages in a single region can be freed, not only a whole
+ * range from `ram_page_alloc_range`. If any page in the range is already free,
+ * nothing is freed. Like `ram_page_free`, pages with other references are not
+ * freed once the frame database is initialized.
+ *
+ * Paging / virtual memory MUST BE ENABLED. If this function is called without
+ * paging, bad things will happen. There is no check for paging enabled /
+ * disabled state.
+ *
+ * @param addr physical address of the first page
+ * @param count number of pages to free
+ * @return int 0 for success
+ */
+int ram_page_free_range(uint32_t addr, size_t count);
+
+/**
+ * @brief Get the number of bytes needed for the frame database.
+ *
+ * There is one `ram_frame_t` for each page of every region, including the
+ * bitmask pages.
+ *
+ * @return size_t size of the frame database in bytes
+ */
+size_t ram_frame_db_size();
+
+/**
+ * @brief Initialize the frame database.
+ *
+ * `frames` must be at least `ram_frame_db_size` bytes. All regions must be
+ * added before this is called. Every page that is already used gets a
+ * reference count of 1 and the `RAM_FRAME_FLAG_KERNEL` flag, every free page
+ * gets a reference count of 0.
+ *
+ * Once initialized, allocated pages start with a reference count of 1 and
+ * freeing a page drops one reference. The page is only returned to the
+ * bitmask when the last reference is dropped.
+ *
+ * @param frames virtual address of the frame database
+ * @return int 0 for success
+ */
+int ram_frame_db_init(ram_frame_t * frames);
+
+/**
+ * @brief Add a reference to an allocated page.
+ *
+ * Each reference must be dropped with one of the `ram_page_free*` functions.
+ *
+ * @param addr physical address of the page
+ * @return int 0 for success, -1 if the page is free or has too many references
+ */
+int ram_frame_ref(uint32_t addr);
+
+/**
+ * @brief Get the reference count of a page.
+ *
+ * @param addr physical address of the page
+ * @return int reference count or -1 for failure
+ */
+int ram_frame_ref_count(uint32_t addr);
+
+/**
+ * @brief Set the flags of an allocated page.
+ *
+ * Only bits in `RAM_FRAME_FLAG_MASK` are kept. Flags are cleared when the page
+ * is freed.
+ *
+ * @param addr physical address of the page
+ * @param flags flags from `RAM_FRAME_FLAG`
+ * @return int 0 for success
+ */
+int ram_frame_set_flags(uint32_t addr, uint16_t flags);
+
+/**
+ * @brief Get the flags of a page.
+ *
+ * @param addr physical address of the page
+ * @return int flags or -1 for failure
+ */
+int ram_frame_get_flags(uint32_t addr);
+
 #endif // KERNEL_RAM_H
@@ -183,6 +183,48 @@ static int ret_cmd(size_t argc, char ** argv) {
     return 0;
 }
 
+#define HEAP_TOP_COUNT 8
+
+static void heap_print_top(enum MEMORY_PROFILE_SORT sort) {
+    memory_profile_site_t sites[HEAP_TOP_COUNT];
+
+    int count = memory_profile_top(kernel_get_memory(), sites, HEAP_TOP_COUNT, sort);
+
+    printf("%-10s %8s %8s %6s %8s %8s\n", "caller", "bytes", "count", "live", "live b", "avg life");
+
+    for (int i = 0; i < count; i++) {
+        memory_profile_site_t * site = &sites[i];
+
+        uint32_t freed = site->alloc_count - site->live_count;
+        uint32_t life  = freed ? site->lifetime / freed : 0;
+
+        printf("%8p %8u %8u %6u %8u %8u\n",
+               site->caller,
+               site->alloc_bytes,
+               site->alloc_count,
+               site->live_count,
+               site->live_bytes,
+               life);
+    }
+}
+
+static int heap_cmd(size_t argc, char ** argv) {
+    memory_profile_site_t site;
+
+    if (memory_profile_top(kernel_get_memory(), &site, 1, MEMORY_PROFILE_SORT_BYTES) < 0) {
+        puts("Heap profiling is not enabled, build with OS_MEMORY_PROFILE\n");
+        return 1;
+    }
+
+    puts("Top sites by bytes\n");
+    heap_print_top(MEMORY_PROFILE_SORT_BYTES);
+
+    puts("\nTop sites by count\n");
+    heap_print_top(MEMORY_PROFILE_SORT_COUNT);
+
+    return 0;
+}
+
 // static int format_cmd(size_t argc, char ** argv) {
 //     if (fs) {
 //         puts("Unmount disk before format\n");
@@ -584,6 +626,7 @@ static int hotswap(size_t argc, char ** argv) {
     mmu_dir_set(dir, 0, mmu_dir_get_addr(UINT2PTR(VADDR_KERNEL_DIR), 0), MMU_DIR_RW);
 
     kmemcpy(dir, UINT2PTR(VADDR_KERNEL_DIR), sizeof(mmu_dir_t));
+    mmu_dir_set(dir, RECURSIVE_DIR_INDEX, addr, MMU_DIR_RW);
 
     printf("Switching to new dir %p\n", addr);
 
@@ -619,6 +662,11 @@ static void assert_all_unique(uint32_t cr3) {
     mmu_dir_t * dir = paging_temp_map(cr3);
 
     for (size_t i = 0; i < MMU_DIR_SIZE; i++) {
+        // Recursive entry is the dir itself
+        if (i == RECURSIVE_DIR_INDEX) {
+            continue;
+        }
+
         if (mmu_dir_get_flags(dir, i) & MMU_DIR_FLAG_PRESENT) {
             uint32_t      table_addr = mmu_dir_get_addr(dir, i);
             mmu_table_t * table      = paging_temp_map(table_addr);
@@ -700,11 +748,11 @@ static void assert_process_is(process_t * proc) {
 static int procswap(size_t argc, char ** argv) {
     static process_t * proc = 0;
 
-    process_t * next_proc = kmalloc(sizeof(process_t));
+    process_t * next_proc = kernel_alloc_process();
 
     if (process_create(next_proc)) {
         printf("Failed to do it\n");
-        kfree(next_proc);
+        kernel_free_process(next_proc);
         return 1;
     }
 
@@ -720,7 +768,7 @@ static int procswap(size_t argc, char ** argv) {
     if (proc) {
         printf("Free first\n");
         process_free(proc);
-        kfree(proc);
+        kernel_free_process(proc);
     }
 
     // printf("Ptr1 = %p\n", ptr1);
@@ -793,6 +841,7 @@ void commands_init() {
     term_command_add("time", time_cmd);
     term_command_add("sleep", sleep_cmd);
     term_command_add("ret", ret_cmd);
+    term_command_add("heap", heap_cmd);
     // term_command_add("format", format_cmd);
     // term_command_add("mount", mount_cmd);
     // term_command_add("unmount", unmount_cmd);
@@ -1,14 +1,25 @@
 #include "idle.h"
 
+#include "cpu/isr.h"
 #include "kernel.h"
 #include "libc/memory.h"
 #include "libc/proc.h"
 #include "libc/stdio.h"
+#include "paging.h"
+#include "process_manager.h"
+#include "ram.h"
+
+// Pages zeroed each time the idle task runs
+#define IDLE_ZERO_PAGES 8
+
+// Clean pages of mapped files are dropped below this many free pages
+#define IDLE_LOW_PAGES 256
 
 static void idle_loop();
+static void drop_file_pages();
 
 process_t * init_idle() {
-    process_t * proc = kmalloc(sizeof(process_t));
+    process_t * proc = kernel_alloc_process();
     if (!proc || process_create(proc)) {
         return 0;
     }
@@ -23,8 +34,26 @@ static void idle_loop() {
     for (;;) {
         // printf("idle %u\n", getpid());
         ebus_cycle(get_kernel_ebus());
+        paging_zero_pool_fill(IDLE_ZERO_PAGES);
+        if (ram_free_pages() < IDLE_LOW_PAGES) {
+            drop_file_pages();
+        }
         asm("hlt");
         int curr_pid = get_current_process()->pid;
         yield();
     }
 }
+
+static void drop_file_pages() {
+    arr_t * tasks = &kernel_get_proc_man()->task_list;
+
+    for (size_t i = 0; i < arr_size(tasks); i++) {
+        process_t * proc;
+        arr_get(tasks, i, &proc);
+
+        // Process must not run while its pages are dropped
+        disable_interrupts();
+        process_drop_file_pages(proc);
+        enable_interrupts();
+    }
+}
@@ -28,6 +28,7 @@
 #include "libc/string.h"
 #include "libk/defs.h"
 #include "libk/sys_call.h"
+#include "paging.h"
 #include "process.h"
 #include "process_manager.h"
 #include "ram.h"
@@ -41,9 +42,12 @@ static void id_map_range(mmu_table_t * table, size_t start, size_t end);
 static void id_map_page(mmu_table_t * table, size_t page);
 static void cursor();
 static void irq_install();
+static int  page_fault(registers_t * regs);
 static int  kill(size_t argc, char ** argv);
 static int  try_switch(size_t argc, char ** argv);
 static void map_first_table(mmu_table_t * table);
+static void * kernel_page_alloc(size_t count);
+static int    kernel_page_free(void * addr, size_t count);
 
 extern void jump_kernel_mode(void * fn);
 
@@ -89,18 +93,55 @@ void kernel_main() {
     mmu_table_clear(first_table);
     map_first_table(first_table);
 
-    // Map last table to dir for access to tables
-    mmu_dir_set(pdir, MMU_DIR_SIZE - 1, __kernel.cr3, MMU_DIR_RW);
+    // Map recursive table to dir for access to tables
+    mmu_dir_set(pdir, RECURSIVE_DIR_INDEX, __kernel.cr3, MMU_DIR_RW);
 
     // Enter Paging
     mmu_enable_paging(__kernel.cr3);
 
+    // Temp pages are chained at runtime, there is no static init
+    paging_init();
+
+    // Whole 4 MiB ranges use large pages when the cpu has PSE
+    paging_enable_large_pages();
+
+    // Kernel table pages are global, keep them in the TLB across task switches
+    if (mmu_pge_supported()) {
+        mmu_enable_global_pages();
+    }
+
     // GDT & TSS
     init_gdt();
     init_tss();
 
+    // RAM frame database in its own table, outside of the kmalloc heap
+    size_t frame_db_pages = (ram_frame_db_size() + PAGE_SIZE - 1) / PAGE_SIZE;
+
+    if (frame_db_pages > MMU_TABLE_SIZE) {
+        KPANIC("Frame database does not fit in one table");
+    }
+
+    if (paging_add_table(UINT2PTR(VADDR_RECURSIVE_DIR), FRAME_DB_DIR_INDEX)) {
+        KPANIC("Failed to allocate frame database table");
+    }
+
+    mmu_table_t * frame_db_table = UINT2PTR(VADDR_RECURSIVE_TABLES + PAGE2ADDR(FRAME_DB_DIR_INDEX));
+
+    for (size_t i = 0; i < frame_db_pages; i++) {
+        uint32_t frame_db_addr = ram_page_alloc();
+        if (!frame_db_addr) {
+            KPANIC("Failed to allocate frame database");
+        }
+        mmu_table_set(frame_db_table, i, frame_db_addr, MMU_TABLE_RW_GLOBAL);
+    }
+
+    if (ram_frame_db_init(UINT2PTR(VADDR_FRAME_DB))) {
+        KPANIC("Failed to init frame database");
+    }
+
     // Kernel process used for memory allocation
-    __kernel.proc.next_heap_page = ADDR2PAGE(VADDR_RAM_BITMASKS) + ram_region_table_count();
+    __kernel.heap_start_page     = ADDR2PAGE(VADDR_RAM_BITMASKS) + ram_region_table_count();
+    __kernel.proc.next_heap_page = __kernel.heap_start_page;
     __kernel.proc.cr3            = PADDR_KERNEL_DIR;
     __kernel.proc.esp0           = VADDR_ISR_STACK;
     __kernel.proc.state          = PROCESS_STATE_LOADED;
@@ -110,6 +151,7 @@ void kernel_main() {
     tss_set_esp0(VADDR_ISR_STACK);
 
     isr_install();
+    register_exception_handler(ISR_PAGE_FAULT, page_fault);
 
     init_system_call(IRQ16);
     system_call_register(SYS_INT_FAMILY_IO, sys_call_io_cb);
@@ -117,10 +159,14 @@ void kernel_main() {
     system_call_register(SYS_INT_FAMILY_PROC, sys_call_proc_cb);
     system_call_register(SYS_INT_FAMILY_STDIO, sys_call_tmp_stdio_cb);
 
-    // Init kernel memory after system calls are registered
-    memory_init(&__kernel.kernel_memory, _sys_page_alloc);
+    // Kernel memory maps pages in the kernel table, not the current process
+    memory_init(&__kernel.kernel_memory, kernel_page_alloc, kernel_page_free);
     init_malloc(&__kernel.kernel_memory);
 
+    if (memory_cache_init(&__kernel.proc_cache, &__kernel.kernel_memory, sizeof(process_t), 0)) {
+        KPANIC("Failed to init process cache");
+    }
+
     pm_create(&__kernel.pm);
 
     process_t * idle = init_idle();
@@ -160,7 +206,7 @@ void kernel_main() {
         KPANIC("Failed to open tar");
     }
 
-    process_t * foo_proc = kmalloc(sizeof(process_t));
+    process_t * foo_proc = kernel_alloc_process();
     if (process_create(foo_proc)) {
         KPANIC("Failed to create foo task");
     }
@@ -168,7 +214,7 @@ void kernel_main() {
     foo_proc->state = PROCESS_STATE_LOADED;
     pm_add_proc(&__kernel.pm, foo_proc);
 
-    process_t * bar_proc = kmalloc(sizeof(process_t));
+    process_t * bar_proc = kernel_alloc_process();
     if (process_create(bar_proc)) {
         KPANIC("Failed to create bar task");
     }
@@ -223,6 +269,10 @@ ebus_t * get_kernel_ebus() {
     return &__kernel.event_bus;
 }
 
+memory_t * kernel_get_memory() {
+    return &__kernel.kernel_memory;
+}
+
 disk_t * kernel_get_disk() {
     return __kernel.disk;
 }
@@ -284,8 +334,20 @@ process_t * kernel_find_pid(int pid) {
     return pm_find_pid(&__kernel.pm, pid);
 }
 
+process_t * kernel_alloc_process() {
+    return memory_cache_alloc(&__kernel.proc_cache);
+}
+
+void kernel_free_process(process_t * proc) {
+    memory_cache_free(&__kernel.proc_cache, proc);
+}
+
 void * kmalloc(size_t size) {
-    return memory_alloc(&__kernel.kernel_memory, size);
+    return MEMORY_ALLOC_CALLER(&__kernel.kernel_memory, size);
+}
+
+void * kmalloc_aligned(size_t size, size_t align) {
+    return MEMORY_ALLOC_ALIGNED_CALLER(&__kernel.kernel_memory, size, align);
 }
 
 void * krealloc(void * ptr, size_t size) {
@@ -316,6 +378,20 @@ static void irq_install() {
     init_rtc(RTC_RATE_1024_HZ);
 }
 
+// Reserved pages of the active process are added on first touch, shared
+// pages are copied on the first write
+static int page_fault(registers_t * regs) {
+    if (regs->err_code & PAGE_FAULT_FLAG_PRESENT) {
+        if (!(regs->err_code & PAGE_FAULT_FLAG_WRITE)) {
+            return -1;
+        }
+
+        return paging_copy_on_write(UINT2PTR(VADDR_RECURSIVE_DIR), ADDR2PAGE(regs->cr2));
+    }
+
+    return process_page_fault(get_active_task(), regs->cr2);
+}
+
 static int kill(size_t argc, char ** argv) {
     printf("Leaving process now\n");
     kernel_exit();
@@ -328,10 +404,10 @@ static void map_first_table(mmu_table_t * table) {
     mmu_table_set(table, 0, 0, 0);
 
     // Page Directory
-    mmu_table_set(table, 1, __kernel.cr3, MMU_DIR_RW);
+    mmu_table_set(table, 1, __kernel.cr3, MMU_TABLE_RW_GLOBAL);
 
     // Create first table
-    mmu_table_set(table, 2, __kernel.ram_table_addr, MMU_DIR_RW);
+    mmu_table_set(table, 2, __kernel.ram_table_addr, MMU_TABLE_RW_GLOBAL);
 
     // Stack
     id_map_range(table, 3, 6);
@@ -343,14 +419,14 @@ static void map_first_table(mmu_table_t * table) {
     id_map_page(table, 0xb8);
 
     // Kernel Table
-    mmu_table_set(table, ADDR2PAGE(VADDR_KERNEL_TABLE), (uint32_t)table, MMU_TABLE_RW);
+    mmu_table_set(table, ADDR2PAGE(VADDR_KERNEL_TABLE), (uint32_t)table, MMU_TABLE_RW_GLOBAL);
 
     // RAM region bitmasks
     ram_table_t * ram_table = (ram_table_t *)(__kernel.ram_table_addr);
 
     for (size_t i = 0; i < ram_region_table_count(); i++) {
         uint32_t bitmask_addr = ram_table->entries[i].addr_flags & MASK_ADDR;
-        mmu_table_set(table, ADDR2PAGE(VADDR_RAM_BITMASKS) + i, bitmask_addr, MMU_TABLE_RW);
+        mmu_table_set(table, ADDR2PAGE(VADDR_RAM_BITMASKS) + i, bitmask_addr, MMU_TABLE_RW_GLOBAL);
     }
 }
 
@@ -367,5 +443,49 @@ static void id_map_range(mmu_table_t * table, size_t start, size_t end) {
 }
 
 static void id_map_page(mmu_table_t * table, size_t page) {
-    mmu_table_set(table, page, page << 12, MMU_TABLE_RW);
+    mmu_table_set(table, page, page << 12, MMU_TABLE_RW_GLOBAL);
+}
+
+// Kernel heap pages stay in the kernel table, which every page directory
+// shares, so they are added through whichever directory is active
+static void * kernel_page_alloc(size_t count) {
+    process_t * proc = &__kernel.proc;
+
+    if (!count || proc->next_heap_page + count > MMU_TABLE_SIZE) {
+        return 0;
+    }
+
+    if (paging_add_pages(UINT2PTR(VADDR_RECURSIVE_DIR), proc->next_heap_page, proc->next_heap_page + count - 1)) {
+        return 0;
+    }
+
+    void * ptr = UINT2PTR(PAGE2ADDR(proc->next_heap_page));
+    proc->next_heap_page += count;
+
+    return ptr;
+}
+
+// Release pages from kernel_page_alloc, whichever process is current
+static int kernel_page_free(void * addr, size_t count) {
+    process_t * proc  = &__kernel.proc;
+    uint32_t    vaddr = PTR2UINT(addr);
+    uint32_t    start = ADDR2PAGE(vaddr);
+
+    if (!count || vaddr & 0xfff) {
+        return -1;
+    }
+
+    if (start < __kernel.heap_start_page || start + count > proc->next_heap_page) {
+        return -1;
+    }
+
+    if (paging_remove_pages(UINT2PTR(VADDR_RECURSIVE_DIR), start, start + count - 1)) {
+        return -1;
+    }
+
+    if (start + count == proc->next_heap_page) {
+        proc->next_heap_page = start;
+    }
+
+    return 0;
 }
@@ -50,6 +50,49 @@ get_active_task:
 
     ret
 
+[extern process_fork]
+
+; int fork_task(proc_t * child)
+global fork_task
+fork_task:
+    push ebp
+    mov  ebp, esp
+
+    push ebx
+    push edi
+    push esi
+
+    ; Frame popped by switch_task when the child first runs
+    push .child
+    push ebp
+    push edi
+    push esi
+    push eax
+
+    ; eax = process_fork(active, child, esp)
+    mov  eax, esp
+    push eax
+    push dword [ebp+8]
+    push dword [active_task]
+    call process_fork
+    add  esp, 12
+
+    ; drop the child frame
+    add esp, 20
+
+.done:
+    pop esi
+    pop edi
+    pop ebx
+
+    pop ebp
+
+    ret
+
+.child:
+    mov eax, 1
+    jmp .done
+
 ; switch_task(proc_t * next)
 global switch_task
 switch_task:
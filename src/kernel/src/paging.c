@@ -1,17 +1,88 @@
 #include "paging.h"
 
+#include "cpu/isr.h"
 #include "libc/string.h"
 #include "ram.h"
 
+// Number of hash buckets for temp pages, must be a power of 2
+#define TEMP_BUCKET_COUNT  32
+#define TEMP_BUCKET(PADDR) (ADDR2PAGE(PADDR) & (TEMP_BUCKET_COUNT - 1))
+
+// End of a bucket chain or the free list
+#define TEMP_NONE -1
+
+// Slots are chained by bucket and, while count is 0, by the free list
 typedef struct {
     uint32_t addr;
     size_t   count;
+    int      hash_next;
+    int      free_prev;
+    int      free_next;
 } page_user_t;
 
 static page_user_t temp_pages[VADDR_TMP_PAGE_COUNT];
+static int         temp_buckets[TEMP_BUCKET_COUNT];
+
+// Slots with a count of 0, least recently freed first
+static int    temp_free_head;
+static int    temp_free_tail;
+static size_t temp_free_count;
+
+static size_t temp_hits;
+static size_t temp_misses;
+
+// Physical pages that are already zeroed, used from the top
+static uint32_t zero_pool[PAGING_ZERO_POOL_SIZE];
+static size_t   zero_pool_count;
+
+// Set once PSE is enabled
+static int large_pages;
+
+static int           zero_page(uint32_t addr);
+static int           copy_page(uint32_t dst, uint32_t src);
+static mmu_table_t * map_table(mmu_dir_t * dir, size_t dir_i, uint32_t table_addr);
+static void          unmap_table(mmu_dir_t * dir, uint32_t table_addr);
+static void          flush_recursive_table(mmu_dir_t * dir, size_t dir_i);
+static void          flush_page(mmu_dir_t * dir, size_t page);
+static int           add_large_page(mmu_dir_t * dir, size_t dir_i);
+static int           split_large_page(mmu_dir_t * dir, size_t dir_i);
+
+static int  temp_find(uint32_t paddr);
+static void temp_hash_remove(int slot);
+static void temp_free_push(int slot);
+static void temp_free_remove(int slot);
 
 void paging_init() {
     kmemset(temp_pages, 0, sizeof(temp_pages));
+
+    for (size_t i = 0; i < TEMP_BUCKET_COUNT; i++) {
+        temp_buckets[i] = TEMP_NONE;
+    }
+
+    temp_free_head  = TEMP_NONE;
+    temp_free_tail  = TEMP_NONE;
+    temp_free_count = 0;
+
+    for (size_t i = 0; i < VADDR_TMP_PAGE_COUNT; i++) {
+        temp_pages[i].hash_next = TEMP_NONE;
+        temp_free_push(i);
+    }
+
+    temp_hits       = 0;
+    temp_misses     = 0;
+    zero_pool_count = 0;
+    large_pages     = 0;
+}
+
+int paging_enable_large_pages() {
+    if (!mmu_pse_supported()) {
+        return -1;
+    }
+
+    mmu_enable_pse();
+    large_pages = 1;
+
+    return 0;
 }
 
 void * paging_temp_map(uint32_t paddr) {
@@ -19,32 +90,52 @@ void * paging_temp_map(uint32_t paddr) {
         return 0;
     }
 
-    // Return one if already exists
-    for (size_t i = 0; i < VADDR_TMP_PAGE_COUNT; i++) {
-        if (temp_pages[i].addr == paddr) {
-            temp_pages[i].count++;
-            size_t table_i = ADDR2PAGE(VADDR_TMP_PAGE) + i;
-            return UINT2PTR(PAGE2ADDR(table_i));
+    int slot = temp_find(paddr);
+
+    // Still mapped, even if the count reached 0
+    if (slot != TEMP_NONE) {
+        if (!temp_pages[slot].count) {
+            temp_free_remove(slot);
         }
+
+        temp_pages[slot].count++;
+        temp_hits++;
+
+        return UINT2PTR(PAGE2ADDR(ADDR2PAGE(VADDR_TMP_PAGE) + slot));
     }
 
-    // Find a free temp page to use
-    for (size_t i = 0; i < VADDR_TMP_PAGE_COUNT; i++) {
-        if (temp_pages[i].count < 1) {
-            temp_pages[i].addr  = paddr;
-            temp_pages[i].count = 1;
+    temp_misses++;
 
-            size_t table_i = ADDR2PAGE(VADDR_TMP_PAGE) + i;
+    // Reuse the least recently freed slot
+    slot = temp_free_head;
 
-            mmu_table_t * table = (mmu_table_t *)VADDR_KERNEL_TABLE;
-            uint32_t      vaddr = PAGE2ADDR(table_i);
-            mmu_table_set(table, table_i, paddr, MMU_TABLE_RW);
-            mmu_flush_tlb(vaddr);
-            return UINT2PTR(vaddr);
-        }
+    if (slot == TEMP_NONE) {
+        return 0;
     }
 
-    return 0;
+    temp_free_remove(slot);
+
+    if (temp_pages[slot].addr) {
+        temp_hash_remove(slot);
+    }
+
+    size_t bucket = TEMP_BUCKET(paddr);
+
+    temp_pages[slot].addr      = paddr;
+    temp_pages[slot].count     = 1;
+    temp_pages[slot].hash_next = temp_buckets[bucket];
+    temp_buckets[bucket]       = slot;
+
+    size_t table_i = ADDR2PAGE(VADDR_TMP_PAGE) + slot;
+
+    // Old translation is only flushed now that the slot is reassigned. Temp
+    // pages are global, so this is the only flush they get.
+    mmu_table_t * table = (mmu_table_t *)VADDR_KERNEL_TABLE;
+    uint32_t      vaddr = PAGE2ADDR(table_i);
+    mmu_table_set(table, table_i, paddr, MMU_TABLE_RW_GLOBAL);
+    mmu_flush_tlb(vaddr);
+
+    return UINT2PTR(vaddr);
 }
 
 void paging_temp_free(uint32_t paddr) {
@@ -52,29 +143,30 @@ void paging_temp_free(uint32_t paddr) {
         return;
     }
 
-    for (size_t i = 0; i < VADDR_TMP_PAGE_COUNT; i++) {
-        if (temp_pages[i].addr == paddr) {
-            if (temp_pages[i].count < 1) {
-                return;
-            }
+    int slot = temp_find(paddr);
+
+    if (slot == TEMP_NONE || temp_pages[slot].count < 1) {
+        return;
+    }
 
-            temp_pages[i].count--;
+    temp_pages[slot].count--;
 
-            break;
-        }
+    // Mapping is kept until the slot is reused
+    if (!temp_pages[slot].count) {
+        temp_free_push(slot);
     }
 }
 
 size_t paging_temp_available() {
-    size_t free = 0;
+    return temp_free_count;
+}
 
-    for (size_t i = 0; i < VADDR_TMP_PAGE_COUNT; i++) {
-        if (!temp_pages[i].count) {
-            free++;
-        }
-    }
+size_t paging_temp_hits() {
+    return temp_hits;
+}
 
-    return free;
+size_t paging_temp_misses() {
+    return temp_misses;
 }
 
 int paging_id_map_range(size_t start, size_t end) {
@@ -93,7 +185,7 @@ int paging_id_map_page(size_t page) {
     }
 
     mmu_table_t * table = (mmu_table_t *)VADDR_KERNEL_TABLE;
-    mmu_table_set(table, page, page << 12, MMU_TABLE_RW);
+    mmu_table_set(table, page, page << 12, MMU_TABLE_RW_GLOBAL);
 
     return 0;
 }
@@ -113,40 +205,109 @@ int paging_add_pages(mmu_dir_t * dir, size_t start, size_t end) {
         return -1;
     }
 
+    uint32_t pages[PAGING_BATCH_SIZE];
+    size_t   page_count = 0;
+    size_t   page_next  = 0;
+
+    // Large pages are zeroed through their own mapping, which needs the
+    // active dir
+    int large = large_pages && dir == UINT2PTR(VADDR_RECURSIVE_DIR);
+
+    // Table of the current run of pages
+    mmu_table_t * table       = 0;
+    uint32_t      table_addr  = 0;
+    uint32_t      table_dir_i = 0;
+
     // Add pages to tables
     for (size_t page_i = start; page_i <= end; page_i++) {
-        uint32_t addr = ram_page_alloc();
+        uint32_t dir_i   = page_i / MMU_TABLE_SIZE;
+        uint32_t table_i = page_i % MMU_TABLE_SIZE;
 
-        if (!addr) {
-            paging_remove_pages(dir, start, page_i - 1);
-            return -1;
+        if (!table || dir_i != table_dir_i) {
+            uint32_t dir_flags = mmu_dir_get_flags(dir, dir_i);
+
+            // Pages of a large page are already present
+            if (dir_flags & MMU_DIR_FLAG_PAGE_SIZE) {
+                page_i = dir_i * MMU_TABLE_SIZE + MMU_TABLE_SIZE - 1;
+                continue;
+            }
+
+            // Whole tables become a single large page when possible
+            if (large && !table_i && end - page_i >= MMU_TABLE_SIZE - 1 && !(dir_flags & MMU_DIR_FLAG_PRESENT)) {
+                if (!add_large_page(dir, dir_i)) {
+                    page_i += MMU_TABLE_SIZE - 1;
+                    continue;
+                }
+            }
         }
 
-        uint32_t dir_i   = page_i / MMU_TABLE_SIZE;
-        uint32_t table_i = page_i % MMU_TABLE_SIZE;
+        // Allocate the next batch of pages
+        if (page_next >= page_count) {
+            page_count = end - page_i + 1;
+            page_next  = 0;
+
+            // Stop before the next whole table, it can become a large page
+            size_t next_table = (dir_i + 1) * MMU_TABLE_SIZE;
+
+            if (large && next_table <= end && end - next_table >= MMU_TABLE_SIZE - 1) {
+                page_count = next_table - page_i;
+            }
 
-        // Add table if needed
-        if (!(mmu_dir_get_flags(dir, dir_i) & MMU_DIR_FLAG_PRESENT)) {
-            if (paging_add_table(dir, dir_i)) {
+            if (page_count > PAGING_BATCH_SIZE) {
+                page_count = PAGING_BATCH_SIZE;
+            }
+
+            if (paging_alloc_zeroed_n(pages, page_count)) {
+                if (table) {
+                    unmap_table(dir, table_addr);
+                }
                 paging_remove_pages(dir, start, page_i - 1);
-                ram_page_free(addr);
                 return -1;
             }
         }
 
-        // Table will be present after previous step
-        uint32_t      table_addr = mmu_dir_get_addr(dir, dir_i);
-        mmu_table_t * table      = paging_temp_map(table_addr);
+        uint32_t addr = pages[page_next];
 
-        if (!table) {
-            paging_remove_pages(dir, start, page_i - 1);
-            paging_temp_free(table_addr);
-            ram_page_free(addr);
-            return -1;
+        // Map each table once for its run of pages
+        if (!table || dir_i != table_dir_i) {
+            if (table) {
+                unmap_table(dir, table_addr);
+                table = 0;
+            }
+
+            // Add table if needed
+            if (!(mmu_dir_get_flags(dir, dir_i) & MMU_DIR_FLAG_PRESENT)) {
+                if (paging_add_table(dir, dir_i)) {
+                    paging_remove_pages(dir, start, page_i - 1);
+                    ram_page_free_n(pages + page_next, page_count - page_next);
+                    return -1;
+                }
+            }
+
+            // Table will be present after previous step
+            table_addr  = mmu_dir_get_addr(dir, dir_i);
+            table       = map_table(dir, dir_i, table_addr);
+            table_dir_i = dir_i;
+
+            if (!table) {
+                paging_remove_pages(dir, start, page_i - 1);
+                ram_page_free_n(pages + page_next, page_count - page_next);
+                return -1;
+            }
         }
 
-        mmu_table_set(table, table_i, addr, MMU_TABLE_RW);
-        paging_temp_free(table_addr);
+        // The kernel table is shared by every dir, so its pages are global
+        mmu_table_set(table, table_i, addr, dir_i ? MMU_TABLE_RW : MMU_TABLE_RW_GLOBAL);
+        page_next++;
+    }
+
+    if (table) {
+        unmap_table(dir, table_addr);
+    }
+
+    // Large pages can leave part of the last batch unused
+    if (page_next < page_count) {
+        ram_page_free_n(pages + page_next, page_count - page_next);
     }
 
     return 0;
@@ -167,38 +328,107 @@ int paging_remove_pages(mmu_dir_t * dir, size_t start, size_t end) {
         return -1;
     }
 
+    uint32_t pages[PAGING_BATCH_SIZE];
+    size_t   page_count = 0;
+    size_t   removed    = 0;
+    int      res        = 0;
+
+    // Large ranges of the active dir reload it once instead of flushing every
+    // page, which is always the case for a large page. Kernel table pages are
+    // global and always flushed one at a time.
+    int reload = dir == UINT2PTR(VADDR_RECURSIVE_DIR) && end - start + 1 > PAGING_FLUSH_MAX_PAGES;
+
+    // Table of the current run of pages
+    mmu_table_t * table       = 0;
+    uint32_t      table_addr  = 0;
+    uint32_t      table_dir_i = 0;
+
     // Remove pages from tables
     for (size_t page_i = start; page_i <= end; page_i++) {
         uint32_t dir_i   = page_i / MMU_TABLE_SIZE;
         uint32_t table_i = page_i % MMU_TABLE_SIZE;
 
-        // Table is not present
-        if (!(mmu_dir_get_flags(dir, dir_i) & MMU_DIR_FLAG_PRESENT)) {
-            continue;
-        }
+        // Map each table once for its run of pages
+        if (!table || dir_i != table_dir_i) {
+            if (table) {
+                unmap_table(dir, table_addr);
+                table = 0;
+            }
 
-        // Table will be present after previous step
-        uint32_t      table_addr = mmu_dir_get_addr(dir, dir_i);
-        mmu_table_t * table      = paging_temp_map(table_addr);
+            uint32_t dir_flags = mmu_dir_get_flags(dir, dir_i);
 
-        if (!table) {
-            return -1;
+            // Table is not present, skip to the next table
+            if (!(dir_flags & MMU_DIR_FLAG_PRESENT)) {
+                page_i = dir_i * MMU_TABLE_SIZE + MMU_TABLE_SIZE - 1;
+                continue;
+            }
+
+            if (dir_flags & MMU_DIR_FLAG_PAGE_SIZE) {
+                // Whole large page is removed at once
+                if (!table_i && end - page_i >= MMU_TABLE_SIZE - 1) {
+                    uint32_t large_addr = mmu_dir_get_addr(dir, dir_i);
+
+                    mmu_dir_set(dir, dir_i, 0, 0);
+                    flush_recursive_table(dir, dir_i);
+                    ram_page_free_range(large_addr, MMU_TABLE_SIZE);
+
+                    removed += MMU_TABLE_SIZE;
+                    page_i += MMU_TABLE_SIZE - 1;
+                    continue;
+                }
+
+                // Part of a large page needs a table
+                if (split_large_page(dir, dir_i)) {
+                    res = -1;
+                    break;
+                }
+            }
+
+            table_addr  = mmu_dir_get_addr(dir, dir_i);
+            table       = map_table(dir, dir_i, table_addr);
+            table_dir_i = dir_i;
+
+            if (!table) {
+                res = -1;
+                break;
+            }
         }
 
         if (!(mmu_table_get_flags(table, table_i) & MMU_TABLE_FLAG_PRESENT)) {
-            paging_temp_free(table_addr);
             continue;
         }
 
         uint32_t page_addr = mmu_table_get_addr(table, table_i);
 
         mmu_table_set(table, table_i, 0, 0);
-        mmu_flush_tlb(PAGE2ADDR(page_i));
-        ram_page_free(page_addr);
-        paging_temp_free(table_addr);
+        removed++;
+
+        // Global pages of the kernel table survive a dir reload
+        if (!reload || !dir_i) {
+            flush_page(dir, page_i);
+        }
+
+        pages[page_count++] = page_addr;
+
+        if (page_count == PAGING_BATCH_SIZE) {
+            ram_page_free_n(pages, page_count);
+            page_count = 0;
+        }
     }
 
-    return 0;
+    if (table) {
+        unmap_table(dir, table_addr);
+    }
+
+    if (reload && removed) {
+        mmu_reload_dir();
+    }
+
+    if (page_count) {
+        ram_page_free_n(pages, page_count);
+    }
+
+    return res;
 }
 
 int paging_add_table(mmu_dir_t * dir, size_t dir_i) {
@@ -207,23 +437,15 @@ int paging_add_table(mmu_dir_t * dir, size_t dir_i) {
     }
 
     if (!(mmu_dir_get_flags(dir, dir_i) & MMU_DIR_FLAG_PRESENT)) {
-        uint32_t addr = ram_page_alloc();
+        // Zeroed page is an empty table
+        uint32_t addr = paging_alloc_zeroed();
 
         if (!addr) {
             return -1;
         }
 
-        mmu_table_t * table = paging_temp_map(addr);
-
-        if (!table) {
-            ram_page_free(addr);
-            return -1;
-        }
-
-        mmu_table_clear(table);
         mmu_dir_set(dir, dir_i, addr, MMU_DIR_RW);
-
-        paging_temp_free(addr);
+        flush_recursive_table(dir, dir_i);
     }
 
     return 0;
@@ -237,8 +459,665 @@ int paging_remove_table(mmu_dir_t * dir, size_t dir_i) {
     if (mmu_dir_get_flags(dir, dir_i) & MMU_DIR_FLAG_PRESENT) {
         uint32_t addr = mmu_dir_get_addr(dir, dir_i);
         mmu_dir_set(dir, dir_i, 0, 0);
+        flush_recursive_table(dir, dir_i);
+        ram_page_free(addr);
+    }
+
+    return 0;
+}
+
+int paging_share_table(mmu_dir_t * src, mmu_dir_t * dst, size_t dir_i, int * changed) {
+    if (!src || !dst || !changed || dir_i >= MMU_DIR_SIZE) {
+        return -1;
+    }
+
+    uint32_t dir_flags = mmu_dir_get_flags(src, dir_i);
+
+    if (!(dir_flags & MMU_DIR_FLAG_PRESENT)) {
+        return 0;
+    }
+
+    // Pages of a large page are shared one at a time
+    if (dir_flags & MMU_DIR_FLAG_PAGE_SIZE) {
+        if (split_large_page(src, dir_i)) {
+            return -1;
+        }
+    }
+
+    uint32_t dst_table_addr = paging_alloc_zeroed();
+
+    if (!dst_table_addr) {
+        return -1;
+    }
+
+    mmu_table_t * dst_table = paging_temp_map(dst_table_addr);
+
+    if (!dst_table) {
+        ram_page_free(dst_table_addr);
+        return -1;
+    }
+
+    uint32_t      src_table_addr = mmu_dir_get_addr(src, dir_i);
+    mmu_table_t * src_table      = map_table(src, dir_i, src_table_addr);
+
+    if (!src_table) {
+        paging_temp_free(dst_table_addr);
+        ram_page_free(dst_table_addr);
+        return -1;
+    }
+
+    int res = 0;
+
+    for (size_t i = 0; i < MMU_TABLE_SIZE; i++) {
+        uint32_t flags = mmu_table_get_flags(src_table, i);
+
+        if (!(flags & MMU_TABLE_FLAG_PRESENT)) {
+            continue;
+        }
+
+        uint32_t addr = mmu_table_get_addr(src_table, i);
+
+        if (ram_frame_ref(addr)) {
+            res = -1;
+            break;
+        }
+
+        if (flags & MMU_TABLE_FLAG_READ_WRITE) {
+            flags = (flags & ~MMU_TABLE_FLAG_READ_WRITE) | MMU_TABLE_FLAG_COW;
+            mmu_table_set(src_table, i, addr, flags);
+            *changed = 1;
+        }
+
+        mmu_table_set(dst_table, i, addr, flags);
+    }
+
+    unmap_table(src, src_table_addr);
+    paging_temp_free(dst_table_addr);
+
+    // Pages shared so far are released with dst
+    mmu_dir_set(dst, dir_i, dst_table_addr, MMU_DIR_RW);
+
+    return res;
+}
+
+int paging_copy_table(mmu_dir_t * src, mmu_dir_t * dst, size_t dir_i) {
+    if (!src || !dst || dir_i >= MMU_DIR_SIZE) {
+        return -1;
+    }
+
+    uint32_t dir_flags = mmu_dir_get_flags(src, dir_i);
+
+    if (!(dir_flags & MMU_DIR_FLAG_PRESENT)) {
+        return 0;
+    }
+
+    if (dir_flags & MMU_DIR_FLAG_PAGE_SIZE) {
+        return -1;
+    }
+
+    if (paging_add_table(dst, dir_i)) {
+        return -1;
+    }
+
+    uint32_t      dst_table_addr = mmu_dir_get_addr(dst, dir_i);
+    mmu_table_t * dst_table      = paging_temp_map(dst_table_addr);
+
+    if (!dst_table) {
+        return -1;
+    }
+
+    uint32_t      src_table_addr = mmu_dir_get_addr(src, dir_i);
+    mmu_table_t * src_table      = map_table(src, dir_i, src_table_addr);
+
+    if (!src_table) {
+        paging_temp_free(dst_table_addr);
+        return -1;
+    }
+
+    int res = 0;
+
+    for (size_t i = 0; i < MMU_TABLE_SIZE; i++) {
+        uint32_t flags = mmu_table_get_flags(src_table, i);
+
+        if (!(flags & MMU_TABLE_FLAG_PRESENT)) {
+            continue;
+        }
+
+        uint32_t src_addr = mmu_table_get_addr(src_table, i);
+        uint32_t dst_addr = mmu_table_get_addr(dst_table, i);
+        int      is_new   = !(mmu_table_get_flags(dst_table, i) & MMU_TABLE_FLAG_PRESENT);
+
+        if (is_new) {
+            dst_addr = ram_page_alloc();
+
+            if (!dst_addr) {
+                res = -1;
+                break;
+            }
+        }
+
+        if (copy_page(dst_addr, src_addr)) {
+            if (is_new) {
+                ram_page_free(dst_addr);
+            }
+            res = -1;
+            break;
+        }
+
+        mmu_table_set(dst_table, i, dst_addr, flags);
+    }
+
+    unmap_table(src, src_table_addr);
+    paging_temp_free(dst_table_addr);
+
+    return res;
+}
+
+int paging_copy_on_write(mmu_dir_t * dir, size_t page) {
+    if (!dir || page >= MMU_DIR_SIZE * MMU_TABLE_SIZE) {
+        return -1;
+    }
+
+    size_t dir_i   = page / MMU_TABLE_SIZE;
+    size_t table_i = page % MMU_TABLE_SIZE;
+
+    uint32_t dir_flags = mmu_dir_get_flags(dir, dir_i);
+
+    if (!(dir_flags & MMU_DIR_FLAG_PRESENT) || dir_flags & MMU_DIR_FLAG_PAGE_SIZE) {
+        return -1;
+    }
+
+    uint32_t      table_addr = mmu_dir_get_addr(dir, dir_i);
+    mmu_table_t * table      = map_table(dir, dir_i, table_addr);
+
+    if (!table) {
+        return -1;
+    }
+
+    uint32_t flags = mmu_table_get_flags(table, table_i);
+
+    if (!(flags & MMU_TABLE_FLAG_PRESENT) || !(flags & MMU_TABLE_FLAG_COW)) {
+        unmap_table(dir, table_addr);
+        return -1;
+    }
+
+    uint32_t addr = mmu_table_get_addr(table, table_i);
+
+    // The last reference keeps the page
+    if (ram_frame_ref_count(addr) > 1) {
+        uint32_t copy = ram_page_alloc();
+
+        if (!copy) {
+            unmap_table(dir, table_addr);
+            return -1;
+        }
+
+        if (copy_page(copy, addr)) {
+            ram_page_free(copy);
+            unmap_table(dir, table_addr);
+            return -1;
+        }
+
+        // Drops this dir's reference to the shared page
         ram_page_free(addr);
+        addr = copy;
+    }
+
+    flags = (flags & ~MMU_TABLE_FLAG_COW) | MMU_TABLE_FLAG_READ_WRITE;
+    mmu_table_set(table, table_i, addr, flags);
+    mmu_flush_tlb(PAGE2ADDR(page));
+
+    unmap_table(dir, table_addr);
+
+    return 0;
+}
+
+int paging_clean_page(mmu_dir_t * dir, size_t page) {
+    if (!dir || page >= MMU_DIR_SIZE * MMU_TABLE_SIZE) {
+        return -1;
+    }
+
+    size_t dir_i   = page / MMU_TABLE_SIZE;
+    size_t table_i = page % MMU_TABLE_SIZE;
+
+    uint32_t dir_flags = mmu_dir_get_flags(dir, dir_i);
+
+    if (!(dir_flags & MMU_DIR_FLAG_PRESENT) || dir_flags & MMU_DIR_FLAG_PAGE_SIZE) {
+        return -1;
+    }
+
+    uint32_t      table_addr = mmu_dir_get_addr(dir, dir_i);
+    mmu_table_t * table      = map_table(dir, dir_i, table_addr);
+
+    if (!table) {
+        return -1;
+    }
+
+    uint32_t flags = mmu_table_get_flags(table, table_i);
+
+    if (!(flags & MMU_TABLE_FLAG_PRESENT)) {
+        unmap_table(dir, table_addr);
+        return -1;
+    }
+
+    mmu_table_set_flags(table, table_i, flags & ~MMU_TABLE_FLAG_DIRTY);
+
+    // A cached translation would let writes skip setting the dirty flag
+    flush_page(dir, page);
+
+    unmap_table(dir, table_addr);
+
+    return 0;
+}
+
+int paging_drop_clean_pages(mmu_dir_t * dir, size_t start, size_t end) {
+    if (!dir) {
+        return -1;
+    }
+
+    if (start > end) {
+        return 0;
     }
 
+    uint32_t table_end = end / MMU_TABLE_SIZE;
+
+    if (table_end >= MMU_DIR_SIZE) {
+        return -1;
+    }
+
+    uint32_t pages[PAGING_BATCH_SIZE];
+    size_t   page_count = 0;
+    int      removed    = 0;
+
+    for (size_t dir_i = start / MMU_TABLE_SIZE; dir_i <= table_end; dir_i++) {
+        uint32_t dir_flags = mmu_dir_get_flags(dir, dir_i);
+
+        if (!(dir_flags & MMU_DIR_FLAG_PRESENT) || dir_flags & MMU_DIR_FLAG_PAGE_SIZE) {
+            continue;
+        }
+
+        uint32_t      table_addr = mmu_dir_get_addr(dir, dir_i);
+        mmu_table_t * table      = map_table(dir, dir_i, table_addr);
+
+        if (!table) {
+            removed = -1;
+            break;
+        }
+
+        size_t first = dir_i == start / MMU_TABLE_SIZE ? start % MMU_TABLE_SIZE : 0;
+        size_t last  = dir_i == table_end ? end % MMU_TABLE_SIZE : MMU_TABLE_SIZE - 1;
+
+        for (size_t table_i = first; table_i <= last; table_i++) {
+            uint32_t flags = mmu_table_get_flags(table, table_i);
+
+            if (!(flags & MMU_TABLE_FLAG_PRESENT) || flags & MMU_TABLE_FLAG_DIRTY) {
+                continue;
+            }
+
+            pages[page_count++] = mmu_table_get_addr(table, table_i);
+
+            mmu_table_set(table, table_i, 0, 0);
+            flush_page(dir, dir_i * MMU_TABLE_SIZE + table_i);
+            removed++;
+
+            if (page_count == PAGING_BATCH_SIZE) {
+                ram_page_free_n(pages, page_count);
+                page_count = 0;
+            }
+        }
+
+        unmap_table(dir, table_addr);
+    }
+
+    if (page_count) {
+        ram_page_free_n(pages, page_count);
+    }
+
+    return removed;
+}
+
+uint32_t paging_alloc_zeroed() {
+    if (zero_pool_count) {
+        return zero_pool[--zero_pool_count];
+    }
+
+    uint32_t addr = ram_page_alloc();
+
+    if (!addr) {
+        return 0;
+    }
+
+    if (zero_page(addr)) {
+        ram_page_free(addr);
+        return 0;
+    }
+
+    return addr;
+}
+
+int paging_alloc_zeroed_n(uint32_t * out, size_t count) {
+    if (!out) {
+        return -1;
+    }
+
+    size_t pooled = count;
+
+    if (pooled > zero_pool_count) {
+        pooled = zero_pool_count;
+    }
+
+    // Pool is only taken from once every page is allocated
+    for (size_t i = 0; i < pooled; i++) {
+        out[i] = zero_pool[zero_pool_count - 1 - i];
+    }
+
+    if (pooled < count) {
+        if (ram_page_alloc_n(out + pooled, count - pooled)) {
+            return -1;
+        }
+
+        for (size_t i = pooled; i < count; i++) {
+            if (zero_page(out[i])) {
+                ram_page_free_n(out + pooled, count - pooled);
+                return -1;
+            }
+        }
+    }
+
+    zero_pool_count -= pooled;
+
+    return 0;
+}
+
+size_t paging_zero_pool_fill(size_t count) {
+    size_t added = 0;
+
+    while (added < count) {
+        // Keep other tasks from using the pool or temp pages part way through
+        disable_interrupts();
+
+        if (zero_pool_count >= PAGING_ZERO_POOL_SIZE) {
+            enable_interrupts();
+            break;
+        }
+
+        uint32_t addr = ram_page_alloc();
+
+        if (!addr) {
+            enable_interrupts();
+            break;
+        }
+
+        if (zero_page(addr)) {
+            ram_page_free(addr);
+            enable_interrupts();
+            break;
+        }
+
+        zero_pool[zero_pool_count++] = addr;
+        enable_interrupts();
+
+        added++;
+    }
+
+    return added;
+}
+
+size_t paging_zero_pool_count() {
+    return zero_pool_count;
+}
+
+static int zero_page(uint32_t addr) {
+    void * page = paging_temp_map(addr);
+
+    if (!page) {
+        return -1;
+    }
+
+    kmemset(page, 0, PAGE_SIZE);
+    paging_temp_free(addr);
+
+    return 0;
+}
+
+/**
+ * @brief Copy the contents of page `src` to page `dst` through temp pages.
+ *
+ * @param dst physical address of the page to write
+ * @param src physical address of the page to read
+ * @return int 0 for success
+ */
+static int copy_page(uint32_t dst, uint32_t src) {
+    void * dst_page = paging_temp_map(dst);
+
+    if (!dst_page) {
+        return -1;
+    }
+
+    void * src_page = paging_temp_map(src);
+
+    if (!src_page) {
+        paging_temp_free(dst);
+        return -1;
+    }
+
+    kmemcpy(dst_page, src_page, PAGE_SIZE);
+
+    paging_temp_free(src);
+    paging_temp_free(dst);
+
+    return 0;
+}
+
+/**
+ * @brief Get a pointer to a table of `dir`.
+ *
+ * Tables of the active directory are reached through the recursive mapping
+ * when `dir` is `VADDR_RECURSIVE_DIR`. Tables of any other directory are
+ * mapped to a temp page and must be released with `unmap_table`.
+ *
+ * @param dir pointer to the page directory
+ * @param dir_i index of the table in the directory
+ * @param table_addr physical address of the table
+ * @return mmu_table_t * pointer to the table or 0 for failure
+ */
+static mmu_table_t * map_table(mmu_dir_t * dir, size_t dir_i, uint32_t table_addr) {
+    if (dir == UINT2PTR(VADDR_RECURSIVE_DIR)) {
+        return UINT2PTR(VADDR_RECURSIVE_TABLES + PAGE2ADDR(dir_i));
+    }
+
+    return paging_temp_map(table_addr);
+}
+
+/**
+ * @brief Release a table from `map_table`.
+ *
+ * @param dir pointer to the page directory
+ * @param table_addr physical address of the table
+ */
+static void unmap_table(mmu_dir_t * dir, uint32_t table_addr) {
+    if (dir != UINT2PTR(VADDR_RECURSIVE_DIR)) {
+        paging_temp_free(table_addr);
+    }
+}
+
+/**
+ * @brief Flush the recursive mapping of a table after its directory entry
+ * changes.
+ *
+ * Only the active directory is mapped recursively, so nothing is flushed for
+ * any other directory.
+ *
+ * @param dir pointer to the page directory
+ * @param dir_i index of the table in the directory
+ */
+static void flush_recursive_table(mmu_dir_t * dir, size_t dir_i) {
+    if (dir == UINT2PTR(VADDR_RECURSIVE_DIR)) {
+        mmu_flush_tlb(VADDR_RECURSIVE_TABLES + PAGE2ADDR(dir_i));
+    }
+}
+
+/**
+ * @brief Flush the translation of `page` after its table entry changes.
+ *
+ * Only the active directory has translations in the TLB, except for the kernel
+ * table which is shared by every directory and is always flushed.
+ *
+ * @param dir pointer to the page directory
+ * @param page page index
+ */
+static void flush_page(mmu_dir_t * dir, size_t page) {
+    if (dir == UINT2PTR(VADDR_RECURSIVE_DIR) || page < MMU_TABLE_SIZE) {
+        mmu_flush_tlb(PAGE2ADDR(page));
+    }
+}
+
+/**
+ * @brief Find the temp page slot mapped to `paddr`.
+ *
+ * @param paddr physical address
+ * @return int slot index or `TEMP_NONE` if `paddr` is not mapped
+ */
+static int temp_find(uint32_t paddr) {
+    int slot = temp_buckets[TEMP_BUCKET(paddr)];
+
+    while (slot != TEMP_NONE) {
+        if (temp_pages[slot].addr == paddr) {
+            return slot;
+        }
+
+        slot = temp_pages[slot].hash_next;
+    }
+
+    return TEMP_NONE;
+}
+
+/**
+ * @brief Remove a temp page slot from the bucket of its address.
+ *
+ * @param slot slot index
+ */
+static void temp_hash_remove(int slot) {
+    int * link = &temp_buckets[TEMP_BUCKET(temp_pages[slot].addr)];
+
+    while (*link != TEMP_NONE) {
+        if (*link == slot) {
+            *link = temp_pages[slot].hash_next;
+            break;
+        }
+
+        link = &temp_pages[*link].hash_next;
+    }
+
+    temp_pages[slot].hash_next = TEMP_NONE;
+}
+
+/**
+ * @brief Add a temp page slot to the end of the free list.
+ *
+ * @param slot slot index
+ */
+static void temp_free_push(int slot) {
+    temp_pages[slot].free_prev = temp_free_tail;
+    temp_pages[slot].free_next = TEMP_NONE;
+
+    if (temp_free_tail != TEMP_NONE) {
+        temp_pages[temp_free_tail].free_next = slot;
+    }
+    else {
+        temp_free_head = slot;
+    }
+
+    temp_free_tail = slot;
+    temp_free_count++;
+}
+
+/**
+ * @brief Remove a temp page slot from the free list.
+ *
+ * @param slot slot index
+ */
+static void temp_free_remove(int slot) {
+    int prev = temp_pages[slot].free_prev;
+    int next = temp_pages[slot].free_next;
+
+    if (prev != TEMP_NONE) {
+        temp_pages[prev].free_next = next;
+    }
+    else {
+        temp_free_head = next;
+    }
+
+    if (next != TEMP_NONE) {
+        temp_pages[next].free_prev = prev;
+    }
+    else {
+        temp_free_tail = prev;
+    }
+
+    temp_pages[slot].free_prev = TEMP_NONE;
+    temp_pages[slot].free_next = TEMP_NONE;
+    temp_free_count--;
+}
+
+/**
+ * @brief Map a 4 MiB large page at a directory entry of the active directory.
+ *
+ * The physical pages are allocated in a row, aligned to 4 MiB, and zeroed in
+ * one pass through the new mapping instead of a temp page for each page.
+ *
+ * @param dir pointer to the active page directory
+ * @param dir_i index of the directory entry
+ * @return int 0 for success
+ */
+static int add_large_page(mmu_dir_t * dir, size_t dir_i) {
+    uint32_t addr = ram_page_alloc_range(MMU_TABLE_SIZE, MMU_LARGE_PAGE_SIZE);
+
+    if (!addr) {
+        return -1;
+    }
+
+    mmu_dir_set(dir, dir_i, addr, MMU_DIR_RW | MMU_DIR_FLAG_PAGE_SIZE);
+    flush_recursive_table(dir, dir_i);
+
+    // Entry was not present, so there are no old translations to flush
+    kmemset(UINT2PTR(PAGE2ADDR(dir_i * MMU_TABLE_SIZE)), 0, MMU_LARGE_PAGE_SIZE);
+
+    return 0;
+}
+
+/**
+ * @brief Replace a large page with a table mapping the same physical pages.
+ *
+ * The pages keep their addresses, so they can be removed one at a time.
+ *
+ * @param dir pointer to the page directory
+ * @param dir_i index of the directory entry
+ * @return int 0 for success
+ */
+static int split_large_page(mmu_dir_t * dir, size_t dir_i) {
+    uint32_t large_addr = mmu_dir_get_addr(dir, dir_i);
+    uint32_t table_addr = paging_alloc_zeroed();
+
+    if (!table_addr) {
+        return -1;
+    }
+
+    mmu_table_t * table = paging_temp_map(table_addr);
+
+    if (!table) {
+        ram_page_free(table_addr);
+        return -1;
+    }
+
+    for (size_t i = 0; i < MMU_TABLE_SIZE; i++) {
+        mmu_table_set(table, i, large_addr + PAGE2ADDR(i), MMU_TABLE_RW);
+    }
+
+    paging_temp_free(table_addr);
+
+    mmu_dir_set(dir, dir_i, table_addr, MMU_DIR_RW);
+    flush_recursive_table(dir, dir_i);
+
     return 0;
 }
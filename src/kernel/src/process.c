@@ -8,7 +8,12 @@
 #include "paging.h"
 #include "ram.h"
 
-static uint32_t next_pid();
+static uint32_t    next_pid();
+static mmu_dir_t * map_dir(process_t * proc);
+static void        unmap_dir(process_t * proc);
+static int         reserve(process_t * proc, uint32_t start, size_t count);
+static int         unreserve(process_t * proc, uint32_t start, size_t count);
+static int         load_file_page(process_t * proc, process_file_map_t * map, uint32_t page);
 
 int process_create(process_t * proc) {
     if (!proc) {
@@ -34,7 +39,7 @@ int process_create(process_t * proc) {
         return -1;
     }
 
-    if (memory_init(&proc->memory, _sys_page_alloc)) {
+    if (memory_init(&proc->memory, _sys_page_alloc, _sys_page_free)) {
         ebus_free(&proc->event_queue);
         arr_free(&proc->io_handles);
         ram_page_free(proc->cr3);
@@ -51,11 +56,14 @@ int process_create(process_t * proc) {
         return -1;
     }
 
-    uint32_t kernel_table_addr = mmu_dir_get_addr((mmu_dir_t *)VADDR_KERNEL_DIR, 0);
+    uint32_t kernel_table_addr   = mmu_dir_get_addr((mmu_dir_t *)VADDR_KERNEL_DIR, 0);
+    uint32_t frame_db_table_addr = mmu_dir_get_addr((mmu_dir_t *)VADDR_KERNEL_DIR, FRAME_DB_DIR_INDEX);
 
-    // Copy first page table from kernel page directory
+    // Copy first page table and frame database table from kernel page directory
     mmu_dir_clear(dir);
     mmu_dir_set(dir, 0, kernel_table_addr, MMU_DIR_RW);
+    mmu_dir_set(dir, FRAME_DB_DIR_INDEX, frame_db_table_addr, MMU_DIR_RW);
+    mmu_dir_set(dir, RECURSIVE_DIR_INDEX, proc->cr3, MMU_DIR_RW);
 
     proc->esp  = VADDR_USER_STACK;
     proc->esp0 = VADDR_ISR_STACK;
@@ -73,6 +81,10 @@ int process_create(process_t * proc) {
     proc->next_heap_page   = ADDR2PAGE(VADDR_USER_MEM);
     proc->stack_page_count = 1;
 
+    // Rest of the user stack is added on first touch
+    uint32_t stack_start = (RECURSIVE_DIR_INDEX + 1) * MMU_TABLE_SIZE;
+    reserve(proc, stack_start, ADDR2PAGE(proc->esp) - stack_start);
+
     paging_temp_free(proc->cr3);
 
     return 0;
@@ -92,9 +104,30 @@ int process_free(process_t * proc) {
         return -1;
     }
 
+    uint32_t pages[PAGING_BATCH_SIZE];
+    size_t   page_count = 0;
+
     // Free tables, skip first (kernel)
     for (size_t i = 1; i < MMU_DIR_SIZE; i++) {
-        if (!(mmu_dir_get_flags(dir, i) & MMU_DIR_FLAG_PRESENT)) {
+        // Recursive entry is the dir, which is freed last
+        if (i == RECURSIVE_DIR_INDEX) {
+            continue;
+        }
+
+        // Frame database is shared by every dir
+        if (i == FRAME_DB_DIR_INDEX) {
+            continue;
+        }
+
+        uint32_t dir_flags = mmu_dir_get_flags(dir, i);
+
+        if (!(dir_flags & MMU_DIR_FLAG_PRESENT)) {
+            continue;
+        }
+
+        // Large pages are freed whole
+        if (dir_flags & MMU_DIR_FLAG_PAGE_SIZE) {
+            ram_page_free_range(mmu_dir_get_addr(dir, i), MMU_TABLE_SIZE);
             continue;
         }
 
@@ -102,26 +135,104 @@ int process_free(process_t * proc) {
         mmu_table_t * table      = paging_temp_map(table_addr);
 
         if (!table) {
+            pages[page_count++] = proc->cr3;
             paging_temp_free(proc->cr3);
-            ram_page_free(proc->cr3);
+            ram_page_free_n(pages, page_count);
             return -1;
         }
 
         // Free pages
         for (size_t j = 0; j < MMU_TABLE_SIZE; j++) {
             if (mmu_table_get_flags(table, j) & MMU_TABLE_FLAG_PRESENT) {
-                uint32_t page_addr = mmu_table_get_addr(table, j);
-                ram_page_free(page_addr);
+                pages[page_count++] = mmu_table_get_addr(table, j);
+
+                if (page_count == PAGING_BATCH_SIZE) {
+                    ram_page_free_n(pages, page_count);
+                    page_count = 0;
+                }
             }
         }
 
         paging_temp_free(table_addr);
-        ram_page_free(table_addr);
+
+        pages[page_count++] = table_addr;
+
+        if (page_count == PAGING_BATCH_SIZE) {
+            ram_page_free_n(pages, page_count);
+            page_count = 0;
+        }
     }
 
     // Free dir
     paging_temp_free(proc->cr3);
-    ram_page_free(proc->cr3);
+
+    pages[page_count++] = proc->cr3;
+    ram_page_free_n(pages, page_count);
+
+    return 0;
+}
+
+int process_fork(process_t * proc, process_t * child, uint32_t esp) {
+    if (!proc || !child) {
+        return -1;
+    }
+
+    if (process_create(child)) {
+        return -1;
+    }
+
+    mmu_dir_t * dir = map_dir(proc);
+
+    if (!dir) {
+        process_free(child);
+        return -1;
+    }
+
+    mmu_dir_t * child_dir = paging_temp_map(child->cr3);
+
+    if (!child_dir) {
+        unmap_dir(proc);
+        process_free(child);
+        return -1;
+    }
+
+    int res     = 0;
+    int changed = 0;
+
+    // Heap is shared, skip first (kernel), stop at the frame database
+    for (size_t i = 1; i < FRAME_DB_DIR_INDEX && !res; i++) {
+        res = paging_share_table(dir, child_dir, i, &changed);
+    }
+
+    // Writable translations of the parent must not be used again, one reload
+    // covers every shared table
+    if (changed && dir == UINT2PTR(VADDR_RECURSIVE_DIR)) {
+        mmu_reload_dir();
+    }
+
+    // Stacks are copied
+    if (!res) {
+        res = paging_copy_table(dir, child_dir, MMU_DIR_SIZE - 1);
+    }
+
+    paging_temp_free(child->cr3);
+    unmap_dir(proc);
+
+    if (res) {
+        process_free(child);
+        return -1;
+    }
+
+    child->esp              = esp;
+    child->esp0             = proc->esp0;
+    child->next_heap_page   = proc->next_heap_page;
+    child->stack_page_count = proc->stack_page_count;
+    child->signals_callback = proc->signals_callback;
+    child->memory           = proc->memory;
+    child->state            = PROCESS_STATE_LOADED;
+
+    kmemcpy(child->reserved, proc->reserved, sizeof(child->reserved));
+    kmemcpy(child->file_maps, proc->file_maps, sizeof(child->file_maps));
 
     return 0;
 }
@@ -196,22 +307,23 @@ void * process_add_pages(process_t * proc, size_t count) {
         return 0;
     }
 
-    if (proc->next_heap_page + count >= MMU_DIR_SIZE * MMU_TABLE_SIZE) {
+    // Heap stops at the frame database
+    if (proc->next_heap_page + count > FRAME_DB_DIR_INDEX * MMU_TABLE_SIZE) {
         return 0;
     }
 
-    mmu_dir_t * dir = paging_temp_map(proc->cr3);
+    mmu_dir_t * dir = map_dir(proc);
 
     if (!dir) {
         return 0;
     }
 
-    if (paging_add_pages(dir, proc->next_heap_page, proc->next_heap_page + count)) {
-        paging_temp_free(proc->cr3);
+    if (paging_add_pages(dir, proc->next_heap_page, proc->next_heap_page + count - 1)) {
+        unmap_dir(proc);
         return 0;
     }
 
-    paging_temp_free(proc->cr3);
+    unmap_dir(proc);
 
     void * ptr = UINT2PTR(PAGE2ADDR(proc->next_heap_page));
     proc->next_heap_page += count;
@@ -219,27 +331,250 @@ void * process_add_pages(process_t * proc, size_t count) {
     return ptr;
 }
 
-int process_grow_stack(process_t * proc) {
+void * process_reserve_pages(process_t * proc, size_t count) {
+    if (!proc || !count) {
+        return 0;
+    }
+
+    // Heap stops at the frame database
+    if (proc->next_heap_page + count > FRAME_DB_DIR_INDEX * MMU_TABLE_SIZE) {
+        return 0;
+    }
+
+    if (reserve(proc, proc->next_heap_page, count)) {
+        return 0;
+    }
+
+    void * ptr = UINT2PTR(PAGE2ADDR(proc->next_heap_page));
+    proc->next_heap_page += count;
+
+    return ptr;
+}
+
+int process_remove_pages(process_t * proc, void * addr, size_t count) {
+    if (!proc || !count) {
+        return -1;
+    }
+
+    uint32_t vaddr = PTR2UINT(addr);
+
+    if (vaddr & 0xfff) {
+        return -1;
+    }
+
+    size_t start = ADDR2PAGE(vaddr);
+
+    if (start < ADDR2PAGE(VADDR_USER_MEM) || start + count > proc->next_heap_page) {
+        return -1;
+    }
+
+    if (unreserve(proc, start, count)) {
+        return -1;
+    }
+
+    mmu_dir_t * dir = map_dir(proc);
+
+    if (!dir) {
+        return -1;
+    }
+
+    if (paging_remove_pages(dir, start, start + count - 1)) {
+        unmap_dir(proc);
+        return -1;
+    }
+
+    unmap_dir(proc);
+
+    if (start + count == proc->next_heap_page) {
+        proc->next_heap_page = start;
+    }
+
+    return 0;
+}
+
+void * process_map_file(process_t * proc, tar_fs_t * tar, size_t file_i) {
+    if (!proc || !tar) {
+        return 0;
+    }
+
+    size_t count = ADDR2PAGE(PAGE_ALIGNED(tar_file_size(tar, file_i)));
+
+    if (!count) {
+        return 0;
+    }
+
+    // Heap stops at the frame database
+    if (proc->next_heap_page + count > FRAME_DB_DIR_INDEX * MMU_TABLE_SIZE) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < PROCESS_FILE_MAP_MAX; i++) {
+        process_file_map_t * map = &proc->file_maps[i];
+
+        if (map->count) {
+            continue;
+        }
+
+        map->start  = proc->next_heap_page;
+        map->count  = count;
+        map->tar    = tar;
+        map->file_i = file_i;
+
+        proc->next_heap_page += count;
+
+        return UINT2PTR(PAGE2ADDR(map->start));
+    }
+
+    return 0;
+}
+
+int process_unmap_file(process_t * proc, void * addr) {
     if (!proc) {
         return -1;
     }
 
-    mmu_dir_t * dir = paging_temp_map(proc->cr3);
+    uint32_t             page = ADDR2PAGE(PTR2UINT(addr));
+    process_file_map_t * map  = 0;
+
+    for (size_t i = 0; i < PROCESS_FILE_MAP_MAX; i++) {
+        if (proc->file_maps[i].count && proc->file_maps[i].start == page) {
+            map = &proc->file_maps[i];
+            break;
+        }
+    }
+
+    if (!map) {
+        return -1;
+    }
+
+    mmu_dir_t * dir = map_dir(proc);
+
+    if (!dir) {
+        return -1;
+    }
+
+    if (paging_remove_pages(dir, map->start, map->start + map->count - 1)) {
+        unmap_dir(proc);
+        return -1;
+    }
+
+    unmap_dir(proc);
+
+    if (map->start + map->count == proc->next_heap_page) {
+        proc->next_heap_page = map->start;
+    }
+
+    kmemset(map, 0, sizeof(process_file_map_t));
+
+    return 0;
+}
+
+int process_drop_file_pages(process_t * proc) {
+    if (!proc) {
+        return -1;
+    }
+
+    mmu_dir_t * dir = map_dir(proc);
 
     if (!dir) {
         return -1;
     }
 
+    int dropped = 0;
+
+    for (size_t i = 0; i < PROCESS_FILE_MAP_MAX; i++) {
+        process_file_map_t * map = &proc->file_maps[i];
+
+        if (!map->count) {
+            continue;
+        }
+
+        int res = paging_drop_clean_pages(dir, map->start, map->start + map->count - 1);
+
+        if (res < 0) {
+            dropped = -1;
+            break;
+        }
+
+        dropped += res;
+    }
+
+    unmap_dir(proc);
+
+    return dropped;
+}
+
+int process_page_fault(process_t * proc, uint32_t vaddr) {
+    if (!proc) {
+        return -1;
+    }
+
+    uint32_t page     = ADDR2PAGE(vaddr);
+    int      reserved = 0;
+
+    for (size_t i = 0; i < PROCESS_FILE_MAP_MAX; i++) {
+        process_file_map_t * map = &proc->file_maps[i];
+
+        if (page >= map->start && page - map->start < map->count) {
+            return load_file_page(proc, map, page);
+        }
+    }
+
+    for (size_t i = 0; i < PROCESS_RESERVED_MAX; i++) {
+        process_range_t * range = &proc->reserved[i];
+
+        if (page >= range->start && page - range->start < range->count) {
+            reserved = 1;
+            break;
+        }
+    }
+
+    if (!reserved) {
+        return -1;
+    }
+
+    mmu_dir_t * dir = map_dir(proc);
+
+    if (!dir) {
+        return -1;
+    }
+
+    if (paging_add_pages(dir, page, page)) {
+        unmap_dir(proc);
+        return -1;
+    }
+
+    unmap_dir(proc);
+
+    return 0;
+}
+
+int process_grow_stack(process_t * proc) {
+    if (!proc) {
+        return -1;
+    }
+
     size_t new_stack_page_i = MMU_DIR_SIZE * MMU_TABLE_SIZE - proc->stack_page_count - 1;
 
+    // Stack stops at the recursive mapping
+    if (new_stack_page_i < (RECURSIVE_DIR_INDEX + 1) * MMU_TABLE_SIZE) {
+        return -1;
+    }
+
+    mmu_dir_t * dir = map_dir(proc);
+
+    if (!dir) {
+        return -1;
+    }
+
     if (paging_add_pages(dir, new_stack_page_i, new_stack_page_i)) {
-        paging_temp_free(proc->cr3);
+        unmap_dir(proc);
         return -1;
     }
 
     proc->stack_page_count--;
 
-    paging_temp_free(proc->cr3);
+    unmap_dir(proc);
 
     return 0;
 }
@@ -270,19 +605,33 @@ int process_load_heap(process_t * proc, const char * buff, size_t size) {
     }
 
     for (size_t i = 0; i < page_count; i++) {
-        uint32_t      table_addr = mmu_dir_get_addr(dir, (heap_start + i) / MMU_TABLE_SIZE);
-        mmu_table_t * table      = paging_temp_map(table_addr);
+        uint32_t dir_i      = (heap_start + i) / MMU_TABLE_SIZE;
+        uint32_t table_i    = (heap_start + i) % MMU_TABLE_SIZE;
+        uint32_t table_addr = mmu_dir_get_addr(dir, dir_i);
+        int      large      = mmu_dir_get_flags(dir, dir_i) & MMU_DIR_FLAG_PAGE_SIZE;
+        uint32_t addr;
+
+        // Large pages are contiguous, no table to look up
+        if (large) {
+            addr = table_addr + PAGE2ADDR(table_i);
+        }
+        else {
+            mmu_table_t * table = paging_temp_map(table_addr);
 
-        if (!table) {
-            paging_temp_free(proc->cr3);
-            return -1;
+            if (!table) {
+                paging_temp_free(proc->cr3);
+                return -1;
+            }
+
+            addr = mmu_table_get_addr(table, table_i);
         }
 
-        uint32_t addr     = mmu_table_get_addr(table, (heap_start + i) % MMU_TABLE_SIZE);
-        void *   tmp_page = paging_temp_map(addr);
+        void * tmp_page = paging_temp_map(addr);
 
         if (!tmp_page) {
-            paging_temp_free(table_addr);
+            if (!large) {
+                paging_temp_free(table_addr);
+            }
             paging_temp_free(proc->cr3);
             return -1;
         }
@@ -296,7 +645,9 @@ int process_load_heap(process_t * proc, const char * buff, size_t size) {
         kmemcpy(tmp_page, &buff[i * PAGE_SIZE], to_copy);
 
         paging_temp_free(addr);
-        paging_temp_free(table_addr);
+        if (!large) {
+            paging_temp_free(table_addr);
+        }
     }
 
     paging_temp_free(proc->cr3);
@@ -322,3 +673,162 @@ void set_next_pid(uint32_t next) {
     next_pid(); // Force pid_set to true so it doesn't override this value
     __pid = next;
 }
+
+/**
+ * @brief Get a pointer to the page directory of a process.
+ *
+ * The directory of the active process is reached through the recursive
+ * mapping, any other directory is mapped to a temp page.
+ *
+ * @param proc pointer to the process
+ * @return mmu_dir_t * pointer to the directory or 0 for failure
+ */
+static mmu_dir_t * map_dir(process_t * proc) {
+    if (proc->cr3 && proc->cr3 == mmu_get_curr_dir()) {
+        return UINT2PTR(VADDR_RECURSIVE_DIR);
+    }
+
+    return paging_temp_map(proc->cr3);
+}
+
+/**
+ * @brief Release a directory from `map_dir`.
+ *
+ * @param proc pointer to the process
+ */
+static void unmap_dir(process_t * proc) {
+    if (!proc->cr3 || proc->cr3 != mmu_get_curr_dir()) {
+        paging_temp_free(proc->cr3);
+    }
+}
+
+/**
+ * @brief Add a range of reserved pages to the process.
+ *
+ * A range that starts right after an existing range extends it.
+ *
+ * @param proc pointer to the process object
+ * @param start first page to reserve
+ * @param count number of pages to reserve
+ * @return int 0 for success
+ */
+static int reserve(process_t * proc, uint32_t start, size_t count) {
+    process_range_t * free_range = 0;
+
+    for (size_t i = 0; i < PROCESS_RESERVED_MAX; i++) {
+        process_range_t * range = &proc->reserved[i];
+
+        if (!range->count) {
+            if (!free_range) {
+                free_range = range;
+            }
+            continue;
+        }
+
+        if (range->start + range->count == start) {
+            range->count += count;
+            return 0;
+        }
+    }
+
+    if (!free_range) {
+        return -1;
+    }
+
+    free_range->start = start;
+    free_range->count = count;
+
+    return 0;
+}
+
+/**
+ * @brief Remove pages from the reserved ranges of the process.
+ *
+ * A range with pages on both sides of the removed pages is split in two.
+ *
+ * @param proc pointer to the process object
+ * @param start first page to remove
+ * @param count number of pages to remove
+ * @return int 0 for success, -1 if there is no range left for a split
+ */
+static int unreserve(process_t * proc, uint32_t start, size_t count) {
+    uint32_t end = start + count;
+
+    for (size_t i = 0; i < PROCESS_RESERVED_MAX; i++) {
+        process_range_t * range     = &proc->reserved[i];
+        uint32_t          range_end = range->start + range->count;
+
+        if (!range->count || range_end <= start || range->start >= end) {
+            continue;
+        }
+
+        if (range->start < start && range_end > end) {
+            process_range_t * tail = 0;
+
+            for (size_t j = 0; j < PROCESS_RESERVED_MAX; j++) {
+                if (!proc->reserved[j].count) {
+                    tail = &proc->reserved[j];
+                    break;
+                }
+            }
+
+            if (!tail) {
+                return -1;
+            }
+
+            tail->start  = end;
+            tail->count  = range_end - end;
+            range->count = start - range->start;
+        }
+        else if (range->start < start) {
+            range->count = start - range->start;
+        }
+        else if (range_end > end) {
+            range->count = range_end - end;
+            range->start = end;
+        }
+        else {
+            range->count = 0;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Add a page of a mapped file and read its contents from the file.
+ *
+ * The page is written through its user address, so `proc` must be the active
+ * process. It is left clean so `process_drop_file_pages` can free it until it
+ * is written.
+ *
+ * @param proc pointer to the process
+ * @param map file map holding `page`
+ * @param page page index
+ * @return int 0 for success
+ */
+static int load_file_page(process_t * proc, process_file_map_t * map, uint32_t page) {
+    if (!proc->cr3 || proc->cr3 != mmu_get_curr_dir()) {
+        return -1;
+    }
+
+    mmu_dir_t * dir = UINT2PTR(VADDR_RECURSIVE_DIR);
+
+    tar_fs_file_t * file = tar_file_open_i(map->tar, map->file_i);
+
+    if (!file) {
+        return -1;
+    }
+
+    if (paging_add_pages(dir, page, page)) {
+        tar_file_close(file);
+        return -1;
+    }
+
+    // Bytes past the end of the file stay zero
+    tar_file_seek(file, PAGE2ADDR(page - map->start), TAR_SEEK_ORIGIN_START);
+    tar_file_read(file, UINT2PTR(PAGE2ADDR(page)), PAGE_SIZE);
+    tar_file_close(file);
+
+    return paging_clean_page(dir, page);
+}
@@ -6,15 +6,36 @@
 #define REGION_MAX_PAGE_COUNT 0x8000
 #define REGION_MAX_SIZE       (REGION_MAX_PAGE_COUNT * PAGE_SIZE)
 
+// Regions hold 32 bit addresses, memory past this can't be mapped
+#define REGION_ADDR_LIMIT 0x100000000ull
+
 #define REGION_TABLE_FLAG_PRESENT 0x1
 #define BITMASK_PAGE_FREE         0x1
 
+// Bitmask word where the next search for a free page starts, kept in the
+// unused flag bits of the region address
+#define REGION_TABLE_NEXT_FREE_SHIFT 1
+#define REGION_TABLE_NEXT_FREE_MASK  0x7fe
+#define REGION_NEXT_FREE(ENTRY)      (((ENTRY)->addr_flags & REGION_TABLE_NEXT_FREE_MASK) >> REGION_TABLE_NEXT_FREE_SHIFT)
+
+#define BITMASK_WORD_BITS 32
+
 static ram_table_t * __region_table;
 static size_t        __region_table_count;
 static void *        __bitmask;
+static ram_frame_t * __frames;
+
+// Index in the frame database of the first page of each region
+static uint32_t __frame_base[REGION_TABLE_SIZE];
 
 static int  find_addr_entry(uint32_t addr, size_t * out_bit_i);
-static int  find_free_bit(const void * bitmask, size_t page_count);
+static int  find_free_bit(const void * bitmask, ram_table_entry_t * entry);
+static void set_next_free(ram_table_entry_t * entry, size_t word);
+static int  take_free_bits(void * bitmask, ram_table_entry_t * entry, uint32_t * out, size_t count);
+static int  find_free_run(const void * bitmask, ram_table_entry_t * entry, size_t count, size_t align);
+static int  find_used_bit(const void * bitmask, size_t start, size_t count);
+static int  find_free_bit_in(const void * bitmask, size_t start, size_t count);
+static void set_bits(void * bitmask, size_t start, size_t count, int free);
 static int  find_free_region();
 static void set_bit_used(void * bitmask, size_t bit);
 static void set_bit_free(void * bitmask, size_t bit);
@@ -22,6 +43,10 @@ static int  is_bit_free(void * bitmask, size_t bit);
 static void fill_bitmask(void * bitmask, size_t page_count);
 static void add_memory_at(size_t start, uint64_t base, uint64_t length);
 
+static ram_frame_t * get_frame(uint32_t addr);
+static void          frame_take(const ram_table_entry_t * entry, size_t bit);
+static int           frame_release(const ram_table_entry_t * entry, size_t bit);
+
 int ram_init(ram_table_t * ram_table, void * bitmasks) {
     if (!ram_table || !bitmasks) {
         return -1;
@@ -30,6 +55,7 @@ int ram_init(ram_table_t * ram_table, void * bitmasks) {
     __region_table       = ram_table;
     __region_table_count = 0;
     __bitmask            = bitmasks;
+    __frames             = 0;
 
     kmemset(__region_table, 0, sizeof(ram_table_t));
 
@@ -45,6 +71,15 @@ int ram_region_add_memory(uint64_t base, uint64_t length) {
         return -1;
     }
 
+    if (base >= REGION_ADDR_LIMIT) {
+        return -1;
+    }
+
+    // Keep the part below 4 GiB
+    if (length > REGION_ADDR_LIMIT - base) {
+        length = REGION_ADDR_LIMIT - base;
+    }
+
     size_t split_count = length / REGION_MAX_SIZE;
 
     if (__region_table_count + split_count >= REGION_TABLE_SIZE) {
@@ -115,7 +150,7 @@ uint32_t ram_page_alloc() {
     ram_table_entry_t * entry = &__region_table->entries[region_i];
     // In virtual address space
     void * bitmask = __bitmask + PAGE_SIZE * region_i;
-    int    bit_i   = find_free_bit(bitmask, entry->page_count);
+    int    bit_i   = find_free_bit(bitmask, entry);
 
     if (bit_i < 0) {
         return 0;
@@ -123,6 +158,7 @@ uint32_t ram_page_alloc() {
 
     set_bit_used(bitmask, bit_i);
     entry->free_count--;
+    frame_take(entry, bit_i);
 
     return (entry->addr_flags & MASK_ADDR) + PAGE_SIZE * bit_i;
 }
@@ -141,7 +177,7 @@ uint32_t ram_page_palloc() {
     ram_table_entry_t * entry = &__region_table->entries[region_i];
     // In physical address space
     void * bitmask = (void *)(entry->addr_flags & MASK_ADDR);
-    int    bit_i   = find_free_bit(bitmask, entry->page_count);
+    int    bit_i   = find_free_bit(bitmask, entry);
 
     if (bit_i < 0) {
         return 0;
@@ -157,7 +193,8 @@ int ram_page_free(uint32_t addr) {
     size_t bit_i    = 0;
     int    region_i = find_addr_entry(addr, &bit_i);
 
-    if (region_i < 0) {
+    // Bitmask page is never allocated
+    if (region_i < 0 || !bit_i) {
         return -1;
     }
 
@@ -169,37 +206,486 @@ int ram_page_free(uint32_t addr) {
         return -1;
     }
 
+    // Page is still referenced
+    if (frame_release(entry, bit_i)) {
+        return 0;
+    }
+
     set_bit_free(bitmask, bit_i);
     entry->free_count++;
 
     return 0;
 }
 
-static int find_addr_entry(uint32_t addr, size_t * out_bit_i) {
+int ram_page_alloc_n(uint32_t * out, size_t count) {
+    if (!out) {
+        return -1;
+    }
+
+    // Nothing is allocated unless every page can be
+    if (ram_free_pages() < count) {
+        return -1;
+    }
+
+    size_t found = 0;
+
+    for (size_t i = 0; i < __region_table_count && found < count; i++) {
+        ram_table_entry_t * entry = &__region_table->entries[i];
+
+        if (!entry->free_count) {
+            continue;
+        }
+
+        // In virtual address space
+        void * bitmask = __bitmask + PAGE_SIZE * i;
+
+        found += take_free_bits(bitmask, entry, out + found, count - found);
+    }
+
+    return 0;
+}
+
+int ram_page_free_n(const uint32_t * addrs, size_t count) {
+    if (!addrs) {
+        return -1;
+    }
+
+    int                 res          = 0;
+    int                 region_i     = -1;
+    ram_table_entry_t * entry        = 0;
+    uint32_t            region_start = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t addr = addrs[i];
+
+        // Pages are usually freed in runs from the same region
+        if (!entry || addr < region_start || (addr - region_start) / PAGE_SIZE >= entry->page_count) {
+            size_t bit_i = 0;
+            region_i     = find_addr_entry(addr, &bit_i);
+
+            if (region_i < 0) {
+                entry = 0;
+                res   = -1;
+                continue;
+            }
+
+            entry        = &__region_table->entries[region_i];
+            region_start = entry->addr_flags & MASK_ADDR;
+        }
+
+        size_t bit_i = (addr - region_start) / PAGE_SIZE;
+        // In virtual address space
+        void * bitmask = __bitmask + PAGE_SIZE * region_i;
+
+        if (!bit_i || is_bit_free(bitmask, bit_i)) {
+            res = -1;
+            continue;
+        }
+
+        // Page is still referenced
+        if (frame_release(entry, bit_i)) {
+            continue;
+        }
+
+        set_bit_free(bitmask, bit_i);
+        entry->free_count++;
+    }
+
+    return res;
+}
+
+uint32_t ram_page_alloc_range(size_t count, size_t align) {
+    if (!count || !align || align & (align - 1)) {
+        return 0;
+    }
+
+    if (align < PAGE_SIZE) {
+        align = PAGE_SIZE;
+    }
+
     for (size_t i = 0; i < __region_table_count; i++) {
         ram_table_entry_t * entry = &__region_table->entries[i];
 
-        uint32_t region_start = entry->addr_flags & MASK_ADDR;
-        uint32_t region_end   = region_start + entry->page_count * PAGE_SIZE;
+        if (entry->free_count < count) {
+            continue;
+        }
 
-        if (addr >= region_start && addr <= region_end) {
-            *out_bit_i = (addr - region_start) / PAGE_SIZE;
+        // In virtual address space
+        void * bitmask = __bitmask + PAGE_SIZE * i;
+        int    bit_i   = find_free_run(bitmask, entry, count, align);
 
-            return i;
+        if (bit_i < 0) {
+            continue;
+        }
+
+        set_bits(bitmask, bit_i, count, 0);
+        entry->free_count -= count;
+
+        for (size_t page = 0; page < count; page++) {
+            frame_take(entry, bit_i + page);
         }
+
+        return (entry->addr_flags & MASK_ADDR) + PAGE_SIZE * bit_i;
+    }
+
+    return 0;
+}
+
+int ram_page_free_range(uint32_t addr, size_t count) {
+    if (!count || addr & ~MASK_ADDR) {
+        return -1;
+    }
+
+    size_t bit_i    = 0;
+    int    region_i = find_addr_entry(addr, &bit_i);
+
+    if (region_i < 0) {
+        return -1;
+    }
+
+    ram_table_entry_t * entry = &__region_table->entries[region_i];
+
+    // Bitmask page is never free and the range must not leave the region
+    if (!bit_i || bit_i + count > entry->page_count) {
+        return -1;
+    }
+
+    // In virtual address space
+    void * bitmask = __bitmask + PAGE_SIZE * region_i;
+
+    // Nothing changes if any page is already free
+    if (find_free_bit_in(bitmask, bit_i, count) >= 0) {
+        return -1;
+    }
+
+    if (!__frames) {
+        set_bits(bitmask, bit_i, count, 1);
+        entry->free_count += count;
+
+        return 0;
+    }
+
+    for (size_t page = bit_i; page < bit_i + count; page++) {
+        // Page is still referenced
+        if (frame_release(entry, page)) {
+            continue;
+        }
+
+        set_bit_free(bitmask, page);
+        entry->free_count++;
+    }
+
+    return 0;
+}
+
+size_t ram_frame_db_size() {
+    return ram_max_pages() * sizeof(ram_frame_t);
+}
+
+int ram_frame_db_init(ram_frame_t * frames) {
+    if (!frames) {
+        return -1;
+    }
+
+    uint32_t base = 0;
+
+    for (size_t i = 0; i < __region_table_count; i++) {
+        ram_table_entry_t * entry = &__region_table->entries[i];
+        // In virtual address space
+        void * bitmask = __bitmask + PAGE_SIZE * i;
+
+        __frame_base[i] = base;
+
+        for (size_t bit = 0; bit < entry->page_count; bit++) {
+            if (is_bit_free(bitmask, bit)) {
+                frames[base + bit] = 0;
+            }
+            else {
+                frames[base + bit] = RAM_FRAME_FLAG_KERNEL | 1;
+            }
+        }
+
+        base += entry->page_count;
+    }
+
+    __frames = frames;
+
+    return 0;
+}
+
+int ram_frame_ref(uint32_t addr) {
+    ram_frame_t * frame = get_frame(addr);
+
+    if (!frame || !(*frame & RAM_FRAME_REF_MASK)) {
+        return -1;
+    }
+
+    if ((*frame & RAM_FRAME_REF_MASK) == RAM_FRAME_REF_MASK) {
+        return -1;
+    }
+
+    (*frame)++;
+
+    return 0;
+}
+
+int ram_frame_ref_count(uint32_t addr) {
+    ram_frame_t * frame = get_frame(addr);
+
+    if (!frame) {
+        return -1;
+    }
+
+    return *frame & RAM_FRAME_REF_MASK;
+}
+
+int ram_frame_set_flags(uint32_t addr, uint16_t flags) {
+    ram_frame_t * frame = get_frame(addr);
+
+    if (!frame || !(*frame & RAM_FRAME_REF_MASK)) {
+        return -1;
+    }
+
+    *frame = (*frame & RAM_FRAME_REF_MASK) | (flags & RAM_FRAME_FLAG_MASK);
+
+    return 0;
+}
+
+int ram_frame_get_flags(uint32_t addr) {
+    ram_frame_t * frame = get_frame(addr);
+
+    if (!frame) {
+        return -1;
+    }
+
+    return *frame & RAM_FRAME_FLAG_MASK;
+}
+
+/**
+ * @brief Find the region containing a physical address.
+ *
+ * The region table is kept sorted by address, so this is a binary search for
+ * the last region starting at or before `addr`.
+ *
+ * @param addr physical address
+ * @param out_bit_i output of the page index within the region
+ * @return int region index or -1 if no region contains the address
+ */
+static int find_addr_entry(uint32_t addr, size_t * out_bit_i) {
+    size_t low  = 0;
+    size_t high = __region_table_count;
+
+    // Table is sorted by address, find the first region starting after addr
+    while (low < high) {
+        size_t   mid          = low + (high - low) / 2;
+        uint32_t region_start = __region_table->entries[mid].addr_flags & MASK_ADDR;
+
+        if (region_start <= addr) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+
+    // Address is before the first region
+    if (!low) {
+        return -1;
+    }
+
+    ram_table_entry_t * entry = &__region_table->entries[low - 1];
+
+    uint32_t region_start = entry->addr_flags & MASK_ADDR;
+    size_t   bit_i        = (addr - region_start) / PAGE_SIZE;
+
+    // Compare pages so a region ending at 4 GiB doesn't overflow
+    if (bit_i >= entry->page_count) {
+        return -1;
+    }
+
+    *out_bit_i = bit_i;
+
+    return low - 1;
+}
+
+/**
+ * @brief Find a free page in the bitmask of a region.
+ *
+ * The bitmask is read a word at a time, starting from the region's next free
+ * word and wrapping around to the start. The next free word is moved to the
+ * word where the free page was found, so allocating many pages doesn't search
+ * the used pages again each time.
+ *
+ * @param bitmask pointer to the bitmask
+ * @param entry pointer to the region table entry
+ * @return int bit index of the free page or -1 if there are no free pages
+ */
+static int find_free_bit(const void * bitmask, ram_table_entry_t * entry) {
+    const uint32_t * words      = bitmask;
+    size_t           word_count = (entry->page_count + BITMASK_WORD_BITS - 1) / BITMASK_WORD_BITS;
+    size_t           word       = REGION_NEXT_FREE(entry);
+
+    if (word >= word_count) {
+        word = 0;
+    }
+
+    for (size_t i = 0; i < word_count; i++) {
+        // Bits after the region end are always 0
+        if (words[word]) {
+            set_next_free(entry, word);
+
+            return word * BITMASK_WORD_BITS + __builtin_ctz(words[word]);
+        }
+
+        word++;
+
+        if (word >= word_count) {
+            word = 0;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Take up to `count` free pages from the bitmask of a region.
+ *
+ * Like `find_free_bit`, the search starts at the next free word and wraps
+ * around. Every free page of a word is taken before moving to the next, and
+ * the next free word is left where the last page was found.
+ *
+ * @param bitmask pointer to the bitmask
+ * @param entry pointer to the region table entry
+ * @param out pointer to an array of at least `count` page addresses
+ * @param count maximum number of pages to take
+ * @return int number of pages taken
+ */
+static int take_free_bits(void * bitmask, ram_table_entry_t * entry, uint32_t * out, size_t count) {
+    uint32_t * words        = bitmask;
+    uint32_t   region_start = entry->addr_flags & MASK_ADDR;
+    size_t     word_count   = (entry->page_count + BITMASK_WORD_BITS - 1) / BITMASK_WORD_BITS;
+    size_t     word         = REGION_NEXT_FREE(entry);
+    size_t     found        = 0;
+
+    if (word >= word_count) {
+        word = 0;
+    }
+
+    for (size_t i = 0; i < word_count && found < count; i++) {
+        // Bits after the region end are always 0
+        while (words[word] && found < count) {
+            size_t bit = __builtin_ctz(words[word]);
+
+            // Clear lowest set bit
+            words[word] &= words[word] - 1;
+            out[found++] = region_start + PAGE_SIZE * (word * BITMASK_WORD_BITS + bit);
+
+            frame_take(entry, word * BITMASK_WORD_BITS + bit);
+        }
+
+        if (found == count) {
+            set_next_free(entry, word);
+            break;
+        }
+
+        word++;
+
+        if (word >= word_count) {
+            word = 0;
+        }
+    }
+
+    entry->free_count -= found;
+
+    return found;
+}
+
+/**
+ * @brief Find `count` free pages in a row in the bitmask of a region.
+ *
+ * The physical address of the first page is aligned to `align`. When a used
+ * page is found in a candidate run, the search jumps to the next aligned page
+ * after it, so every page is checked at most once.
+ *
+ * @param bitmask pointer to the bitmask
+ * @param entry pointer to the region table entry
+ * @param count number of pages
+ * @param align alignment in bytes, a power of 2 of at least `PAGE_SIZE`
+ * @return int bit index of the first page or -1 if there is no free run
+ */
+static int find_free_run(const void * bitmask, ram_table_entry_t * entry, size_t count, size_t align) {
+    uint32_t region_start = entry->addr_flags & MASK_ADDR;
+    size_t   align_pages  = align / PAGE_SIZE;
+
+    // First aligned address after the bitmask page
+    uint32_t first = (region_start + PAGE_SIZE + align - 1) & ~(align - 1);
+
+    if (first < region_start) {
+        return -1;
+    }
+
+    size_t start = (first - region_start) / PAGE_SIZE;
+
+    while (start + count <= entry->page_count) {
+        int used = find_used_bit(bitmask, start, count);
+
+        if (used < 0) {
+            return start;
+        }
+
+        // No aligned run can include the used page
+        start += ((used - start) / align_pages + 1) * align_pages;
     }
 
     return -1;
 }
 
-static int find_free_bit(const void * bitmask, size_t page_count) {
-    const char * bitmask_data = bitmask;
+/**
+ * @brief Find the first used page in a range of the bitmask.
+ *
+ * @param bitmask pointer to the bitmask
+ * @param start first bit of the range
+ * @param count number of bits in the range
+ * @return int bit index of the first used page or -1 if all are free
+ */
+static int find_used_bit(const void * bitmask, size_t start, size_t count) {
+    const uint32_t * words = bitmask;
+    size_t           end   = start + count;
+
+    while (start < end) {
+        size_t   word   = start / BITMASK_WORD_BITS;
+        size_t   offset = start % BITMASK_WORD_BITS;
+        size_t   bits   = BITMASK_WORD_BITS - offset;
+        uint32_t mask   = 0xffffffff << offset;
+
+        if (bits > end - start) {
+            bits = end - start;
+            mask &= 0xffffffff >> (BITMASK_WORD_BITS - offset - bits);
+        }
 
-    for (size_t i = 1; i < page_count; i++) {
-        size_t byte = i / 8;
-        size_t bit  = i % 8;
+        uint32_t used = ~words[word] & mask;
 
-        if (bitmask_data[byte] & (1 << bit)) {
+        if (used) {
+            return word * BITMASK_WORD_BITS + __builtin_ctz(used);
+        }
+
+        start += bits;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Find the first free page in a range of the bitmask.
+ *
+ * @param bitmask pointer to the bitmask
+ * @param start first bit of the range
+ * @param count number of bits in the range
+ * @return int bit index of the first free page or -1 if all are used
+ */
+static int find_free_bit_in(const void * bitmask, size_t start, size_t count) {
+    for (size_t i = start; i < start + count; i++) {
+        if (is_bit_free((void *)bitmask, i)) {
             return i;
         }
     }
@@ -207,6 +693,54 @@ static int find_free_bit(const void * bitmask, size_t page_count) {
     return -1;
 }
 
+/**
+ * @brief Mark a range of pages in the bitmask as free or used.
+ *
+ * Whole words are written at once, only the words at either end of the range
+ * are masked.
+ *
+ * @param bitmask pointer to the bitmask
+ * @param start first bit of the range
+ * @param count number of bits in the range
+ * @param free 1 to mark the pages free, 0 to mark them used
+ */
+static void set_bits(void * bitmask, size_t start, size_t count, int free) {
+    uint32_t * words = bitmask;
+    size_t     end   = start + count;
+
+    while (start < end) {
+        size_t   word   = start / BITMASK_WORD_BITS;
+        size_t   offset = start % BITMASK_WORD_BITS;
+        size_t   bits   = BITMASK_WORD_BITS - offset;
+        uint32_t mask   = 0xffffffff << offset;
+
+        if (bits > end - start) {
+            bits = end - start;
+            mask &= 0xffffffff >> (BITMASK_WORD_BITS - offset - bits);
+        }
+
+        if (free) {
+            words[word] |= mask;
+        }
+        else {
+            words[word] &= ~mask;
+        }
+
+        start += bits;
+    }
+}
+
+/**
+ * @brief Set the bitmask word where the next search for a free page starts.
+ *
+ * @param entry pointer to the region table entry
+ * @param word index of the word in the region bitmask
+ */
+static void set_next_free(ram_table_entry_t * entry, size_t word) {
+    entry->addr_flags &= ~REGION_TABLE_NEXT_FREE_MASK;
+    entry->addr_flags |= (word << REGION_TABLE_NEXT_FREE_SHIFT) & REGION_TABLE_NEXT_FREE_MASK;
+}
+
 static int find_free_region() {
     for (int i = 0; i < __region_table_count; i++) {
         ram_table_entry_t * entry = &__region_table->entries[i];
@@ -298,3 +832,72 @@ static void add_memory_at(size_t start, uint64_t base, uint64_t length) {
         base += REGION_MAX_SIZE;
     }
 }
+
+/**
+ * @brief Get the frame database entry of a physical address.
+ *
+ * @param addr physical address
+ * @return ram_frame_t * pointer to the frame or 0 if there is no frame
+ */
+static ram_frame_t * get_frame(uint32_t addr) {
+    if (!__frames) {
+        return 0;
+    }
+
+    size_t bit_i    = 0;
+    int    region_i = find_addr_entry(addr, &bit_i);
+
+    if (region_i < 0) {
+        return 0;
+    }
+
+    return &__frames[__frame_base[region_i] + bit_i];
+}
+
+/**
+ * @brief Give a newly allocated page its first reference.
+ *
+ * Does nothing before the frame database is initialized.
+ *
+ * @param entry pointer to the region table entry
+ * @param bit page index within the region
+ */
+static void frame_take(const ram_table_entry_t * entry, size_t bit) {
+    if (!__frames) {
+        return;
+    }
+
+    size_t region_i = entry - __region_table->entries;
+
+    __frames[__frame_base[region_i] + bit] = 1;
+}
+
+/**
+ * @brief Drop a reference to a page.
+ *
+ * Flags are cleared with the last reference. Before the frame database is
+ * initialized every page has a single reference.
+ *
+ * @param entry pointer to the region table entry
+ * @param bit page index within the region
+ * @return int number of references left
+ */
+static int frame_release(const ram_table_entry_t * entry, size_t bit) {
+    if (!__frames) {
+        return 0;
+    }
+
+    size_t        region_i = entry - __region_table->entries;
+    ram_frame_t * frame    = &__frames[__frame_base[region_i] + bit];
+    int           refs     = *frame & RAM_FRAME_REF_MASK;
+
+    if (refs > 1) {
+        (*frame)--;
+
+        return refs - 1;
+    }
+
+    *frame = 0;
+
+    return 0;
+}
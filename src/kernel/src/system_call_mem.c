@@ -19,6 +19,44 @@ int sys_call_mem_cb(uint16_t int_no, void * args_data, registers_t * regs) {
 
             res = PTR2UINT(process_add_pages(curr_proc, args->count));
         } break;
+
+        case SYS_INT_MEM_PAGE_FREE: {
+            struct _args {
+                void * addr;
+                size_t count;
+            } * args = (struct _args *)args_data;
+
+            process_t * curr_proc = get_current_process();
+
+            res = process_remove_pages(curr_proc, args->addr, args->count);
+        } break;
+
+        case SYS_INT_MEM_MAP_FILE: {
+            struct _args {
+                const char * filename;
+            } * args = (struct _args *)args_data;
+
+            tar_fs_t * tar    = kernel_get_tar();
+            int        file_i = tar_file_index(tar, args->filename);
+
+            if (file_i < 0) {
+                return 0;
+            }
+
+            process_t * curr_proc = get_current_process();
+
+            res = PTR2UINT(process_map_file(curr_proc, tar, file_i));
+        } break;
+
+        case SYS_INT_MEM_UNMAP_FILE: {
+            struct _args {
+                void * addr;
+            } * args = (struct _args *)args_data;
+
+            process_t * curr_proc = get_current_process();
+
+            res = process_unmap_file(curr_proc, args->addr);
+        } break;
     }
 
     return res;
@@ -84,6 +84,29 @@ int sys_call_proc_cb(uint16_t int_no, void * args_data, registers_t * regs) {
             res = p->pid;
         } break;
 
+        case SYS_INT_PROC_FORK: {
+            process_t * child = kernel_alloc_process();
+
+            if (!child) {
+                return -1;
+            }
+
+            res = fork_task(child);
+
+            // Child returns from fork_task when it first runs
+            if (res == 1) {
+                return 0;
+            }
+
+            if (res) {
+                kernel_free_process(child);
+                return -1;
+            }
+
+            pm_add_proc(kernel_get_proc_man(), child);
+            res = child->pid;
+        } break;
+
         case SYS_INT_PROC_QUEUE_EVENT: {
             struct _args {
                 ebus_event_t * event;
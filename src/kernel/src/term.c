@@ -5,6 +5,7 @@
 #include "drivers/vga.h"
 #include "ebus.h"
 #include "kernel.h"
+#include "libc/arena.h"
 #include "libc/datastruct/circular_buffer.h"
 #include "libc/memory.h"
 #include "libc/proc.h"
@@ -35,6 +36,9 @@ static cb_t            keybuff;
 static char            command_buff[MAX_CHARS + 1];
 static volatile size_t command_ready = 0;
 
+// Parsed args only live until the command returns
+static arena_t args_arena;
+
 #define MAX_COMMANDS 4096
 static command_t commands[MAX_COMMANDS] = {0};
 static size_t    n_commands             = 0;
@@ -108,9 +112,13 @@ void term_init() {
     if (cb_create(&keybuff, MAX_CHARS, 1)) {
         return;
     }
+
+    if (arena_create(&args_arena, ARENA_CHUNK_SIZE)) {
+        return;
+    }
     command_ready = false;
 
-    process_t * proc = kmalloc(sizeof(process_t));
+    process_t * proc = kernel_alloc_process();
     if (!proc || process_create(proc)) {
         return;
     }
@@ -281,6 +289,7 @@ static void exec_buff() {
     if (!argc || !argv) {
         FATAL("SYNTAX ERROR!\n");
         term_last_ret = 1;
+        arena_reset(&args_arena);
         return;
     }
 
@@ -339,10 +348,7 @@ static void exec_buff() {
     }
 
     // Free parsed args
-    for (size_t i = 0; i < argc; i++) {
-        pfree(argv[i]);
-    }
-    pfree(argv);
+    arena_reset(&args_arena);
 }
 
 static bool is_ws(char c) {
@@ -412,7 +418,7 @@ static char ** parse_args(const char * line, size_t * out_len) {
     }
 
     *out_len      = len;
-    char ** args  = pmalloc(sizeof(char *) * len);
+    char ** args  = arena_alloc(&args_arena, sizeof(char *) * len);
     size_t  arg_i = 0;
 
     while (*line) {
@@ -443,7 +449,7 @@ static char ** parse_args(const char * line, size_t * out_len) {
 
             line++;
 
-            args[arg_i] = pmalloc(sizeof(char) * next);
+            args[arg_i] = arena_alloc(&args_arena, sizeof(char) * next);
             kmemcpy(args[arg_i], line, next - 1);
             args[arg_i][next - 1] = 0;
             arg_i++;
@@ -459,7 +465,7 @@ static char ** parse_args(const char * line, size_t * out_len) {
         }
 
         size_t word_len = line - start;
-        args[arg_i]     = pmalloc(sizeof(char) * word_len + 1);
+        args[arg_i]     = arena_alloc(&args_arena, sizeof(char) * word_len + 1);
         kmemcpy(args[arg_i], start, word_len);
         args[arg_i][word_len] = 0;
         arg_i++;
@@ -0,0 +1,72 @@
+#ifndef LIBC_ARENA_H
+#define LIBC_ARENA_H
+
+#include <stddef.h>
+
+#include "memory_alloc.h"
+
+// Default chunk size, including the chunk header. With the heap entry header
+// this fills exactly one page.
+#define ARENA_CHUNK_SIZE (4096 - sizeof(memory_entry_t))
+
+typedef struct _arena_chunk {
+    struct _arena_chunk * next;
+    size_t                size;
+    size_t                used;
+} arena_chunk_t;
+
+typedef struct _arena {
+    arena_chunk_t * head;
+    size_t          chunk_size;
+} arena_t;
+
+/**
+ * @brief Create a new arena that allocates chunks of `chunk_size` bytes.
+ *
+ * `arena` is expected to be existing memory that will be used by the function.
+ * No chunks are allocated until the first call to `arena_alloc`.
+ *
+ * @param arena pointer to the arena struct
+ * @param chunk_size number of bytes for each chunk, including the chunk header
+ * @return int 0 for success
+ */
+int arena_create(arena_t * arena, size_t chunk_size);
+
+/**
+ * @brief Free all chunks of the arena.
+ *
+ * All pointers returned by `arena_alloc` are invalid after this call. This
+ * does not free the memory pointed to by `arena`.
+ *
+ * @param arena pointer to the arena
+ */
+void arena_free(arena_t * arena);
+
+/**
+ * @brief Allocate `size` bytes from the arena.
+ *
+ * Memory is taken from the end of the current chunk, a new chunk is added when
+ * the current chunk is full. Allocations larger than a chunk get a chunk of
+ * their own. The pointer returned will always be aligned to 4 bytes.
+ *
+ * Memory from the arena is never freed on it's own, use `arena_reset` or
+ * `arena_free` to release all allocations at once.
+ *
+ * @param arena pointer to the arena
+ * @param size number of bytes to allocate
+ * @return void* pointer to the allocated memory or 0 for fail
+ */
+void * arena_alloc(arena_t * arena, size_t size);
+
+/**
+ * @brief Release all allocations from the arena.
+ *
+ * One chunk is kept so the arena can be reused without allocating again, all
+ * other chunks are freed. All pointers returned by `arena_alloc` are invalid
+ * after this call.
+ *
+ * @param arena pointer to the arena
+ */
+void arena_reset(arena_t * arena);
+
+#endif // LIBC_ARENA_H
@@ -8,6 +8,7 @@
 
 void   init_malloc(memory_t * memory);
 void * pmalloc(size_t size);
+void * pmalloc_aligned(size_t size, size_t align);
 void * prealloc(void * ptr, size_t size);
 void   pfree(void * ptr);
 
@@ -33,4 +33,11 @@ void yield(void);
 
 int getpid(void);
 
+/**
+ * @brief Create a copy of this process that shares its memory until written.
+ *
+ * @return int pid of the child in the parent, 0 in the child or -1 for failure
+ */
+int proc_fork(void);
+
 #endif // LIBC_PROC_H
@@ -0,0 +1,128 @@
+#include "libc/arena.h"
+
+#include <stdint.h>
+
+#include "libc/memory.h"
+
+#define CHUNK_DATA(CHUNK) ((uint8_t *)(CHUNK) + sizeof(arena_chunk_t))
+
+#define ALIGN_SIZE(SIZE)                   \
+    if ((SIZE) & 0x3) {                    \
+        (SIZE) = (((SIZE) >> 2) + 1) << 2; \
+    }
+
+static arena_chunk_t * new_chunk(size_t size);
+
+int arena_create(arena_t * arena, size_t chunk_size) {
+    if (!arena || chunk_size <= sizeof(arena_chunk_t)) {
+        return -1;
+    }
+
+    arena->head       = 0;
+    arena->chunk_size = chunk_size;
+
+    return 0;
+}
+
+void arena_free(arena_t * arena) {
+    if (!arena) {
+        return;
+    }
+
+    arena_chunk_t * chunk = arena->head;
+
+    while (chunk) {
+        arena_chunk_t * next = chunk->next;
+        pfree(chunk);
+        chunk = next;
+    }
+
+    arena->head = 0;
+}
+
+void * arena_alloc(arena_t * arena, size_t size) {
+    if (!arena || !size) {
+        return 0;
+    }
+
+    ALIGN_SIZE(size);
+
+    arena_chunk_t * chunk = arena->head;
+
+    if (!chunk || chunk->used + size > chunk->size) {
+        size_t chunk_size = arena->chunk_size;
+
+        if (size > chunk_size - sizeof(arena_chunk_t)) {
+            chunk_size = size + sizeof(arena_chunk_t);
+        }
+
+        chunk = new_chunk(chunk_size);
+        if (!chunk) {
+            return 0;
+        }
+
+        // Large chunks are filled now, keep using the current chunk after
+        if (arena->head && chunk_size > arena->chunk_size) {
+            chunk->next       = arena->head->next;
+            arena->head->next = chunk;
+        }
+        else {
+            chunk->next = arena->head;
+            arena->head = chunk;
+        }
+    }
+
+    void * ptr = CHUNK_DATA(chunk) + chunk->used;
+    chunk->used += size;
+
+    return ptr;
+}
+
+void arena_reset(arena_t * arena) {
+    if (!arena) {
+        return;
+    }
+
+    arena_chunk_t * keep  = 0;
+    arena_chunk_t * chunk = arena->head;
+
+    while (chunk) {
+        arena_chunk_t * next = chunk->next;
+
+        // Keep a default size chunk, large chunks are only used once
+        if (!keep && chunk->size == arena->chunk_size - sizeof(arena_chunk_t)) {
+            keep = chunk;
+        }
+        else {
+            pfree(chunk);
+        }
+
+        chunk = next;
+    }
+
+    if (keep) {
+        keep->next = 0;
+        keep->used = 0;
+    }
+
+    arena->head = keep;
+}
+
+/**
+ * @brief Allocate a new empty chunk.
+ *
+ * @param size number of bytes for the chunk, including the chunk header
+ * @return arena_chunk_t* pointer to the chunk or 0 for fail
+ */
+static arena_chunk_t * new_chunk(size_t size) {
+    arena_chunk_t * chunk = pmalloc(size);
+    if (!chunk) {
+        return 0;
+    }
+
+    chunk->next = 0;
+    chunk->size = size - sizeof(arena_chunk_t);
+    chunk->used = 0;
+
+    return chunk;
+}
@@ -10,7 +10,11 @@ void init_malloc(memory_t * memory) {
 }
 
 void * pmalloc(size_t size) {
-    return memory_alloc(__memory, size);
+    return MEMORY_ALLOC_CALLER(__memory, size);
+}
+
+void * pmalloc_aligned(size_t size, size_t align) {
+    return MEMORY_ALLOC_ALIGNED_CALLER(__memory, size, align);
 }
 
 void * prealloc(void * ptr, size_t size) {
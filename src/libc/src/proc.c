@@ -29,3 +29,7 @@ void yield() {
 int getpid(void) {
     return _sys_proc_getpid();
 }
+
+int proc_fork(void) {
+    return _sys_proc_fork();
+}
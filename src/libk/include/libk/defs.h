@@ -14,6 +14,9 @@
 #define SYS_INT_IO_TELL  0x0105
 
 #define SYS_INT_MEM_PAGE_ALLOC 0x0203
+#define SYS_INT_MEM_PAGE_FREE  0x0204
+#define SYS_INT_MEM_MAP_FILE   0x0205
+#define SYS_INT_MEM_UNMAP_FILE 0x0206
 
 #define SYS_INT_PROC_EXIT        0x0300
 #define SYS_INT_PROC_ABORT       0x0301
@@ -22,6 +25,7 @@
 #define SYS_INT_PROC_GETPID      0x0304
 #define SYS_INT_PROC_QUEUE_EVENT 0x0305
 #define SYS_INT_PROC_YIELD       0x0306
+#define SYS_INT_PROC_FORK        0x0307
 
 #define SYS_INT_STDIO_PUTC 0x1000
 #define SYS_INT_STDIO_PUTS 0x1001
@@ -21,12 +21,16 @@ int _sys_io_seek(int handle, int pos, int seek);
 int _sys_io_tell(int handle);
 
 void * _sys_page_alloc(size_t count);
+int    _sys_page_free(void * addr, size_t count);
+void * _sys_map_file(const char * filename);
+int    _sys_unmap_file(void * addr);
 
 NO_RETURN void _sys_proc_exit(uint8_t code);
 NO_RETURN void _sys_proc_abort(uint8_t code, const char * msg);
 NO_RETURN void _sys_proc_panic(const char * msg, const char * file, unsigned int line);
 
 int _sys_proc_getpid(void);
+int _sys_proc_fork(void);
 
 void _sys_register_signals(void * callback);
 void _sys_queue_event(ebus_event_t * event);
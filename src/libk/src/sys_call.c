@@ -39,6 +39,18 @@ void * _sys_page_alloc(size_t count) {
     return UINT2PTR(send_call(SYS_INT_MEM_PAGE_ALLOC, count));
 }
 
+int _sys_page_free(void * addr, size_t count) {
+    return send_call(SYS_INT_MEM_PAGE_FREE, addr, count);
+}
+
+void * _sys_map_file(const char * filename) {
+    return UINT2PTR(send_call(SYS_INT_MEM_MAP_FILE, filename));
+}
+
+int _sys_unmap_file(void * addr) {
+    return send_call(SYS_INT_MEM_UNMAP_FILE, addr);
+}
+
 void _sys_proc_exit(uint8_t code) {
     _sys_puts("libk: Proc exit\n");
     send_call_noret(SYS_INT_PROC_EXIT, code);
@@ -58,6 +70,10 @@ int _sys_proc_getpid(void) {
     return send_call(SYS_INT_PROC_GETPID);
 }
 
+int _sys_proc_fork(void) {
+    return send_call(SYS_INT_PROC_FORK);
+}
+
 void _sys_register_signals(void * callback) {
     send_call(SYS_INT_PROC_REG_SIG, callback);
 }
@@ -6,19 +6,90 @@
 
 #define ENTRY_PTR(ENTRY) ((void *)((uint32_t)(ENTRY) + sizeof(memory_entry_t)))
 
+// Exact classes in 4 byte steps below this size
+#define MEMORY_SMALL_CLASS_MAX   128
+#define MEMORY_SMALL_CLASS_COUNT (MEMORY_SMALL_CLASS_MAX >> 2)
+// Power of two classes from MEMORY_SMALL_CLASS_MAX to 2^31
+#define MEMORY_LARGE_CLASS_COUNT 25
+#define MEMORY_CLASS_COUNT       (MEMORY_SMALL_CLASS_COUNT + MEMORY_LARGE_CLASS_COUNT)
+#define MEMORY_CLASS_MASK_COUNT  ((MEMORY_CLASS_COUNT + 31) >> 5)
+
+// Allocations larger than this size get their own pages
+#define MEMORY_LARGE_SIZE 4096
+
+// Number of page ranges given back through free_pages_fn that are tracked
+#define MEMORY_RELEASED_MAX 16
+
+// Number of call sites tracked when built with MEMORY_PROFILE
+#define MEMORY_PROFILE_SITES 64
+
+#ifdef MEMORY_PROFILE
+#define MEMORY_ALLOC_CALLER(MEM, SIZE) memory_alloc_from((MEM), (SIZE), __builtin_return_address(0))
+#define MEMORY_ALLOC_ALIGNED_CALLER(MEM, SIZE, ALIGN) \
+    memory_alloc_aligned_from((MEM), (SIZE), (ALIGN), __builtin_return_address(0))
+#else
+#define MEMORY_ALLOC_CALLER(MEM, SIZE)                memory_alloc((MEM), (SIZE))
+#define MEMORY_ALLOC_ALIGNED_CALLER(MEM, SIZE, ALIGN) memory_alloc_aligned((MEM), (SIZE), (ALIGN))
+#endif
+
 typedef void * (*memory_alloc_pages_t)(size_t pages);
+typedef int (*memory_free_pages_t)(void * addr, size_t pages);
 
 typedef struct _entry {
     uint32_t        magic;
     struct _entry * next;
     struct _entry * prev;
     size_t          size;
+#ifdef MEMORY_PROFILE
+    uint32_t site;
+    uint32_t tick;
+#endif
 } __attribute__((packed)) memory_entry_t;
 
+enum MEMORY_PROFILE_SORT {
+    MEMORY_PROFILE_SORT_BYTES,
+    MEMORY_PROFILE_SORT_COUNT,
+};
+
+typedef struct _memory_profile_site {
+    void *   caller;
+    uint32_t alloc_count;
+    uint32_t alloc_bytes;
+    uint32_t live_count;
+    uint32_t live_bytes;
+    // Sum of allocation ticks each freed allocation was alive for
+    uint32_t lifetime;
+} memory_profile_site_t;
+
+typedef struct _memory_profile {
+    // Incremented by every allocation, used to measure lifetime
+    uint32_t              clock;
+    // Allocations that were not recorded because the table was full
+    uint32_t              dropped;
+    // Caller passed down from a wrapper, taken by the next allocation
+    void *                caller;
+    memory_profile_site_t sites[MEMORY_PROFILE_SITES];
+} memory_profile_t;
+
+typedef struct _memory_range {
+    uint32_t start;
+    uint32_t end;
+} memory_range_t;
+
 typedef struct _memory {
     memory_entry_t *     first;
     memory_entry_t *     last;
     memory_alloc_pages_t alloc_pages_fn;
+    memory_free_pages_t  free_pages_fn;
+    memory_entry_t *     large;
+    uint32_t             class_mask[MEMORY_CLASS_MASK_COUNT];
+    memory_entry_t *     free_lists[MEMORY_CLASS_COUNT];
+    // Pages that were given back, headers there can't be read
+    memory_range_t released[MEMORY_RELEASED_MAX];
+    size_t         released_count;
+#ifdef MEMORY_PROFILE
+    memory_profile_t profile;
+#endif
 } memory_t;
 
 /**
@@ -26,11 +97,15 @@ typedef struct _memory {
  *
  * This will call `alloc_page_fn` once to setup the first entry.
  *
+ * If `free_pages_fn` is not 0, whole pages of free memory are given back
+ * through it when memory is freed. The first page is never given back.
+ *
  * @param mem pointer to a memory allocator
  * @param alloc_pages_fn callback to allocate more pages
+ * @param free_pages_fn optional callback to release unused pages
  * @return int 0 for success
  */
-int memory_init(memory_t * mem, memory_alloc_pages_t alloc_pages_fn);
+int memory_init(memory_t * mem, memory_alloc_pages_t alloc_pages_fn, memory_free_pages_t free_pages_fn);
 
 /**
  * @brief Allocate a region of memory and return it's pointer.
@@ -39,6 +114,14 @@ int memory_init(memory_t * mem, memory_alloc_pages_t alloc_pages_fn);
  * up to the next alignment boundary. The pointer returned will always be
  * aligned to 4 bytes.
  *
+ * Free entries are kept in segregated lists by size class, so small requests
+ * are served from the head of their class without walking the heap.
+ *
+ * If `free_pages_fn` was set, allocations larger than `MEMORY_LARGE_SIZE`
+ * bytes are not taken from the heap. They get their own pages from
+ * `alloc_pages_fn`, which are released as soon as they are freed. If the
+ * pages can't be released, they are kept by the heap.
+ *
  * @param mem pointer to the memory allocator
  * @param size minimum number of bytes to allocate
  * @return void* pointer to the allocated memory or 0 for fail
@@ -46,17 +129,121 @@ int memory_init(memory_t * mem, memory_alloc_pages_t alloc_pages_fn);
 void * memory_alloc(memory_t * mem, size_t size);
 
 /**
- * @brief NOT IMPLEMENTED
+ * @brief Allocate a region of memory with it's pointer aligned to `align`.
+ *
+ * `align` must be a power of 2. The space before the aligned pointer is split
+ * off as a free entry, so only the entry header is lost to alignment. Large
+ * allocations are always taken from the heap by this function.
+ *
+ * Memory from this function is freed with `memory_free`. A call to
+ * `memory_realloc` may move it and lose the alignment.
+ *
+ * @param mem pointer to the memory allocator
+ * @param size minimum number of bytes to allocate
+ * @param align alignment of the returned pointer in bytes
+ * @return void* pointer to the allocated memory or 0 for fail
+ */
+void * memory_alloc_aligned(memory_t * mem, size_t size, size_t align);
+
+#ifdef MEMORY_PROFILE
+/**
+ * @brief Allocate memory like `memory_alloc`, recording it for `caller`.
+ *
+ * Use `MEMORY_ALLOC_CALLER` from wrappers like `kmalloc` so allocations are
+ * recorded for the caller of the wrapper instead of the wrapper itself.
+ *
+ * @param mem pointer to the memory allocator
+ * @param size minimum number of bytes to allocate
+ * @param caller address the allocation is recorded for
+ * @return void* pointer to the allocated memory or 0 for fail
+ */
+void * memory_alloc_from(memory_t * mem, size_t size, void * caller);
+
+/**
+ * @brief Allocate aligned memory like `memory_alloc_aligned`, recording it for
+ * `caller`.
+ *
+ * @param mem pointer to the memory allocator
+ * @param size minimum number of bytes to allocate
+ * @param align alignment of the returned pointer in bytes
+ * @param caller address the allocation is recorded for
+ * @return void* pointer to the allocated memory or 0 for fail
+ */
+void * memory_alloc_aligned_from(memory_t * mem, size_t size, size_t align, void * caller);
+#endif
+
+/**
+ * @brief Resize allocated memory, keeping it's contents.
+ *
+ * Shrinking and growing into a free next entry or new pages at the end of the
+ * heap happen in place. Otherwise a new region is allocated, the contents are
+ * copied and the old region is freed. If this fails, `ptr` is not changed.
+ *
+ * @param mem pointer to the memory allocator
+ * @param ptr pointer to the allocated memory
+ * @param size minimum number of bytes for the new size
+ * @return void* pointer to the allocated memory or 0 for fail
  */
 void * memory_realloc(memory_t * mem, void * ptr, size_t size);
 
 /**
  * @brief Free allocated memory.
  *
+ * The entry is found directly from `ptr` and joined with any free neighbours,
+ * so no free entry is ever next to another. Pointers into pages that were
+ * given back are rejected without reading the pages.
+ *
+ * If the joined entry covers whole pages and `free_pages_fn` was set, those
+ * pages are released and the entry is split around them. Up to
+ * `MEMORY_RELEASED_MAX` separate ranges can be released, after that the pages
+ * are kept by the heap.
+ *
  * @param mem pointer to the memory allocator
  * @param ptr pointer to the allocated memory
  * @return int 0 for success
  */
 int memory_free(memory_t * mem, void * ptr);
 
+/**
+ * @brief Allocate pages from the page source of `mem` for another allocator.
+ *
+ * Used by allocators that share the pages of `mem`, like a memory cache, so
+ * pages given back with `memory_free_pages` are tracked by `mem`.
+ *
+ * @param mem pointer to the memory allocator
+ * @param count number of pages
+ * @return void* pointer to the first page or 0 for fail
+ */
+void * memory_alloc_pages(memory_t * mem, size_t count);
+
+/**
+ * @brief Give back pages from `memory_alloc_pages`.
+ *
+ * The pages are released through `free_pages_fn` and `mem` no longer reads
+ * memory inside them. This fails if `free_pages_fn` is not set, if it fails or
+ * if `MEMORY_RELEASED_MAX` ranges are already released.
+ *
+ * @param mem pointer to the memory allocator
+ * @param addr pointer to the first page
+ * @param count number of pages
+ * @return int 0 for success
+ */
+int memory_free_pages(memory_t * mem, void * addr, size_t count);
+
+/**
+ * @brief Get the allocation sites using the most memory.
+ *
+ * Only available when built with `MEMORY_PROFILE`. Each allocation is
+ * recorded for the address it was called from, along with it's size and how
+ * many allocations happened before it was freed. Up to `count` sites are
+ * copied to `out`, sorted by total bytes or by number of allocations.
+ *
+ * @param mem pointer to the memory allocator
+ * @param out pointer to an array of at least `count` sites
+ * @param count maximum number of sites to copy
+ * @param sort order of the sites
+ * @return int number of sites copied or -1 if profiling is not enabled
+ */
+int memory_profile_top(memory_t * mem, memory_profile_site_t * out, size_t count, enum MEMORY_PROFILE_SORT sort);
+
 #endif // MEMORY_ALLOC_H
@@ -0,0 +1,85 @@
+#ifndef MEMORY_CACHE_H
+#define MEMORY_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "memory_alloc.h"
+
+typedef void (*memory_cache_ctor_t)(void * obj);
+
+typedef struct _memory_slab {
+    uint32_t               magic;
+    struct _memory_cache * cache;
+    struct _memory_slab *  next;
+    struct _memory_slab *  prev;
+    void *                 objects;
+    uint16_t               free_count;
+    // Followed by a bitmap of free objects
+    uint16_t               free_stack[];
+} __attribute__((packed)) memory_slab_t;
+
+typedef struct _memory_cache {
+    memory_t *          mem;
+    size_t              obj_size;
+    size_t              slab_obj_count;
+    memory_cache_ctor_t ctor;
+    memory_slab_t *     partial;
+    memory_slab_t *     full;
+} memory_cache_t;
+
+/**
+ * @brief Setup a new object cache for objects of `obj_size` bytes.
+ *
+ * Slabs are single pages taken from the `alloc_pages_fn` of `mem`, so
+ * `obj_size` must leave room for the slab header in one page. No pages are
+ * allocated until the first call to `memory_cache_alloc`.
+ *
+ * If `ctor` is not 0, it is called once for each object when a new slab is
+ * created. Objects should be returned to the cache in their constructed
+ * state, their contents are not changed while they are free.
+ *
+ * @param cache pointer to the object cache
+ * @param mem pointer to the memory allocator that provides pages
+ * @param obj_size number of bytes for each object
+ * @param ctor optional callback to construct new objects
+ * @return int 0 for success
+ */
+int memory_cache_init(memory_cache_t * cache, memory_t * mem, size_t obj_size, memory_cache_ctor_t ctor);
+
+/**
+ * @brief Get a free object from the cache.
+ *
+ * A new slab is added if all slabs are full.
+ *
+ * @param cache pointer to the object cache
+ * @return void* pointer to the object or 0 for fail
+ */
+void * memory_cache_alloc(memory_cache_t * cache);
+
+/**
+ * @brief Return an object to the cache.
+ *
+ * Objects that are already free are rejected.
+ *
+ * If the slab of `obj` becomes empty and it is not the only partial slab, it's
+ * page is released through the `free_pages_fn` of the cache memory.
+ *
+ * @param cache pointer to the object cache
+ * @param obj pointer returned by `memory_cache_alloc`
+ * @return int 0 for success
+ */
+int memory_cache_free(memory_cache_t * cache, void * obj);
+
+/**
+ * @brief Release every slab of the cache, including slabs with live objects.
+ *
+ * Pages are released through the `free_pages_fn` of the cache memory. The
+ * cache is empty after this call and can still be used.
+ *
+ * @param cache pointer to the object cache
+ * @return int 0 for success, -1 if any page could not be released
+ */
+int memory_cache_destroy(memory_cache_t * cache);
+
+#endif // MEMORY_CACHE_H
@@ -2,25 +2,88 @@
 
 #define PAGE_SIZE 4096
 
-#define MAGIC_FREE 0x46524545
-#define MAGIC_USED 0x55534544
+#define MAGIC_FREE  0x46524545
+#define MAGIC_USED  0x55534544
+#define MAGIC_LARGE 0x4c415247
+
+// Free entries store their list links in the payload
+#define MIN_SIZE sizeof(free_link_t)
 
 #define NOT_ALIGNED(SIZE)         ((uint32_t)(SIZE) & 0x3)
 #define IS_ALIGNED(SIZE)          (!NOT_ALIGNED(SIZE))
-#define SHOULD_SPLIT(ENTRY, SIZE) ((ENTRY)->size >= (SIZE) + sizeof(memory_entry_t) + 4)
+#define NOT_PAGE_ALIGNED(ADDR)    ((uint32_t)(ADDR) & 0xfff)
+#define SHOULD_SPLIT(ENTRY, SIZE) ((ENTRY)->size >= (SIZE) + sizeof(memory_entry_t) + MIN_SIZE)
+#define FREE_LINK(ENTRY)          ((free_link_t *)ENTRY_PTR(ENTRY))
+#define ENTRY_END(ENTRY)          ((uint32_t)ENTRY_PTR(ENTRY) + (ENTRY)->size)
+
+// Pages from alloc_pages_fn may be shared with other users, so entries next
+// to each other in the list are not always next to each other in memory
+#define IS_ADJACENT(ENTRY, NEXT) (ENTRY_END(ENTRY) == (uint32_t)(NEXT))
+
+// Smallest entry that can be kept on either side of released pages
+#define MIN_ENTRY_SIZE (sizeof(memory_entry_t) + MIN_SIZE)
+
+#define PAGE_ALIGN_DOWN(ADDR) ((ADDR) & ~0xfff)
+#define PAGE_ALIGN_UP(ADDR)   PAGE_ALIGN_DOWN((ADDR) + 0xfff)
 
 #define ALIGN_SIZE(SIZE)                   \
     if ((SIZE) & 0x3) {                    \
         (SIZE) = (((SIZE) >> 2) + 1) << 2; \
     }
 
+#ifdef MEMORY_PROFILE
+// Must be expanded in the public function so the return address is it's caller
+#define PROFILE_TAKE_CALLER(MEM)      void * caller = memory_profile_take_caller((MEM), __builtin_return_address(0))
+#define PROFILE_PASS_CALLER(MEM)      (MEM)->profile.caller = caller
+#define PROFILE_PASS_SITE(MEM, ENTRY) memory_profile_pass_site((MEM), (ENTRY))
+#define PROFILE_ALLOC(MEM, ENTRY)     memory_profile_alloc((MEM), (ENTRY), caller)
+#define PROFILE_TAKE_SIZE(ENTRY)      size_t old_size = (ENTRY)->size
+#define PROFILE_RESIZE(MEM, ENTRY)    memory_profile_resize((MEM), (ENTRY), old_size)
+#define PROFILE_FREE(MEM, ENTRY)      memory_profile_free((MEM), (ENTRY))
+#else
+#define PROFILE_TAKE_CALLER(MEM)
+#define PROFILE_PASS_CALLER(MEM)
+#define PROFILE_PASS_SITE(MEM, ENTRY)
+#define PROFILE_ALLOC(MEM, ENTRY)
+#define PROFILE_TAKE_SIZE(ENTRY)
+#define PROFILE_RESIZE(MEM, ENTRY)
+#define PROFILE_FREE(MEM, ENTRY)
+#endif
+
+typedef struct _free_link {
+    memory_entry_t * next;
+    memory_entry_t * prev;
+} __attribute__((packed)) free_link_t;
+
 static void             memory_split_entry(memory_t * mem, memory_entry_t * entry, size_t size);
 static void             memory_merge_with_next(memory_t * mem, memory_entry_t * entry);
+static size_t           memory_class(size_t size);
+static size_t           memory_next_class(memory_t * mem, size_t class);
+static void             memory_list_push(memory_t * mem, memory_entry_t * entry);
+static void             memory_list_remove(memory_t * mem, memory_entry_t * entry);
 static memory_entry_t * memory_find_entry_size(memory_t * mem, size_t size);
+static memory_entry_t * memory_take_entry(memory_t * mem, size_t size);
 static memory_entry_t * memory_find_entry_ptr(memory_t * mem, void * ptr);
 static memory_entry_t * memory_add_entry(memory_t * mem, size_t size);
-
-int memory_init(memory_t * mem, memory_alloc_pages_t alloc_pages_fn) {
+static void *           memory_realloc_copy(memory_t * mem, memory_entry_t * entry, size_t size);
+static void             memory_release_pages(memory_t * mem, memory_entry_t * entry);
+static memory_entry_t * memory_alloc_large(memory_t * mem, size_t size);
+static memory_entry_t * memory_find_large(memory_t * mem, void * ptr);
+static void             memory_free_large(memory_t * mem, memory_entry_t * entry);
+static int              memory_range_released(memory_t * mem, uint32_t start, uint32_t end);
+static void             memory_range_release(memory_t * mem, uint32_t start, uint32_t end);
+static int              memory_range_take(memory_t * mem, uint32_t start, uint32_t end);
+
+#ifdef MEMORY_PROFILE
+static void * memory_profile_take_caller(memory_t * mem, void * return_addr);
+static void   memory_profile_pass_site(memory_t * mem, memory_entry_t * entry);
+static void   memory_profile_alloc(memory_t * mem, memory_entry_t * entry, void * caller);
+static void   memory_profile_resize(memory_t * mem, memory_entry_t * entry, size_t old_size);
+static void   memory_profile_free(memory_t * mem, memory_entry_t * entry);
+static int    memory_profile_before(memory_profile_site_t * a, memory_profile_site_t * b, enum MEMORY_PROFILE_SORT sort);
+#endif
+
+int memory_init(memory_t * mem, memory_alloc_pages_t alloc_pages_fn, memory_free_pages_t free_pages_fn) {
     if (!mem || !alloc_pages_fn) {
         return -1;
     }
@@ -28,6 +91,27 @@ int memory_init(memory_t * mem, memory_alloc_pages_t alloc_pages_fn) {
     mem->first          = alloc_pages_fn(1);
     mem->last           = mem->first;
     mem->alloc_pages_fn = alloc_pages_fn;
+    mem->free_pages_fn  = free_pages_fn;
+    mem->large          = 0;
+    mem->released_count = 0;
+
+    for (size_t i = 0; i < MEMORY_CLASS_MASK_COUNT; i++) {
+        mem->class_mask[i] = 0;
+    }
+
+    for (size_t i = 0; i < MEMORY_CLASS_COUNT; i++) {
+        mem->free_lists[i] = 0;
+    }
+
+#ifdef MEMORY_PROFILE
+    mem->profile.clock   = 0;
+    mem->profile.dropped = 0;
+    mem->profile.caller  = 0;
+
+    for (size_t i = 0; i < MEMORY_PROFILE_SITES; i++) {
+        mem->profile.sites[i] = (memory_profile_site_t){0};
+    }
+#endif
 
     if (!mem->first) {
         return -1;
@@ -40,6 +124,8 @@ int memory_init(memory_t * mem, memory_alloc_pages_t alloc_pages_fn) {
     entry->next  = 0;
     entry->prev  = 0;
 
+    memory_list_push(mem, entry);
+
     return 0;
 }
 
@@ -48,29 +134,91 @@ void * memory_alloc(memory_t * mem, size_t size) {
         return 0;
     }
 
+    PROFILE_TAKE_CALLER(mem);
+
     ALIGN_SIZE(size);
 
-    memory_entry_t * entry = memory_find_entry_size(mem, size);
+    if (size < MIN_SIZE) {
+        size = MIN_SIZE;
+    }
 
-    if (!entry) {
-        size_t request_size = size;
+    memory_entry_t * entry;
 
-        // Last entry will be merged with new entry
-        if (mem->last->magic == MAGIC_FREE) {
-            request_size -= mem->last->size - sizeof(memory_entry_t);
-        }
+    // Large allocations only get their own pages if they can be given back
+    if (size > MEMORY_LARGE_SIZE && mem->free_pages_fn) {
+        entry = memory_alloc_large(mem, size);
 
-        entry = memory_add_entry(mem, request_size);
+        if (!entry) {
+            return 0;
+        }
+    }
+    else {
+        entry = memory_take_entry(mem, size);
 
         if (!entry) {
             return 0;
         }
 
-        // Last entry is being included, so merge it
-        if (request_size != size) {
-            entry = entry->prev;
-            memory_merge_with_next(mem, entry);
+        if (SHOULD_SPLIT(entry, size)) {
+            memory_split_entry(mem, entry, size);
+        }
+
+        entry->magic = MAGIC_USED;
+    }
+
+    PROFILE_ALLOC(mem, entry);
+
+    return ENTRY_PTR(entry);
+}
+
+void * memory_alloc_aligned(memory_t * mem, size_t size, size_t align) {
+    if (!mem || !size || !align) {
+        return 0;
+    }
+
+    // Must be a power of 2
+    if (align & (align - 1)) {
+        return 0;
+    }
+
+    PROFILE_TAKE_CALLER(mem);
+
+    // Every allocation is already aligned to 4 bytes
+    if (align <= 4) {
+        PROFILE_PASS_CALLER(mem);
+        return memory_alloc(mem, size);
+    }
+
+    ALIGN_SIZE(size);
+
+    if (size < MIN_SIZE) {
+        size = MIN_SIZE;
+    }
+
+    // Room for the worst case gap before the aligned pointer
+    memory_entry_t * entry = memory_take_entry(mem, size + align + MIN_ENTRY_SIZE);
+
+    if (!entry) {
+        return 0;
+    }
+
+    uint32_t ptr     = (uint32_t)ENTRY_PTR(entry);
+    uint32_t aligned = (ptr + align - 1) & ~(align - 1);
+
+    if (aligned != ptr) {
+        // Gap must be large enough to be a free entry
+        while (aligned - ptr < MIN_ENTRY_SIZE) {
+            aligned += align;
         }
+
+        // Gap keeps entry and goes back to the free lists
+        memory_split_entry(mem, entry, aligned - ptr - sizeof(memory_entry_t));
+
+        memory_entry_t * gap = entry;
+
+        entry = gap->next;
+        memory_list_remove(mem, entry);
+        memory_list_push(mem, gap);
     }
 
     if (SHOULD_SPLIT(entry, size)) {
@@ -79,90 +227,131 @@ void * memory_alloc(memory_t * mem, size_t size) {
 
     entry->magic = MAGIC_USED;
 
+    PROFILE_ALLOC(mem, entry);
+
     return ENTRY_PTR(entry);
 }
 
+#ifdef MEMORY_PROFILE
+void * memory_alloc_from(memory_t * mem, size_t size, void * caller) {
+    if (!mem || !size) {
+        return 0;
+    }
+
+    mem->profile.caller = caller;
+
+    return memory_alloc(mem, size);
+}
+
+void * memory_alloc_aligned_from(memory_t * mem, size_t size, size_t align, void * caller) {
+    if (!mem || !size || !align || (align & (align - 1))) {
+        return 0;
+    }
+
+    mem->profile.caller = caller;
+
+    return memory_alloc_aligned(mem, size, align);
+}
+#endif
+
 void * memory_realloc(memory_t * mem, void * ptr, size_t size) {
     if (!mem || !ptr || !size) {
         return 0;
     }
 
-    return 0; // not implemented
+    // Will never be found
+    if (NOT_ALIGNED(ptr)) {
+        return 0;
+    }
 
-    // // Will never be found
-    // if (NOT_ALIGNED(ptr)) {
-    //     return 0;
-    // }
+    ALIGN_SIZE(size);
+
+    if (size < MIN_SIZE) {
+        size = MIN_SIZE;
+    }
 
-    // ALIGN_SIZE(size);
+    memory_entry_t * entry = memory_find_entry_ptr(mem, ptr);
 
-    // memory_entry_t * entry = memory_find_entry_ptr(mem, ptr);
+    if (!entry) {
+        entry = memory_find_large(mem, ptr);
 
-    // // Does not exist
-    // if (!entry || entry->magic != MAGIC_USED) {
-    //     return 0;
-    // }
+        if (!entry) {
+            return 0;
+        }
 
-    // // Same size
-    // if (entry->size == size) {
-    //     return ENTRY_PTR(entry);
-    // }
+        if (size <= entry->size) {
+            return ptr;
+        }
 
-    // // Shrink
-    // if (entry->size < size) {
-    //     if (SHOULD_SPLIT(entry, size) && memory_split_entry(mem, entry, size)) {
-    //         return 0;
-    //     }
+        return memory_realloc_copy(mem, entry, size);
+    }
 
-    //     return ENTRY_PTR(entry);
-    // }
+    if (entry->magic != MAGIC_USED) {
+        return 0;
+    }
 
-    // // Try to expand
-    // memory_entry_t * next_entry = entry->next;
+    PROFILE_TAKE_SIZE(entry);
 
-    // if (next_entry->magic == MAGIC_FREE) {
-    //     size_t need_size = size - entry->size;
+    memory_entry_t * next      = entry->next;
+    int              next_free = next && next->magic == MAGIC_FREE && IS_ADJACENT(entry, next);
+    size_t           available = entry->size;
+    int              at_end    = entry == mem->last;
 
-    //     while (next_entry && next_entry->size) {
-    //         if (!next_entry->next || next_entry->next->magic != MAGIC_FREE) {
-    //             break;
-    //         }
+    if (next_free) {
+        available += next->size + sizeof(memory_entry_t);
+        at_end = next == mem->last;
+    }
 
-    //         if (memory_merge_with_next(mem, next_entry)) {
-    //             return 0;
-    //         }
-    //     }
+    // Can't grow in place
+    if (available < size && !at_end) {
+        return memory_realloc_copy(mem, entry, size);
+    }
 
-    //     if (next_entry->size >= need_size) {
-    //         if (!memory_merge_with_next(mem, entry)) {
-    //             return 0;
-    //         }
+    if (available < size) {
+        size_t need = size - available;
 
-    //         if (SHOULD_SPLIT(entry, size) && memory_split_entry(mem, entry, size)) {
-    //             return 0;
-    //         }
+        if (need > sizeof(memory_entry_t)) {
+            need -= sizeof(memory_entry_t);
+        }
+        else {
+            need = 0;
+        }
 
-    //         return ENTRY_PTR(entry);
-    //     }
-    // }
+        // Add pages first so nothing changes if it fails
+        memory_entry_t * tail = memory_add_entry(mem, need);
 
-    // // Create new and copy
-    // memory_entry_t * new_entry = memory_find_entry_size(mem, size);
+        if (!tail) {
+            return 0;
+        }
 
-    // if (!new_entry) {
-    //     entry = memory_alloc(mem, size);
-    // }
+        if (tail == next) {
+            // The free next entry was merged with the new pages
+            next_free = 0;
+            memory_merge_with_next(mem, entry);
+        }
+        else if (tail->prev == entry && IS_ADJACENT(entry, tail)) {
+            memory_merge_with_next(mem, entry);
+        }
+        else {
+            // New pages did not follow the heap, they can only be used later
+            memory_list_push(mem, tail);
+            return memory_realloc_copy(mem, entry, size);
+        }
+    }
 
-    // entry->magic = MAGIC_USED;
+    if (next_free) {
+        memory_list_remove(mem, next);
+        memory_merge_with_next(mem, entry);
+    }
 
-    // char * src  = ENTRY_PTR(entry);
-    // char * dest = ENTRY_PTR(new_entry);
+    // Shrink or give back what was not needed
+    if (SHOULD_SPLIT(entry, size)) {
+        memory_split_entry(mem, entry, size);
+    }
 
-    // for (size_t i = 0; i < entry->size; i++) {
-    //     *dest++ = *src++;
-    // }
+    PROFILE_RESIZE(mem, entry);
 
-    // return ENTRY_PTR(new_entry);
+    return ptr;
 }
 
 int memory_free(memory_t * mem, void * ptr) {
@@ -178,18 +367,93 @@ int memory_free(memory_t * mem, void * ptr) {
     memory_entry_t * entry = memory_find_entry_ptr(mem, ptr);
 
     if (!entry) {
+        entry = memory_find_large(mem, ptr);
+
+        if (!entry) {
+            return -1;
+        }
+
+        memory_free_large(mem, entry);
+
+        return 0;
+    }
+
+    if (entry->magic != MAGIC_USED) {
         return -1;
     }
 
+    PROFILE_FREE(mem, entry);
+
     entry->magic = MAGIC_FREE;
 
+    // Neighbours are never free, so joining both sides keeps it that way
+    if (entry->next && entry->next->magic == MAGIC_FREE && IS_ADJACENT(entry, entry->next)) {
+        memory_list_remove(mem, entry->next);
+        memory_merge_with_next(mem, entry);
+    }
+
+    if (entry->prev && entry->prev->magic == MAGIC_FREE && IS_ADJACENT(entry->prev, entry)) {
+        entry = entry->prev;
+        memory_list_remove(mem, entry);
+        memory_merge_with_next(mem, entry);
+    }
+
+    if (mem->free_pages_fn) {
+        memory_release_pages(mem, entry);
+    }
+    else {
+        memory_list_push(mem, entry);
+    }
+
+    return 0;
+}
+
+void * memory_alloc_pages(memory_t * mem, size_t count) {
+    if (!mem || !count) {
+        return 0;
+    }
+
+    void * addr = mem->alloc_pages_fn(count);
+
+    if (!addr) {
+        return 0;
+    }
+
+    uint32_t start = (uint32_t)addr;
+
+    if (memory_range_take(mem, start, start + count * PAGE_SIZE)) {
+        mem->free_pages_fn(addr, count);
+        return 0;
+    }
+
+    return addr;
+}
+
+int memory_free_pages(memory_t * mem, void * addr, size_t count) {
+    if (!mem || !addr || !count || NOT_PAGE_ALIGNED(addr)) {
+        return -1;
+    }
+
+    if (!mem->free_pages_fn || mem->released_count == MEMORY_RELEASED_MAX) {
+        return -1;
+    }
+
+    if (mem->free_pages_fn(addr, count)) {
+        return -1;
+    }
+
+    uint32_t start = (uint32_t)addr;
+
+    memory_range_release(mem, start, start + count * PAGE_SIZE);
+
     return 0;
 }
 
 /**
  * @brief Split a memory entry such that the first entry is at least `size`.
  *
- * If the entry cannot be split, this function will fail.
+ * If the entry cannot be split, this function will fail. The new entry after
+ * `entry` is free and will be added to the free lists.
  *
  * @param mem pointer to the memory allocator
  * @param entry pointer to the memory entry
@@ -213,13 +477,15 @@ static void memory_split_entry(memory_t * mem, memory_entry_t * entry, size_t si
 
     entry->next = new_entry;
     entry->size = size;
+
+    memory_list_push(mem, new_entry);
 }
 
 /**
  * @brief Merge `entry` and the next.
  *
- * If the next entry is not free or there is no next entry, this function will
- * fail.
+ * If the next entry is not free, is not adjacent or there is no next entry,
+ * this function will fail. Neither entry may be in the free lists.
  *
  * @param mem pointer to the memory allocator
  * @param entry pointer to the memory entry
@@ -240,73 +506,200 @@ static void memory_merge_with_next(memory_t * mem, memory_entry_t * entry) {
 }
 
 /**
- * @brief Find a memory entry that is free and is at least `size` bytes.
+ * @brief Get the size class of a free entry with `size` bytes.
+ *
+ * Sizes below `MEMORY_SMALL_CLASS_MAX` have one class for each multiple of 4.
+ * Larger sizes are grouped by their highest set bit.
+ *
+ * @param size number of bytes, aligned to 4 bytes
+ * @return size_t class index
+ */
+static size_t memory_class(size_t size) {
+    if (size < MEMORY_SMALL_CLASS_MAX) {
+        return size >> 2;
+    }
+
+    return MEMORY_SMALL_CLASS_COUNT + (31 - __builtin_clz(size)) - 7;
+}
+
+/**
+ * @brief Find the first class at or above `class` that has a free entry.
  *
- * This function will join any adjacent free entries while searching. If the
- * memory entry is larger than size, it will not be split.
+ * @param mem pointer to the memory allocator
+ * @param class first class to check
+ * @return size_t class index or `MEMORY_CLASS_COUNT` if all are empty
+ */
+static size_t memory_next_class(memory_t * mem, size_t class) {
+    while (class < MEMORY_CLASS_COUNT) {
+        uint32_t bits = mem->class_mask[class >> 5] >> (class & 0x1f);
+
+        if (bits) {
+            return class + __builtin_ctz(bits);
+        }
+
+        class = (class | 0x1f) + 1;
+    }
+
+    return MEMORY_CLASS_COUNT;
+}
+
+/**
+ * @brief Add a free entry to the head of it's class list.
  *
  * @param mem pointer to the memory allocator
- * @param size minimum number of bytes
- * @return memory_entry_t* pointer to the memory entry
+ * @param entry pointer to the free memory entry
  */
-static memory_entry_t * memory_find_entry_size(memory_t * mem, size_t size) {
-    memory_entry_t * entry = mem->first;
+static void memory_list_push(memory_t * mem, memory_entry_t * entry) {
+    size_t        class = memory_class(entry->size);
+    free_link_t * link  = FREE_LINK(entry);
 
-    while (entry) {
-        if (entry->magic == MAGIC_FREE) {
-            memory_entry_t * next_entry = entry->next;
+    link->prev = 0;
+    link->next = mem->free_lists[class];
 
-            while (entry->size < size && next_entry) {
-                if (next_entry->magic != MAGIC_FREE) {
-                    break;
-                }
+    if (link->next) {
+        FREE_LINK(link->next)->prev = entry;
+    }
 
-                memory_merge_with_next(mem, entry);
+    mem->free_lists[class] = entry;
+    mem->class_mask[class >> 5] |= 1 << (class & 0x1f);
+}
 
-                if (entry->size >= size) {
-                    break;
-                }
+/**
+ * @brief Remove a free entry from it's class list.
+ *
+ * The entry size must not have changed since it was added.
+ *
+ * @param mem pointer to the memory allocator
+ * @param entry pointer to the free memory entry
+ */
+static void memory_list_remove(memory_t * mem, memory_entry_t * entry) {
+    size_t        class = memory_class(entry->size);
+    free_link_t * link  = FREE_LINK(entry);
 
-                next_entry = entry->next;
-            }
+    if (link->prev) {
+        FREE_LINK(link->prev)->next = link->next;
+    }
+    else {
+        mem->free_lists[class] = link->next;
+
+        if (!link->next) {
+            mem->class_mask[class >> 5] &= ~(1 << (class & 0x1f));
+        }
+    }
 
+    if (link->next) {
+        FREE_LINK(link->next)->prev = link->prev;
+    }
+}
+
+/**
+ * @brief Find a memory entry that is free and is at least `size` bytes.
+ *
+ * Small classes hold a single size, so the head of the first non-empty class
+ * is used. Large classes hold a range of sizes, so the class of `size` is
+ * searched before moving to the next class. If the memory entry is larger than
+ * size, it will not be split.
+ *
+ * @param mem pointer to the memory allocator
+ * @param size minimum number of bytes
+ * @return memory_entry_t* pointer to the memory entry
+ */
+static memory_entry_t * memory_find_entry_size(memory_t * mem, size_t size) {
+    size_t class = memory_class(size);
+
+    if (class >= MEMORY_SMALL_CLASS_COUNT) {
+        memory_entry_t * entry = mem->free_lists[class];
+
+        while (entry) {
             if (entry->size >= size) {
                 return entry;
             }
+
+            entry = FREE_LINK(entry)->next;
         }
 
-        entry = entry->next;
+        class++;
     }
 
-    return 0;
+    class = memory_next_class(mem, class);
+
+    if (class >= MEMORY_CLASS_COUNT) {
+        return 0;
+    }
+
+    return mem->free_lists[class];
+}
+
+/**
+ * @brief Get a free entry of at least `size` bytes, adding pages if needed.
+ *
+ * The entry is removed from the free lists but is not split or marked used.
+ *
+ * @param mem pointer to the memory allocator
+ * @param size minimum number of bytes
+ * @return memory_entry_t* pointer to the memory entry or 0 for fail
+ */
+static memory_entry_t * memory_take_entry(memory_t * mem, size_t size) {
+    memory_entry_t * entry = memory_find_entry_size(mem, size);
+
+    if (entry) {
+        memory_list_remove(mem, entry);
+        return entry;
+    }
+
+    size_t request_size = size;
+
+    // Last entry will be merged with new entry
+    if (mem->last->magic == MAGIC_FREE) {
+        request_size -= mem->last->size - sizeof(memory_entry_t);
+    }
+
+    entry = memory_add_entry(mem, request_size);
+
+    // New pages did not follow the last entry, so it was not merged
+    if (entry && entry->size < size) {
+        memory_list_push(mem, entry);
+        entry = memory_add_entry(mem, size);
+    }
+
+    return entry;
 }
 
 /**
  * @brief Find a memory entry from it's allocated pointer.
  *
- * `ptr` is the value returned by `memory_alloc`.
+ * `ptr` is the value returned by `memory_alloc`. The entry header sits
+ * directly before `ptr`, so it is only read after checking that it is inside
+ * the heap and not in pages that were given back.
  *
  * @param mem pointer to the memory allocator
  * @param ptr pointer to the allocated memory
  * @return memory_entry_t* pointer to the memory entry
  */
 static memory_entry_t * memory_find_entry_ptr(memory_t * mem, void * ptr) {
-    memory_entry_t * entry = mem->first;
+    memory_entry_t * entry = (memory_entry_t *)((uint32_t)ptr - sizeof(memory_entry_t));
 
-    while (entry) {
-        if (ENTRY_PTR(entry) == ptr) {
-            return entry;
-        }
+    if (entry < mem->first || entry > mem->last) {
+        return 0;
+    }
 
-        entry = entry->next;
+    if (memory_range_released(mem, (uint32_t)entry, (uint32_t)ENTRY_PTR(entry))) {
+        return 0;
     }
 
-    return 0;
+    if (entry->magic != MAGIC_USED && entry->magic != MAGIC_FREE) {
+        return 0;
+    }
+
+    return entry;
 }
 
 /**
  * @brief Allocate new pages to create a new memory entry.
  *
+ * If the new pages follow a free last entry, the two are merged. The returned
+ * entry is free but is not in the free lists.
+ *
  * @param mem pointer to the memory allocator
  * @param size minimum number of bytes
  * @return memory_entry_t* pointer to the new entry
@@ -319,7 +712,7 @@ static memory_entry_t * memory_add_entry(memory_t * mem, size_t size) {
         pages++;
     }
 
-    void * new_pages = mem->alloc_pages_fn(pages);
+    void * new_pages = memory_alloc_pages(mem, pages);
     if (!new_pages) {
         return 0;
     }
@@ -328,9 +721,510 @@ static memory_entry_t * memory_add_entry(memory_t * mem, size_t size) {
 
     entry->magic    = MAGIC_FREE;
     entry->size     = pages * PAGE_SIZE - sizeof(memory_entry_t);
+    entry->next     = 0;
     entry->prev     = mem->last;
     mem->last->next = entry;
     mem->last       = entry;
 
+    memory_entry_t * prev = entry->prev;
+
+    if (prev->magic == MAGIC_FREE && IS_ADJACENT(prev, entry)) {
+        memory_list_remove(mem, prev);
+        memory_merge_with_next(mem, prev);
+        entry = prev;
+    }
+
     return entry;
 }
+
+/**
+ * @brief Move an entry to a new allocation of `size` bytes.
+ *
+ * The contents of `entry` are copied and it is freed. If the new allocation
+ * fails, `entry` is not changed.
+ *
+ * @param mem pointer to the memory allocator
+ * @param entry pointer to the used memory entry
+ * @param size number of bytes for the new allocation, larger than entry
+ * @return void* pointer to the new allocation or 0 for fail
+ */
+static void * memory_realloc_copy(memory_t * mem, memory_entry_t * entry, size_t size) {
+    // Moved memory is recorded as a new allocation from the same site
+    PROFILE_PASS_SITE(mem, entry);
+
+    void * new_ptr = memory_alloc(mem, size);
+
+    if (!new_ptr) {
+        return 0;
+    }
+
+    uint32_t * src  = ENTRY_PTR(entry);
+    uint32_t * dest = new_ptr;
+
+    for (size_t i = 0; i < entry->size >> 2; i++) {
+        dest[i] = src[i];
+    }
+
+    memory_free(mem, ENTRY_PTR(entry));
+
+    return new_ptr;
+}
+
+/**
+ * @brief Release the whole pages inside a free entry.
+ *
+ * The part of `entry` before the first whole page and after the last whole
+ * page are kept as free entries if they are large enough, otherwise one less
+ * page is released. The first entry always keeps it's header so the heap is
+ * never empty. All kept entries are added to the free lists, if no pages are
+ * released `entry` is added unchanged. Released pages are tracked so their
+ * headers are never read again.
+ *
+ * @param mem pointer to the memory allocator
+ * @param entry pointer to the free memory entry, not in the free lists
+ */
+static void memory_release_pages(memory_t * mem, memory_entry_t * entry) {
+    uint32_t start = (uint32_t)entry;
+    uint32_t end   = ENTRY_END(entry);
+
+    uint32_t release_start = start;
+    uint32_t release_end   = PAGE_ALIGN_DOWN(end);
+
+    if (NOT_PAGE_ALIGNED(start) || entry == mem->first) {
+        release_start = PAGE_ALIGN_UP(start + MIN_ENTRY_SIZE);
+    }
+
+    if (release_end != end && end - release_end < MIN_ENTRY_SIZE) {
+        release_end -= PAGE_SIZE;
+    }
+
+    if (release_end <= release_start || release_end > end) {
+        memory_list_push(mem, entry);
+        return;
+    }
+
+    memory_entry_t * prev = entry->prev;
+    memory_entry_t * next = entry->next;
+
+    // Entry header may be in the released pages, so read it first
+    if (memory_free_pages(mem, (void *)release_start, (release_end - release_start) >> 12)) {
+        memory_list_push(mem, entry);
+        return;
+    }
+
+    memory_entry_t * head = 0;
+    memory_entry_t * tail = 0;
+
+    if (release_start != start) {
+        head       = entry;
+        head->size = release_start - (uint32_t)ENTRY_PTR(head);
+        memory_list_push(mem, head);
+    }
+
+    if (release_end != end) {
+        tail        = (memory_entry_t *)release_end;
+        tail->magic = MAGIC_FREE;
+        tail->size  = end - release_end - sizeof(memory_entry_t);
+        memory_list_push(mem, tail);
+    }
+
+    // The first entry always has a head, so there is always an entry before
+    memory_entry_t * before = head ? head : prev;
+    memory_entry_t * after  = tail ? tail : next;
+
+    before->next = after;
+
+    if (tail) {
+        tail->prev = before;
+        tail->next = next;
+    }
+
+    if (next) {
+        next->prev = tail ? tail : before;
+    }
+    else {
+        mem->last = after ? after : before;
+    }
+}
+
+/**
+ * @brief Allocate pages for a single large allocation.
+ *
+ * The entry header is at the start of the first page and the entry is added
+ * to the large list instead of the heap.
+ *
+ * @param mem pointer to the memory allocator
+ * @param size minimum number of bytes
+ * @return memory_entry_t* pointer to the large memory entry or 0 for fail
+ */
+static memory_entry_t * memory_alloc_large(memory_t * mem, size_t size) {
+    size_t pages = PAGE_ALIGN_UP(size + sizeof(memory_entry_t)) >> 12;
+
+    memory_entry_t * entry = memory_alloc_pages(mem, pages);
+
+    if (!entry) {
+        return 0;
+    }
+
+    entry->magic = MAGIC_LARGE;
+    entry->size  = pages * PAGE_SIZE - sizeof(memory_entry_t);
+    entry->prev  = 0;
+    entry->next  = mem->large;
+
+    if (entry->next) {
+        entry->next->prev = entry;
+    }
+
+    mem->large = entry;
+
+    return entry;
+}
+
+/**
+ * @brief Find a large allocation from it's allocated pointer.
+ *
+ * Large allocations are outside the heap, so the list is searched instead of
+ * reading a header that may not be mapped.
+ *
+ * @param mem pointer to the memory allocator
+ * @param ptr pointer to the allocated memory
+ * @return memory_entry_t* pointer to the memory entry or 0 if not found
+ */
+static memory_entry_t * memory_find_large(memory_t * mem, void * ptr) {
+    memory_entry_t * entry = mem->large;
+
+    while (entry) {
+        if (ENTRY_PTR(entry) == ptr) {
+            return entry;
+        }
+
+        entry = entry->next;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Release the pages of a large allocation.
+ *
+ * The entry is always removed from the large list. If the pages can't be
+ * given back, they are kept by the heap as a new free entry instead.
+ *
+ * @param mem pointer to the memory allocator
+ * @param entry pointer to the large memory entry
+ */
+static void memory_free_large(memory_t * mem, memory_entry_t * entry) {
+    memory_entry_t * prev  = entry->prev;
+    memory_entry_t * next  = entry->next;
+    size_t           pages = (entry->size + sizeof(memory_entry_t)) >> 12;
+
+    if (prev) {
+        prev->next = next;
+    }
+    else {
+        mem->large = next;
+    }
+
+    if (next) {
+        next->prev = prev;
+    }
+
+    // Header is gone once the pages are released, either way the bytes are no
+    // longer live
+    PROFILE_FREE(mem, entry);
+
+    if (!memory_free_pages(mem, entry, pages)) {
+        return;
+    }
+
+    entry->magic    = MAGIC_FREE;
+    entry->next     = 0;
+    entry->prev     = mem->last;
+    mem->last->next = entry;
+    mem->last       = entry;
+
+    memory_entry_t * heap_prev = entry->prev;
+
+    if (heap_prev->magic == MAGIC_FREE && IS_ADJACENT(heap_prev, entry)) {
+        memory_list_remove(mem, heap_prev);
+        memory_merge_with_next(mem, heap_prev);
+        entry = heap_prev;
+    }
+
+    memory_list_push(mem, entry);
+}
+
+/**
+ * @brief Check if any byte from `start` to `end` is in released pages.
+ *
+ * @param mem pointer to the memory allocator
+ * @param start first address
+ * @param end address after the last byte
+ * @return int 1 if any byte was released, otherwise 0
+ */
+static int memory_range_released(memory_t * mem, uint32_t start, uint32_t end) {
+    for (size_t i = 0; i < mem->released_count; i++) {
+        memory_range_t * range = &mem->released[i];
+
+        if (range->start < end && start < range->end) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Track pages that were given back through `free_pages_fn`.
+ *
+ * Ranges that touch the new range are joined with it. The caller must check
+ * that there is room for one more range.
+ *
+ * @param mem pointer to the memory allocator
+ * @param start address of the first page
+ * @param end address after the last page
+ */
+static void memory_range_release(memory_t * mem, uint32_t start, uint32_t end) {
+    for (size_t i = 0; i < mem->released_count;) {
+        memory_range_t * range = &mem->released[i];
+
+        if (range->start <= end && start <= range->end) {
+            if (range->start < start) {
+                start = range->start;
+            }
+
+            if (range->end > end) {
+                end = range->end;
+            }
+
+            *range = mem->released[--mem->released_count];
+            continue;
+        }
+
+        i++;
+    }
+
+    mem->released[mem->released_count++] = (memory_range_t){start, end};
+}
+
+/**
+ * @brief Stop tracking pages that came back from `alloc_pages_fn`.
+ *
+ * A released range that holds the new pages in it's middle is split in two,
+ * which fails if there is no room for another range.
+ *
+ * @param mem pointer to the memory allocator
+ * @param start address of the first page
+ * @param end address after the last page
+ * @return int 0 for success
+ */
+static int memory_range_take(memory_t * mem, uint32_t start, uint32_t end) {
+    for (size_t i = 0; i < mem->released_count;) {
+        memory_range_t * range = &mem->released[i];
+
+        if (range->end <= start || end <= range->start) {
+            i++;
+            continue;
+        }
+
+        // Ranges never overlap, so no other range needs to change
+        if (range->start < start && end < range->end) {
+            if (mem->released_count == MEMORY_RELEASED_MAX) {
+                return -1;
+            }
+
+            mem->released[mem->released_count++] = (memory_range_t){end, range->end};
+            range->end                           = start;
+            return 0;
+        }
+
+        if (range->start < start) {
+            range->end = start;
+        }
+        else if (end < range->end) {
+            range->start = end;
+        }
+        else {
+            *range = mem->released[--mem->released_count];
+            continue;
+        }
+
+        i++;
+    }
+
+    return 0;
+}
+
+int memory_profile_top(memory_t * mem, memory_profile_site_t * out, size_t count, enum MEMORY_PROFILE_SORT sort) {
+#ifdef MEMORY_PROFILE
+    if (!mem || !out) {
+        return -1;
+    }
+
+    size_t found = 0;
+
+    // Insertion sort into out, only the top count are kept
+    for (size_t i = 0; i < MEMORY_PROFILE_SITES; i++) {
+        memory_profile_site_t * site = &mem->profile.sites[i];
+
+        if (!site->caller) {
+            continue;
+        }
+
+        size_t pos = found;
+
+        while (pos > 0 && memory_profile_before(site, &out[pos - 1], sort)) {
+            pos--;
+        }
+
+        if (pos >= count) {
+            continue;
+        }
+
+        if (found < count) {
+            found++;
+        }
+
+        for (size_t j = found - 1; j > pos; j--) {
+            out[j] = out[j - 1];
+        }
+
+        out[pos] = *site;
+    }
+
+    return found;
+#else
+    return -1;
+#endif
+}
+
+#ifdef MEMORY_PROFILE
+/**
+ * @brief Get the caller an allocation is recorded for.
+ *
+ * A caller passed down by `memory_alloc_from` or an internal call is used
+ * once, otherwise the allocation is recorded for `return_addr`.
+ *
+ * @param mem pointer to the memory allocator
+ * @param return_addr return address of the public function
+ * @return void* address the allocation is recorded for
+ */
+static void * memory_profile_take_caller(memory_t * mem, void * return_addr) {
+    void * caller = mem->profile.caller;
+
+    if (!caller) {
+        return return_addr;
+    }
+
+    mem->profile.caller = 0;
+
+    return caller;
+}
+
+/**
+ * @brief Pass the caller `entry` was recorded for to the next allocation.
+ *
+ * @param mem pointer to the memory allocator
+ * @param entry pointer to the used memory entry
+ */
+static void memory_profile_pass_site(memory_t * mem, memory_entry_t * entry) {
+    if (entry->site) {
+        mem->profile.caller = mem->profile.sites[entry->site - 1].caller;
+    }
+}
+
+/**
+ * @brief Record a new allocation for `caller`.
+ *
+ * Sites are found by hashing the caller address into the table with linear
+ * probing. If the table is full, the allocation is counted as dropped and
+ * `entry` is not tracked.
+ *
+ * @param mem pointer to the memory allocator
+ * @param entry pointer to the newly used memory entry
+ * @param caller address the allocation is recorded for
+ */
+static void memory_profile_alloc(memory_t * mem, memory_entry_t * entry, void * caller) {
+    size_t index = ((uint32_t)caller >> 2) % MEMORY_PROFILE_SITES;
+
+    entry->site = 0;
+    entry->tick = mem->profile.clock++;
+
+    for (size_t i = 0; i < MEMORY_PROFILE_SITES; i++) {
+        memory_profile_site_t * site = &mem->profile.sites[index];
+
+        if (!site->caller) {
+            site->caller = caller;
+        }
+
+        if (site->caller == caller) {
+            site->alloc_count++;
+            site->alloc_bytes += entry->size;
+            site->live_count++;
+            site->live_bytes += entry->size;
+
+            entry->site = index + 1;
+            return;
+        }
+
+        index = (index + 1) % MEMORY_PROFILE_SITES;
+    }
+
+    mem->profile.dropped++;
+}
+
+/**
+ * @brief Update the live bytes of a site after an entry was resized in place.
+ *
+ * @param mem pointer to the memory allocator
+ * @param entry pointer to the used memory entry
+ * @param old_size size of `entry` before it was resized
+ */
+static void memory_profile_resize(memory_t * mem, memory_entry_t * entry, size_t old_size) {
+    if (!entry->site) {
+        return;
+    }
+
+    memory_profile_site_t * site = &mem->profile.sites[entry->site - 1];
+
+    site->live_bytes += entry->size - old_size;
+}
+
+/**
+ * @brief Record that an allocation is freed.
+ *
+ * Must be called before `entry` is merged or released.
+ *
+ * @param mem pointer to the memory allocator
+ * @param entry pointer to the used memory entry
+ */
+static void memory_profile_free(memory_t * mem, memory_entry_t * entry) {
+    if (!entry->site) {
+        return;
+    }
+
+    memory_profile_site_t * site = &mem->profile.sites[entry->site - 1];
+
+    site->live_count--;
+    site->live_bytes -= entry->size;
+    site->lifetime += mem->profile.clock - entry->tick;
+
+    entry->site = 0;
+}
+
+/**
+ * @brief Check if site `a` should be listed before site `b`.
+ *
+ * @param a pointer to the first site
+ * @param b pointer to the second site
+ * @param sort order of the sites
+ * @return int 1 if `a` is before `b`
+ */
+static int memory_profile_before(memory_profile_site_t * a, memory_profile_site_t * b, enum MEMORY_PROFILE_SORT sort) {
+    if (sort == MEMORY_PROFILE_SORT_COUNT) {
+        return a->alloc_count > b->alloc_count;
+    }
+
+    return a->alloc_bytes > b->alloc_bytes;
+}
+#endif
@@ -0,0 +1,278 @@
+#include "memory_cache.h"
+
+#define PAGE_SIZE 4096
+
+#define MAGIC_SLAB 0x534c4142
+
+#define SLAB_FROM_OBJ(OBJ)    ((memory_slab_t *)((uint32_t)(OBJ) & ~0xfff))
+#define SLAB_OBJ(CACHE, S, I) ((void *)((uint32_t)(S)->objects + (I) * (CACHE)->obj_size))
+
+// Free bitmap comes right after the free stack, one bit per object
+#define SLAB_FREE_BITS(CACHE, S) ((uint8_t *)&(S)->free_stack[(CACHE)->slab_obj_count])
+#define BIT_IS_SET(BITS, I)      ((BITS)[(I) >> 3] & (1 << ((I) & 0x7)))
+#define BIT_SET(BITS, I)         ((BITS)[(I) >> 3] |= (1 << ((I) & 0x7)))
+#define BIT_CLEAR(BITS, I)       ((BITS)[(I) >> 3] &= ~(1 << ((I) & 0x7)))
+
+#define ALIGN_SIZE(SIZE)                   \
+    if ((SIZE) & 0x3) {                    \
+        (SIZE) = (((SIZE) >> 2) + 1) << 2; \
+    }
+
+static size_t          slab_header_size(size_t obj_count);
+static memory_slab_t * memory_cache_add_slab(memory_cache_t * cache);
+static void            slab_list_push(memory_slab_t ** list, memory_slab_t * slab);
+static void            slab_list_remove(memory_slab_t ** list, memory_slab_t * slab);
+static int             slab_list_release(memory_cache_t * cache, memory_slab_t * list);
+
+int memory_cache_init(memory_cache_t * cache, memory_t * mem, size_t obj_size, memory_cache_ctor_t ctor) {
+    if (!cache || !mem || !obj_size) {
+        return -1;
+    }
+
+    ALIGN_SIZE(obj_size);
+
+    if (obj_size + slab_header_size(1) > PAGE_SIZE) {
+        return -1;
+    }
+
+    // Each object also needs an entry in the free stack and a free bit
+    size_t obj_count = (PAGE_SIZE - sizeof(memory_slab_t)) / (obj_size + sizeof(uint16_t));
+
+    // Header is aligned up, which can take the space of the last object
+    while (slab_header_size(obj_count) + obj_count * obj_size > PAGE_SIZE) {
+        obj_count--;
+    }
+
+    cache->mem            = mem;
+    cache->obj_size       = obj_size;
+    cache->slab_obj_count = obj_count;
+    cache->ctor           = ctor;
+    cache->partial        = 0;
+    cache->full           = 0;
+
+    return 0;
+}
+
+void * memory_cache_alloc(memory_cache_t * cache) {
+    if (!cache) {
+        return 0;
+    }
+
+    memory_slab_t * slab = cache->partial;
+
+    if (!slab) {
+        slab = memory_cache_add_slab(cache);
+
+        if (!slab) {
+            return 0;
+        }
+    }
+
+    uint16_t index = slab->free_stack[--slab->free_count];
+
+    BIT_CLEAR(SLAB_FREE_BITS(cache, slab), index);
+
+    if (!slab->free_count) {
+        slab_list_remove(&cache->partial, slab);
+        slab_list_push(&cache->full, slab);
+    }
+
+    return SLAB_OBJ(cache, slab, index);
+}
+
+int memory_cache_free(memory_cache_t * cache, void * obj) {
+    if (!cache || !obj) {
+        return -1;
+    }
+
+    memory_slab_t * slab = SLAB_FROM_OBJ(obj);
+
+    if (slab->magic != MAGIC_SLAB || slab->cache != cache) {
+        return -1;
+    }
+
+    if ((uint32_t)obj < (uint32_t)slab->objects) {
+        return -1;
+    }
+
+    uint32_t offset = (uint32_t)obj - (uint32_t)slab->objects;
+
+    if (offset % cache->obj_size) {
+        return -1;
+    }
+
+    uint16_t  index     = offset / cache->obj_size;
+    uint8_t * free_bits = SLAB_FREE_BITS(cache, slab);
+
+    if (index >= cache->slab_obj_count) {
+        return -1;
+    }
+
+    // Object is already free
+    if (BIT_IS_SET(free_bits, index)) {
+        return -1;
+    }
+
+    if (!slab->free_count) {
+        slab_list_remove(&cache->full, slab);
+        slab_list_push(&cache->partial, slab);
+    }
+
+    BIT_SET(free_bits, index);
+    slab->free_stack[slab->free_count++] = index;
+
+    // Keep one empty slab so a single object going back and forth doesn't
+    // allocate and release a page each time
+    if (slab->free_count == cache->slab_obj_count && cache->mem->free_pages_fn) {
+        if (slab->prev || slab->next) {
+            slab_list_remove(&cache->partial, slab);
+            slab->magic = 0;
+
+            if (memory_free_pages(cache->mem, slab, 1)) {
+                slab->magic = MAGIC_SLAB;
+                slab_list_push(&cache->partial, slab);
+            }
+        }
+    }
+
+    return 0;
+}
+
+int memory_cache_destroy(memory_cache_t * cache) {
+    if (!cache || !cache->mem->free_pages_fn) {
+        return -1;
+    }
+
+    int res = 0;
+
+    if (slab_list_release(cache, cache->partial)) {
+        res = -1;
+    }
+
+    if (slab_list_release(cache, cache->full)) {
+        res = -1;
+    }
+
+    cache->partial = 0;
+    cache->full    = 0;
+
+    return res;
+}
+
+/**
+ * @brief Get the size of a slab header with room for `obj_count` objects.
+ *
+ * The header holds the free stack and the free bitmap. The size is aligned to
+ * 4 bytes so objects are aligned.
+ *
+ * @param obj_count number of objects in the slab
+ * @return size_t number of bytes
+ */
+static size_t slab_header_size(size_t obj_count) {
+    size_t size = sizeof(memory_slab_t) + obj_count * sizeof(uint16_t) + (obj_count + 7) / 8;
+
+    ALIGN_SIZE(size);
+
+    return size;
+}
+
+/**
+ * @brief Allocate a page for a new slab and add it to the partial list.
+ *
+ * All objects are pushed to the free stack, marked free in the free bitmap and
+ * constructed if the cache has a constructor.
+ *
+ * @param cache pointer to the object cache
+ * @return memory_slab_t* pointer to the new slab or 0 for fail
+ */
+static memory_slab_t * memory_cache_add_slab(memory_cache_t * cache) {
+    memory_slab_t * slab = memory_alloc_pages(cache->mem, 1);
+
+    if (!slab) {
+        return 0;
+    }
+
+    slab->magic      = MAGIC_SLAB;
+    slab->cache      = cache;
+    slab->objects    = (void *)((uint32_t)slab + slab_header_size(cache->slab_obj_count));
+    slab->free_count = cache->slab_obj_count;
+
+    uint8_t * free_bits = SLAB_FREE_BITS(cache, slab);
+
+    // Lowest address is at the top of the stack
+    for (size_t i = 0; i < cache->slab_obj_count; i++) {
+        slab->free_stack[i] = cache->slab_obj_count - i - 1;
+        BIT_SET(free_bits, i);
+
+        if (cache->ctor) {
+            cache->ctor(SLAB_OBJ(cache, slab, i));
+        }
+    }
+
+    slab_list_push(&cache->partial, slab);
+
+    return slab;
+}
+
+/**
+ * @brief Add a slab to the head of a slab list.
+ *
+ * @param list pointer to the list head
+ * @param slab pointer to the slab
+ */
+static void slab_list_push(memory_slab_t ** list, memory_slab_t * slab) {
+    slab->prev = 0;
+    slab->next = *list;
+
+    if (slab->next) {
+        slab->next->prev = slab;
+    }
+
+    *list = slab;
+}
+
+/**
+ * @brief Remove a slab from a slab list.
+ *
+ * @param list pointer to the list head
+ * @param slab pointer to the slab, which must be in `list`
+ */
+static void slab_list_remove(memory_slab_t ** list, memory_slab_t * slab) {
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    }
+    else {
+        *list = slab->next;
+    }
+
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+}
+
+/**
+ * @brief Release the page of every slab in a list.
+ *
+ * The list is not changed, so the caller must drop it.
+ *
+ * @param cache pointer to the object cache
+ * @param list head of the slab list
+ * @return int 0 for success, -1 if any page could not be released
+ */
+static int slab_list_release(memory_cache_t * cache, memory_slab_t * list) {
+    int res = 0;
+
+    while (list) {
+        memory_slab_t * next = list->next;
+
+        list->magic = 0;
+
+        if (memory_free_pages(cache->mem, list, 1)) {
+            res = -1;
+        }
+
+        list = next;
+    }
+
+    return res;
+}
@@ -39,4 +39,15 @@ typedef void * v_ptr_t;
 #define VADDR_ISR_STACK    0xffffffff
 #define ISR_STACK_PAGES    0x10
 
+// Directory entry for the RAM frame database, shared by every page directory
+// like the first table
+#define FRAME_DB_DIR_INDEX 1021
+#define VADDR_FRAME_DB     0xff400000
+
+// Directory entry mapped back to its own directory, so the tables of the
+// active address space are visible in the 4 MiB below the stack table
+#define RECURSIVE_DIR_INDEX    1022
+#define VADDR_RECURSIVE_TABLES 0xff800000
+#define VADDR_RECURSIVE_DIR    (VADDR_RECURSIVE_TABLES + PAGE2ADDR(RECURSIVE_DIR_INDEX))
+
 #endif // ADDR_H
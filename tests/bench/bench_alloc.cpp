@@ -0,0 +1,601 @@
+// Allocator benchmarks
+//
+// Replays allocation traces through memory_alloc and runs ram_page_alloc,
+// cb_* and arr_* against a page pool on the host. Each benchmark reports
+// operations per second, the peak number of pages taken from the pool and the
+// fragmentation of the heap at the end of the run.
+//
+// Usage: bench_alloc [options]
+//
+//   --iterations N   number of runs for each benchmark (default 200)
+//   --trace-dir DIR  directory with the *.trace files
+//   --save FILE      write the results to FILE
+//   --compare FILE   compare with results from --save, exit 1 on regression
+//   --threshold PCT  allowed drop in ops/sec before it is a regression
+//                    (default 10)
+//
+// See traces/boot.trace for the trace format.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "libc/datastruct/array.h"
+#include "libc/datastruct/circular_buffer.h"
+#include "libc/memory.h"
+#include "memory_alloc.h"
+#include "ram.h"
+}
+
+#define MAGIC_FREE 0x46524545
+
+#define POOL_PAGE_COUNT 4096
+#define RAM_PAGE_COUNT  1024
+
+// Fragmentation can move a little with unrelated changes
+#define FRAG_TOLERANCE 1.0
+
+// -----------------------------------------------------------------------------
+// Page pool
+
+alignas(PAGE_SIZE) static char pool[PAGE_SIZE * POOL_PAGE_COUNT];
+static bool   pool_used[POOL_PAGE_COUNT];
+static size_t pool_held;
+static size_t pool_peak;
+
+static void pool_reset() {
+    memset(pool_used, 0, sizeof(pool_used));
+    pool_held = 0;
+    pool_peak = 0;
+}
+
+// First fit, so the heap grows up through the pool like the kernel heap does
+static void * pool_alloc_pages(size_t count) {
+    size_t run = 0;
+
+    for (size_t i = 0; i < POOL_PAGE_COUNT; i++) {
+        run = pool_used[i] ? 0 : run + 1;
+
+        if (run == count) {
+            size_t start = i + 1 - count;
+
+            for (size_t p = start; p <= i; p++) {
+                pool_used[p] = true;
+            }
+
+            pool_held += count;
+            if (pool_held > pool_peak) {
+                pool_peak = pool_held;
+            }
+
+            return pool + start * PAGE_SIZE;
+        }
+    }
+
+    return 0;
+}
+
+static int pool_free_pages(void * addr, size_t count) {
+    size_t start = ((char *)addr - pool) / PAGE_SIZE;
+
+    if (start + count > POOL_PAGE_COUNT) {
+        return -1;
+    }
+
+    for (size_t p = start; p < start + count; p++) {
+        pool_used[p] = false;
+    }
+
+    pool_held -= count;
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Benchmarks
+
+struct Run {
+    size_t ops = 0;
+    double ns  = 0;
+    // Negative if the benchmark does not use the heap
+    double peak_kib = -1;
+    double frag_pct = -1;
+};
+
+class Timer {
+    std::chrono::steady_clock::time_point start;
+
+public:
+    Timer() : start(std::chrono::steady_clock::now()) {}
+
+    double ns() const {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+static memory_t heap;
+
+static bool heap_init() {
+    pool_reset();
+
+    if (memory_init(&heap, pool_alloc_pages, pool_free_pages)) {
+        return false;
+    }
+
+    // arr_* and cb_* allocate with pmalloc
+    init_malloc(&heap);
+
+    return true;
+}
+
+// Free bytes outside of the largest free entry, as a percent of all free bytes
+static double heap_fragmentation() {
+    size_t total   = 0;
+    size_t largest = 0;
+
+    for (memory_entry_t * entry = heap.first; entry; entry = entry->next) {
+        if (entry->magic == MAGIC_FREE) {
+            total += entry->size;
+
+            if (entry->size > largest) {
+                largest = entry->size;
+            }
+        }
+    }
+
+    if (!total) {
+        return 0;
+    }
+
+    return 100.0 * (total - largest) / total;
+}
+
+static void heap_stats(Run & run) {
+    run.peak_kib = pool_peak * PAGE_SIZE / 1024.0;
+    run.frag_pct = heap_fragmentation();
+}
+
+struct TraceOp {
+    char     kind;
+    uint32_t id;
+    size_t   size;
+    size_t   align;
+};
+
+struct Trace {
+    std::string          name;
+    std::vector<TraceOp> ops;
+    uint32_t             max_id = 0;
+};
+
+static bool load_trace(const std::string & path, Trace & trace) {
+    std::ifstream file(path);
+
+    if (!file) {
+        fprintf(stderr, "Failed to open trace %s\n", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    size_t      line_no = 0;
+
+    while (std::getline(file, line)) {
+        line_no++;
+
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::istringstream in(line);
+        TraceOp            op = {};
+
+        in >> op.kind >> op.id;
+
+        switch (op.kind) {
+            case 'a':
+            case 'r':
+                in >> op.size;
+                break;
+            case 'A':
+                in >> op.size >> op.align;
+                break;
+            case 'f':
+                break;
+            default:
+                in.setstate(std::ios::failbit);
+                break;
+        }
+
+        if (in.fail()) {
+            fprintf(stderr, "%s:%zu: invalid trace line\n", path.c_str(), line_no);
+            return false;
+        }
+
+        if (op.id > trace.max_id) {
+            trace.max_id = op.id;
+        }
+
+        trace.ops.push_back(op);
+    }
+
+    return true;
+}
+
+static bool replay(const Trace & trace, Run & run) {
+    std::vector<void *> ptrs(trace.max_id + 1);
+
+    if (!heap_init()) {
+        return false;
+    }
+
+    Timer timer;
+
+    for (auto & op : trace.ops) {
+        void *& ptr = ptrs[op.id];
+        bool    ok  = true;
+
+        switch (op.kind) {
+            case 'a':
+                ptr = memory_alloc(&heap, op.size);
+                ok  = ptr != 0;
+                break;
+            case 'A':
+                ptr = memory_alloc_aligned(&heap, op.size, op.align);
+                ok  = ptr != 0;
+                break;
+            case 'r':
+                ptr = memory_realloc(&heap, ptr, op.size);
+                ok  = ptr != 0;
+                break;
+            case 'f':
+                ok  = memory_free(&heap, ptr) == 0;
+                ptr = 0;
+                break;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "%s: op %zu failed\n", trace.name.c_str(), (size_t)(&op - trace.ops.data()));
+            return false;
+        }
+    }
+
+    run.ns += timer.ns();
+    run.ops += trace.ops.size();
+
+    // Live allocations at the end of the trace stay in the heap
+    heap_stats(run);
+
+    return true;
+}
+
+static bool bench_ram(Run & run) {
+    alignas(PAGE_SIZE) static char region[PAGE_SIZE * RAM_PAGE_COUNT];
+    static ram_table_t             table;
+    static uint32_t                addrs[RAM_PAGE_COUNT];
+
+    // One region, so the bitmask at the start of the region is also the
+    // virtual bitmask
+    if (ram_init(&table, region) || ram_region_add_memory((uint32_t)(uintptr_t)region, sizeof(region))) {
+        return false;
+    }
+
+    size_t count = ram_free_pages();
+
+    Timer timer;
+
+    for (size_t i = 0; i < count; i++) {
+        addrs[i] = ram_page_alloc();
+    }
+
+    // Free every other page and take them again to search a used bitmask
+    for (size_t i = 0; i < count; i += 2) {
+        ram_page_free(addrs[i]);
+    }
+
+    for (size_t i = 0; i < count; i += 2) {
+        addrs[i] = ram_page_alloc();
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        ram_page_free(addrs[i]);
+    }
+
+    run.ns += timer.ns();
+    run.ops += count * 3;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!addrs[i]) {
+            return false;
+        }
+    }
+
+    return ram_free_pages() == count;
+}
+
+static bool bench_cb(Run & run) {
+    cb_t cb;
+
+    if (!heap_init() || cb_create(&cb, 64, sizeof(uint32_t))) {
+        return false;
+    }
+
+    size_t   ops  = 0;
+    uint32_t item = 0;
+
+    Timer timer;
+
+    // Key buffer style, fill part way then drain
+    for (size_t r = 0; r < 256; r++) {
+        for (size_t i = 0; i < 48; i++) {
+            cb_push(&cb, &item);
+            item++;
+        }
+
+        while (cb_len(&cb)) {
+            cb_pop(&cb, &item);
+        }
+
+        ops += 96;
+    }
+
+    run.ns += timer.ns();
+    run.ops += ops;
+
+    heap_stats(run);
+    cb_free(&cb);
+
+    return true;
+}
+
+static bool bench_arr(Run & run) {
+    arr_t arr;
+
+    if (!heap_init() || arr_create(&arr, 4, sizeof(uint32_t))) {
+        return false;
+    }
+
+    // Other allocations between resizes, like the kernel heap has
+    std::vector<void *> others;
+
+    Timer timer;
+
+    for (uint32_t i = 0; i < 1024; i++) {
+        if (arr_insert(&arr, arr_size(&arr), &i)) {
+            return false;
+        }
+
+        if (!(i & 0x3f)) {
+            others.push_back(pmalloc(24));
+        }
+    }
+
+    for (uint32_t i = 0; i < 128; i++) {
+        arr_insert(&arr, arr_size(&arr) / 2, &i);
+    }
+
+    for (uint32_t i = 0; i < 256; i++) {
+        arr_remove(&arr, 0, 0);
+    }
+
+    run.ns += timer.ns();
+    run.ops += 1024 + others.size() + 128 + 256;
+
+    heap_stats(run);
+    arr_free(&arr);
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Results
+
+struct Result {
+    std::string name;
+    double      ops_per_sec;
+    double      peak_kib;
+    double      frag_pct;
+};
+
+static void print_value(double value, const char * fmt) {
+    if (value < 0) {
+        printf("%10s", "-");
+    }
+    else {
+        printf(fmt, value);
+    }
+}
+
+static void print_result(const Result & result) {
+    printf("%-16s %14.0f", result.name.c_str(), result.ops_per_sec);
+    print_value(result.peak_kib, " %9.0fK");
+    print_value(result.frag_pct, " %8.1f%%");
+}
+
+static bool save_results(const std::string & path, const std::vector<Result> & results) {
+    std::ofstream file(path);
+
+    if (!file) {
+        fprintf(stderr, "Failed to write %s\n", path.c_str());
+        return false;
+    }
+
+    for (auto & result : results) {
+        file << result.name << ' ' << result.ops_per_sec << ' ' << result.peak_kib << ' ' << result.frag_pct << '\n';
+    }
+
+    return true;
+}
+
+static bool load_results(const std::string & path, std::map<std::string, Result> & results) {
+    std::ifstream file(path);
+
+    if (!file) {
+        fprintf(stderr, "Failed to open %s\n", path.c_str());
+        return false;
+    }
+
+    Result result;
+
+    while (file >> result.name >> result.ops_per_sec >> result.peak_kib >> result.frag_pct) {
+        results[result.name] = result;
+    }
+
+    return true;
+}
+
+// Print the change from base and return true if it is a regression
+static bool compare_result(const Result & result, const Result & base, double threshold) {
+    std::string flags;
+
+    double change = (result.ops_per_sec - base.ops_per_sec) * 100 / base.ops_per_sec;
+
+    if (change < -threshold) {
+        flags += " SLOWER";
+    }
+
+    if (result.peak_kib > base.peak_kib) {
+        flags += " PEAK";
+    }
+
+    if (result.frag_pct > base.frag_pct + FRAG_TOLERANCE) {
+        flags += " FRAG";
+    }
+
+    printf(" %+7.1f%%%s\n", change, flags.c_str());
+
+    return !flags.empty();
+}
+
+int main(int argc, char ** argv) {
+    size_t      iterations = 200;
+    double      threshold  = 10;
+    std::string trace_dir  = BENCH_TRACE_DIR;
+    std::string save_path;
+    std::string compare_path;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return 2;
+        }
+
+        std::string value = argv[++i];
+
+        if (arg == "--iterations") {
+            iterations = std::stoul(value);
+        }
+        else if (arg == "--trace-dir") {
+            trace_dir = value;
+        }
+        else if (arg == "--save") {
+            save_path = value;
+        }
+        else if (arg == "--compare") {
+            compare_path = value;
+        }
+        else if (arg == "--threshold") {
+            threshold = std::stod(value);
+        }
+        else {
+            fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            return 2;
+        }
+    }
+
+    std::vector<Trace> traces;
+
+    for (auto name : {"boot", "shell", "exec"}) {
+        Trace trace;
+        trace.name = std::string("trace/") + name;
+
+        if (!load_trace(trace_dir + "/" + name + ".trace", trace)) {
+            return 2;
+        }
+
+        traces.push_back(trace);
+    }
+
+    struct Bench {
+        std::string                name;
+        std::function<bool(Run &)> fn;
+    };
+
+    std::vector<Bench> benches;
+
+    for (auto & trace : traces) {
+        benches.push_back({trace.name, [&trace](Run & run) { return replay(trace, run); }});
+    }
+
+    benches.push_back({"ram_page_alloc", bench_ram});
+    benches.push_back({"cb", bench_cb});
+    benches.push_back({"arr", bench_arr});
+
+    std::map<std::string, Result> baseline;
+
+    if (!compare_path.empty() && !load_results(compare_path, baseline)) {
+        return 2;
+    }
+
+    printf("%-16s %14s %10s %9s\n", "benchmark", "ops/sec", "peak heap", "frag");
+
+    std::vector<Result> results;
+
+    bool failed     = false;
+    bool regression = false;
+
+    for (auto & bench : benches) {
+        Run run;
+
+        for (size_t i = 0; i < iterations; i++) {
+            if (!bench.fn(run)) {
+                fprintf(stderr, "%s failed\n", bench.name.c_str());
+                failed = true;
+                break;
+            }
+        }
+
+        if (failed) {
+            break;
+        }
+
+        Result result = {bench.name, run.ops * 1e9 / run.ns, run.peak_kib, run.frag_pct};
+        results.push_back(result);
+
+        print_result(result);
+
+        auto base = baseline.find(result.name);
+
+        if (base != baseline.end()) {
+            regression |= compare_result(result, base->second, threshold);
+        }
+        else {
+            printf("\n");
+        }
+    }
+
+    if (failed) {
+        return 1;
+    }
+
+    if (!save_path.empty() && !save_results(save_path, results)) {
+        return 2;
+    }
+
+    if (regression) {
+        printf("Regression compared to %s\n", compare_path.c_str());
+        return 1;
+    }
+
+    return 0;
+}
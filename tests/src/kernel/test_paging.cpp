@@ -19,9 +19,59 @@ int custom_mmu_dir_set(mmu_dir_t * dir, size_t i, uint32_t addr, uint32_t flags)
 
     return 0;
 }
+
+static bool is_temp_page(void * ptr) {
+    uint32_t addr = (uint32_t)(uintptr_t)ptr;
+
+    return addr >= VADDR_TMP_PAGE && addr < VADDR_TMP_PAGE + VADDR_TMP_PAGE_COUNT * PAGE_SIZE;
+}
+
+// Temp pages are not mapped when zeroing pages
+void * custom_kmemset(void * ptr, int value, size_t size) {
+    if (is_temp_page(ptr)) {
+        return ptr;
+    }
+
+    return memset(ptr, value, size);
+}
+
+// Temp pages are not mapped when copying pages
+void * custom_kmemcpy(void * dst, const void * src, size_t size) {
+    if (is_temp_page(dst)) {
+        return dst;
+    }
+
+    return memcpy(dst, src, size);
+}
+
+// Address given to every page by ram_page_alloc_n, 0 to fail
+uint32_t alloc_n_addr;
+size_t   alloc_n_pages;
+size_t   free_n_pages;
+
+int custom_ram_page_alloc_n(uint32_t * out, size_t count) {
+    if (!alloc_n_addr) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        out[i] = alloc_n_addr;
+    }
+
+    alloc_n_pages += count;
+
+    return 0;
+}
+
+int custom_ram_page_free_n(const uint32_t * addrs, size_t count) {
+    free_n_pages += count;
+
+    return 0;
+}
 }
 
-#define EXPECT_BALANCED() EXPECT_EQ(25, paging_temp_available())
+#define EXPECT_BALANCED()       EXPECT_EQ(25, paging_temp_available())
+#define ASSERT_RAM_N_BALANCED() ASSERT_EQ(alloc_n_pages, free_n_pages)
 
 TEST(PagingStatic, paging_init) {
     init_mocks();
@@ -31,9 +81,11 @@ TEST(PagingStatic, paging_init) {
     EXPECT_EQ(1, kmemset_fake.call_count);
     EXPECT_NE(nullptr, kmemset_fake.arg0_val);
     EXPECT_EQ(0, kmemset_fake.arg1_val);
-    EXPECT_EQ(200, kmemset_fake.arg2_val);
+    EXPECT_EQ(500, kmemset_fake.arg2_val);
 
     EXPECT_EQ(25, paging_temp_available());
+    EXPECT_EQ(0, paging_temp_hits());
+    EXPECT_EQ(0, paging_temp_misses());
 }
 
 class Paging : public ::testing::Test {
@@ -44,7 +96,17 @@ protected:
         memset(&table, 0, sizeof(mmu_table_t));
         memset(&dir, 0, sizeof(mmu_dir_t));
 
+        kmemset_fake.custom_fake = custom_kmemset;
+        kmemcpy_fake.custom_fake = custom_kmemcpy;
+
         paging_init();
+
+        alloc_n_addr  = 0;
+        alloc_n_pages = 0;
+        free_n_pages  = 0;
+
+        ram_page_alloc_n_fake.custom_fake = custom_ram_page_alloc_n;
+        ram_page_free_n_fake.custom_fake  = custom_ram_page_free_n;
     }
 
     void fill_temp_pages() {
@@ -59,6 +121,18 @@ protected:
     }
 };
 
+TEST_F(Paging, paging_enable_large_pages_NotSupported) {
+    EXPECT_NE(0, paging_enable_large_pages());
+    EXPECT_EQ(0, mmu_enable_pse_fake.call_count);
+}
+
+TEST_F(Paging, paging_enable_large_pages) {
+    mmu_pse_supported_fake.return_val = true;
+
+    EXPECT_EQ(0, paging_enable_large_pages());
+    EXPECT_EQ(1, mmu_enable_pse_fake.call_count);
+}
+
 TEST_F(Paging, paging_temp_map_calls_flush_tlb) {
     void * ptr = paging_temp_map(0x1000);
     EXPECT_NE(nullptr, ptr);
@@ -80,7 +154,7 @@ TEST_F(Paging, paging_temp_map) {
     EXPECT_EQ((mmu_table_t *)VADDR_KERNEL_TABLE, mmu_table_set_fake.arg0_val);
     EXPECT_EQ(ADDR2PAGE(VADDR_TMP_PAGE), mmu_table_set_fake.arg1_val);
     EXPECT_EQ(0x1000, mmu_table_set_fake.arg2_val);
-    EXPECT_EQ(MMU_TABLE_RW, mmu_table_set_fake.arg3_val);
+    EXPECT_EQ(MMU_TABLE_RW_GLOBAL, mmu_table_set_fake.arg3_val);
 
     for (size_t i = 1; i < 25; i++) {
         EXPECT_NE(nullptr, paging_temp_map((i + 1) << 12)) << i;
@@ -145,6 +219,94 @@ TEST_F(Paging, paging_temp_available) {
     EXPECT_EQ(0, paging_temp_available());
 }
 
+TEST_F(Paging, paging_temp_map_KeepsFreedMapping) {
+    void * a = paging_temp_map(0x1000);
+    paging_temp_free(0x1000);
+
+    EXPECT_EQ(25, paging_temp_available());
+
+    // Mapping is reused without touching the page table
+    void * b = paging_temp_map(0x1000);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(24, paging_temp_available());
+    EXPECT_EQ(1, mmu_table_set_fake.call_count);
+    EXPECT_EQ(1, mmu_flush_tlb_fake.call_count);
+
+    EXPECT_EQ(1, paging_temp_hits());
+    EXPECT_EQ(1, paging_temp_misses());
+}
+
+TEST_F(Paging, paging_temp_map_LeastRecentlyFreed) {
+    fill_temp_pages();
+
+    // Free slots 5 then 2
+    paging_temp_free(0x6000);
+    paging_temp_free(0x3000);
+
+    EXPECT_EQ(2, paging_temp_available());
+
+    uint32_t first = ADDR2PAGE(VADDR_TMP_PAGE);
+
+    EXPECT_EQ(UINT2PTR(PAGE2ADDR(first + 5)), paging_temp_map(0x40000));
+    EXPECT_EQ(UINT2PTR(PAGE2ADDR(first + 2)), paging_temp_map(0x41000));
+    EXPECT_EQ(nullptr, paging_temp_map(0x42000));
+
+    // Old translation is flushed when the slot is reassigned
+    EXPECT_EQ(PAGE2ADDR(first + 2), mmu_flush_tlb_fake.arg0_val);
+    EXPECT_EQ(0x41000, mmu_table_set_fake.arg2_val);
+}
+
+TEST_F(Paging, paging_temp_map_Reassigned) {
+    paging_temp_map(0x50000);
+    paging_temp_free(0x50000);
+
+    // Freed slot is reused last
+    fill_temp_pages();
+    EXPECT_EQ(0, paging_temp_available());
+
+    paging_temp_free(0x2000);
+
+    size_t misses = paging_temp_misses();
+
+    // Slot of 0x50000 was reassigned, so it is a miss again
+    EXPECT_NE(nullptr, paging_temp_map(0x50000));
+    EXPECT_EQ(misses + 1, paging_temp_misses());
+}
+
+TEST_F(Paging, paging_temp_map_SameBucket) {
+    // 32 pages apart share a hash bucket
+    void * a = paging_temp_map(0x1000);
+    void * b = paging_temp_map(0x21000);
+    void * c = paging_temp_map(0x41000);
+
+    EXPECT_NE(a, b);
+    EXPECT_NE(b, c);
+    EXPECT_NE(a, c);
+
+    EXPECT_EQ(a, paging_temp_map(0x1000));
+    EXPECT_EQ(b, paging_temp_map(0x21000));
+    EXPECT_EQ(c, paging_temp_map(0x41000));
+
+    EXPECT_EQ(3, paging_temp_hits());
+    EXPECT_EQ(3, paging_temp_misses());
+
+    paging_temp_free(0x21000);
+    paging_temp_free(0x21000);
+
+    EXPECT_EQ(23, paging_temp_available());
+    EXPECT_EQ(a, paging_temp_map(0x1000));
+    EXPECT_EQ(c, paging_temp_map(0x41000));
+}
+
+TEST_F(Paging, paging_temp_misses_Full) {
+    fill_temp_pages();
+
+    size_t misses = paging_temp_misses();
+
+    EXPECT_EQ(nullptr, paging_temp_map(0x40000));
+    EXPECT_EQ(misses + 1, paging_temp_misses());
+}
+
 TEST_F(Paging, paging_id_map_range) {
     EXPECT_NE(0, paging_id_map_range(MMU_TABLE_SIZE, MMU_TABLE_SIZE));
 
@@ -159,6 +321,7 @@ TEST_F(Paging, paging_id_map_page) {
     // success
     EXPECT_EQ(0, paging_id_map_page(1));
     EXPECT_EQ(1, mmu_table_set_fake.call_count);
+    EXPECT_EQ(MMU_TABLE_RW_GLOBAL, mmu_table_set_fake.arg3_val);
 }
 
 // Paging Add Page
@@ -175,26 +338,31 @@ TEST_F(Paging, paging_add_pages_InvalidParameters) {
 
 TEST_F(Paging, paging_add_pages_FailAllocPage) {
     EXPECT_NE(0, paging_add_pages(&dir, 1, 2));
+    EXPECT_EQ(1, ram_page_alloc_n_fake.call_count);
+    EXPECT_EQ(0, ram_page_free_n_fake.call_count);
     EXPECT_BALANCED();
-    ASSERT_RAM_ALLOC_BALANCE_OFFSET(1);
+    ASSERT_RAM_N_BALANCED();
 }
 
 TEST_F(Paging, paging_add_pages_NeedsTable_FailAddTable) {
-    uint32_t page_seq[2] = {0x2000, 0};
-    SET_RETURN_SEQ(ram_page_alloc, page_seq, 2);
+    alloc_n_addr = 0x2000;
 
     EXPECT_NE(0, paging_add_pages(&dir, 1, 2));
-    EXPECT_EQ(2, ram_page_alloc_fake.call_count);
+    EXPECT_EQ(1, ram_page_alloc_n_fake.call_count);
+    EXPECT_EQ(1, ram_page_alloc_fake.call_count);
     EXPECT_BALANCED();
+    ASSERT_RAM_N_BALANCED();
     ASSERT_RAM_ALLOC_BALANCE_OFFSET(1);
 }
 
 TEST_F(Paging, paging_add_pages_NeedsTable_FailTempMap) {
-    ram_page_alloc_fake.return_val = 0x2000;
+    alloc_n_addr                   = 0x2000;
+    ram_page_alloc_fake.return_val = 0x3000;
 
     EXPECT_NE(0, paging_add_pages(&dir, 1, 2));
-    EXPECT_EQ(2, ram_page_alloc_fake.call_count);
+    EXPECT_EQ(1, ram_page_alloc_fake.call_count);
     EXPECT_BALANCED();
+    ASSERT_RAM_N_BALANCED();
     ASSERT_RAM_ALLOC_BALANCE_OFFSET(1); // Table is not freed
 }
 
@@ -203,34 +371,294 @@ TEST_F(Paging, paging_add_pages_NeedsTable) {
 
     mmu_dir_get_addr_fake.return_val = 0x1000;
     ram_page_alloc_fake.return_val   = 0x2000;
+    alloc_n_addr                     = 0x3000;
 
     EXPECT_EQ(0, paging_add_pages(&dir, 1, 2));
 
     EXPECT_EQ(0x2003, dir.entries[0]);
 
     EXPECT_BALANCED();
-    ASSERT_RAM_ALLOC_BALANCE_OFFSET(4);
+    EXPECT_EQ(2, alloc_n_pages);
+    EXPECT_EQ(0, free_n_pages);
+    ASSERT_RAM_ALLOC_BALANCE_OFFSET(1); // One table for the run of pages
 }
 
 TEST_F(Paging, paging_add_pages_HasTable) {
     mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT;
     mmu_dir_get_addr_fake.return_val  = 0x1000;
-    ram_page_alloc_fake.return_val    = 0x2000;
+    alloc_n_addr                      = 0x2000;
 
     EXPECT_EQ(0, paging_add_pages(&dir, 1, 2));
 
-    EXPECT_EQ(2, ram_page_alloc_fake.call_count);
-    EXPECT_EQ(3, mmu_table_set_fake.call_count); // Include call to paging_temp_free
+    EXPECT_EQ(0, ram_page_alloc_fake.call_count);
+    EXPECT_EQ(1, ram_page_alloc_n_fake.call_count);
+    EXPECT_EQ(2, ram_page_alloc_n_fake.arg1_val);
+    EXPECT_EQ(4, mmu_table_set_fake.call_count); // Include temp maps to zero and for the table
+
+    EXPECT_EQ(1, mmu_table_set_fake.arg1_history[2]);
+    EXPECT_EQ(2, mmu_table_set_fake.arg1_history[3]);
+    EXPECT_EQ(0x2000, mmu_table_set_fake.arg2_history[2]);
+    EXPECT_EQ(0x2000, mmu_table_set_fake.arg2_history[3]);
+    EXPECT_EQ(MMU_TABLE_RW_GLOBAL, mmu_table_set_fake.arg3_history[2]); // Kernel table
+    EXPECT_EQ(MMU_TABLE_RW_GLOBAL, mmu_table_set_fake.arg3_history[3]);
+
+    // Both pages are zeroed
+    EXPECT_EQ(2, kmemset_fake.call_count - 1); // Exclude call from paging_init
+    EXPECT_EQ(PAGE_SIZE, kmemset_fake.arg2_val);
+
+    EXPECT_BALANCED();
+    EXPECT_EQ(2, alloc_n_pages);
+    EXPECT_EQ(0, free_n_pages);
+}
+
+TEST_F(Paging, paging_add_pages_UserTable) {
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val  = 0x1000;
+    alloc_n_addr                      = 0x2000;
+
+    EXPECT_EQ(0, paging_add_pages(&dir, MMU_TABLE_SIZE, MMU_TABLE_SIZE));
+
+    // Only kernel table pages are global
+    EXPECT_EQ(0, mmu_table_set_fake.arg1_val);
+    EXPECT_EQ(MMU_TABLE_RW, mmu_table_set_fake.arg3_val);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_add_pages_Recursive) {
+    mmu_dir_t * curr_dir = (mmu_dir_t *)VADDR_RECURSIVE_DIR;
+
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val  = 0x1000;
+    alloc_n_addr                      = 0x2000;
+
+    EXPECT_EQ(0, paging_add_pages(curr_dir, MMU_TABLE_SIZE + 1, MMU_TABLE_SIZE + 2));
 
+    // Only the temp map to zero the pages, which share an address
+    EXPECT_EQ(3, mmu_table_set_fake.call_count);
+    EXPECT_EQ(1, mmu_flush_tlb_fake.call_count);
+
+    // Table is edited through the recursive mapping
+    mmu_table_t * curr_table = (mmu_table_t *)(VADDR_RECURSIVE_TABLES + PAGE_SIZE);
+    EXPECT_EQ(curr_table, mmu_table_set_fake.arg0_history[1]);
+    EXPECT_EQ(curr_table, mmu_table_set_fake.arg0_history[2]);
     EXPECT_EQ(1, mmu_table_set_fake.arg1_history[1]);
     EXPECT_EQ(2, mmu_table_set_fake.arg1_history[2]);
-    EXPECT_EQ(0x2000, mmu_table_set_fake.arg2_history[1]);
     EXPECT_EQ(0x2000, mmu_table_set_fake.arg2_history[2]);
-    EXPECT_EQ(0x3, mmu_table_set_fake.arg3_history[1]);
-    EXPECT_EQ(0x3, mmu_table_set_fake.arg3_history[2]);
 
     EXPECT_BALANCED();
-    ASSERT_RAM_ALLOC_BALANCE_OFFSET(2);
+    EXPECT_EQ(2, alloc_n_pages);
+    EXPECT_EQ(0, free_n_pages);
+}
+
+TEST_F(Paging, paging_add_pages_Batches) {
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val  = 0x1000;
+    alloc_n_addr                      = 0x2000;
+
+    EXPECT_EQ(0, paging_add_pages(&dir, 0, PAGING_BATCH_SIZE + 7));
+
+    EXPECT_EQ(2, ram_page_alloc_n_fake.call_count);
+    EXPECT_EQ(PAGING_BATCH_SIZE, ram_page_alloc_n_fake.arg1_history[0]);
+    EXPECT_EQ(8, ram_page_alloc_n_fake.arg1_history[1]);
+    EXPECT_EQ(PAGING_BATCH_SIZE + 8, alloc_n_pages);
+    EXPECT_EQ(0, free_n_pages);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_add_pages_Batches_FailTempMap) {
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT;
+    alloc_n_addr                      = 0x2000;
+
+    // Fail to map the second table, part way through a batch
+    uint32_t addr_seq[2] = {0x1000, 0};
+    SET_RETURN_SEQ(mmu_dir_get_addr, addr_seq, 2);
+
+    EXPECT_NE(0, paging_add_pages(&dir, 4, MMU_TABLE_SIZE + 7));
+
+    // Pages of the batch that were not mapped are freed
+    EXPECT_EQ(MMU_TABLE_SIZE, alloc_n_pages);
+    EXPECT_EQ(1, ram_page_free_n_fake.call_count);
+    EXPECT_EQ(4, ram_page_free_n_fake.arg1_val);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_add_pages_MapsTableOnce) {
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val  = 0x1000;
+    alloc_n_addr                      = 0x2000;
+
+    EXPECT_EQ(0, paging_add_pages(&dir, 0, PAGING_BATCH_SIZE + 7));
+
+    // Zeroing reuses the temp page of 0x2000, the table is mapped once
+    EXPECT_EQ(2, paging_temp_misses());
+    EXPECT_EQ(PAGING_BATCH_SIZE + 7, paging_temp_hits());
+    EXPECT_EQ(1, mmu_dir_get_addr_fake.call_count);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_add_pages_TwoTables) {
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val  = 0x1000;
+    alloc_n_addr                      = 0x2000;
+
+    EXPECT_EQ(0, paging_add_pages(&dir, MMU_TABLE_SIZE - 2, MMU_TABLE_SIZE + 1));
+
+    EXPECT_EQ(2, mmu_dir_get_addr_fake.call_count);
+    EXPECT_EQ(0, mmu_dir_get_addr_fake.arg1_history[0]);
+    EXPECT_EQ(1, mmu_dir_get_addr_fake.arg1_history[1]);
+    EXPECT_EQ(4, alloc_n_pages);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_add_pages_LargePage) {
+    mmu_dir_t * curr_dir = (mmu_dir_t *)VADDR_RECURSIVE_DIR;
+
+    mmu_pse_supported_fake.return_val = true;
+    paging_enable_large_pages();
+
+    kmemset_fake.custom_fake             = 0;
+    ram_page_alloc_range_fake.return_val = 0x400000;
+
+    EXPECT_EQ(0, paging_add_pages(curr_dir, MMU_TABLE_SIZE, 2 * MMU_TABLE_SIZE - 1));
+
+    EXPECT_EQ(1, mmu_dir_set_fake.call_count);
+    EXPECT_EQ(1, mmu_dir_set_fake.arg1_val);
+    EXPECT_EQ(0x400000, mmu_dir_set_fake.arg2_val);
+    EXPECT_EQ(MMU_DIR_RW | MMU_DIR_FLAG_PAGE_SIZE, mmu_dir_set_fake.arg3_val);
+    EXPECT_EQ(MMU_TABLE_SIZE, ram_page_alloc_range_fake.arg0_val);
+    EXPECT_EQ(MMU_LARGE_PAGE_SIZE, ram_page_alloc_range_fake.arg1_val);
+    EXPECT_EQ(0, ram_page_alloc_n_fake.call_count);
+    EXPECT_EQ(0, ram_page_alloc_fake.call_count);
+
+    // Zeroed in one pass through the new mapping
+    EXPECT_EQ(2, kmemset_fake.call_count); // +1 for paging_init
+    EXPECT_EQ((void *)PAGE2ADDR(MMU_TABLE_SIZE), kmemset_fake.arg0_val);
+    EXPECT_EQ(MMU_LARGE_PAGE_SIZE, kmemset_fake.arg2_val);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_add_pages_LargePage_OtherDir) {
+    mmu_pse_supported_fake.return_val = true;
+    paging_enable_large_pages();
+
+    mmu_dir_get_addr_fake.return_val     = 0x1000;
+    ram_page_alloc_range_fake.return_val = 0x400000;
+    ram_page_alloc_fake.return_val       = 0x2000;
+    alloc_n_addr                         = 0x3000;
+
+    // Only the active dir can be zeroed through the large page
+    EXPECT_EQ(0, paging_add_pages(&dir, MMU_TABLE_SIZE, 2 * MMU_TABLE_SIZE - 1));
+    EXPECT_EQ(0, ram_page_alloc_range_fake.call_count);
+    EXPECT_EQ(MMU_TABLE_SIZE, alloc_n_pages);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_add_pages_LargePage_Disabled) {
+    mmu_dir_t * curr_dir = (mmu_dir_t *)VADDR_RECURSIVE_DIR;
+
+    kmemset_fake.custom_fake             = 0;
+    mmu_dir_get_addr_fake.return_val     = 0x1000;
+    ram_page_alloc_range_fake.return_val = 0x400000;
+    ram_page_alloc_fake.return_val       = 0x2000;
+    alloc_n_addr                         = 0x3000;
+
+    EXPECT_EQ(0, paging_add_pages(curr_dir, MMU_TABLE_SIZE, 2 * MMU_TABLE_SIZE - 1));
+    EXPECT_EQ(0, ram_page_alloc_range_fake.call_count);
+    EXPECT_EQ(MMU_TABLE_SIZE, alloc_n_pages);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_add_pages_LargePage_FailAlloc) {
+    mmu_dir_t * curr_dir = (mmu_dir_t *)VADDR_RECURSIVE_DIR;
+
+    mmu_pse_supported_fake.return_val = true;
+    paging_enable_large_pages();
+
+    kmemset_fake.custom_fake         = 0;
+    mmu_dir_get_addr_fake.return_val = 0x1000;
+    ram_page_alloc_fake.return_val   = 0x2000;
+    alloc_n_addr                     = 0x3000;
+
+    // Falls back to a table of small pages
+    EXPECT_EQ(0, paging_add_pages(curr_dir, MMU_TABLE_SIZE, 2 * MMU_TABLE_SIZE - 1));
+    EXPECT_EQ(1, ram_page_alloc_range_fake.call_count);
+    EXPECT_EQ(MMU_TABLE_SIZE, alloc_n_pages);
+    EXPECT_EQ(0, free_n_pages);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_add_pages_LargePage_PartialTable) {
+    mmu_dir_t * curr_dir = (mmu_dir_t *)VADDR_RECURSIVE_DIR;
+
+    mmu_pse_supported_fake.return_val = true;
+    paging_enable_large_pages();
+
+    kmemset_fake.custom_fake         = 0;
+    mmu_dir_get_addr_fake.return_val = 0x1000;
+    ram_page_alloc_fake.return_val   = 0x2000;
+    alloc_n_addr                     = 0x3000;
+
+    EXPECT_EQ(0, paging_add_pages(curr_dir, MMU_TABLE_SIZE + 1, 2 * MMU_TABLE_SIZE - 1));
+    EXPECT_EQ(0, ram_page_alloc_range_fake.call_count);
+    EXPECT_EQ(MMU_TABLE_SIZE - 1, alloc_n_pages);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_add_pages_LargePage_Mixed) {
+    mmu_dir_t * curr_dir = (mmu_dir_t *)VADDR_RECURSIVE_DIR;
+
+    mmu_pse_supported_fake.return_val = true;
+    paging_enable_large_pages();
+
+    kmemset_fake.custom_fake             = 0;
+    mmu_dir_get_addr_fake.return_val     = 0x1000;
+    ram_page_alloc_range_fake.return_val = 0x400000;
+    ram_page_alloc_fake.return_val       = 0x2000;
+    alloc_n_addr                         = 0x3000;
+
+    // Large page for table 1, small pages for the start of table 2
+    EXPECT_EQ(0, paging_add_pages(curr_dir, MMU_TABLE_SIZE, 2 * MMU_TABLE_SIZE + 1));
+    EXPECT_EQ(2, mmu_dir_set_fake.call_count);
+    EXPECT_EQ(1, mmu_dir_set_fake.arg1_history[0]);
+    EXPECT_EQ(0x400000, mmu_dir_set_fake.arg2_history[0]);
+    EXPECT_EQ(2, mmu_dir_set_fake.arg1_history[1]);
+    EXPECT_EQ(0x2000, mmu_dir_set_fake.arg2_history[1]);
+    EXPECT_EQ(MMU_DIR_RW, mmu_dir_set_fake.arg3_history[1]);
+    EXPECT_EQ(1, ram_page_alloc_range_fake.call_count);
+    EXPECT_EQ(2, alloc_n_pages);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_add_pages_LargePage_BatchBefore) {
+    mmu_dir_t * curr_dir = (mmu_dir_t *)VADDR_RECURSIVE_DIR;
+
+    mmu_pse_supported_fake.return_val = true;
+    paging_enable_large_pages();
+
+    kmemset_fake.custom_fake             = 0;
+    mmu_dir_get_addr_fake.return_val     = 0x1000;
+    ram_page_alloc_range_fake.return_val = 0x400000;
+    ram_page_alloc_fake.return_val       = 0x2000;
+    alloc_n_addr                         = 0x3000;
+
+    // Batch only covers the pages before the large page
+    EXPECT_EQ(0, paging_add_pages(curr_dir, MMU_TABLE_SIZE - 2, 2 * MMU_TABLE_SIZE - 1));
+    EXPECT_EQ(1, mmu_dir_set_fake.arg1_val);
+    EXPECT_EQ(0x400000, mmu_dir_set_fake.arg2_val);
+    EXPECT_EQ(1, ram_page_alloc_n_fake.call_count);
+    EXPECT_EQ(2, ram_page_alloc_n_fake.arg1_val);
+    EXPECT_EQ(2, alloc_n_pages);
+    EXPECT_EQ(0, free_n_pages);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_add_pages_HasLargePage) {
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT | MMU_DIR_FLAG_PAGE_SIZE;
+
+    EXPECT_EQ(0, paging_add_pages(&dir, 1, 2));
+    EXPECT_EQ(0, ram_page_alloc_n_fake.call_count);
+    EXPECT_EQ(0, mmu_table_set_fake.call_count);
+    EXPECT_BALANCED();
 }
 
 // Paging Remove Page
@@ -247,14 +675,14 @@ TEST_F(Paging, paging_remove_pages_InvalidParameters) {
 
 TEST_F(Paging, paging_remove_pages_NoTable) {
     EXPECT_EQ(0, paging_remove_pages(&dir, 1, 2));
-    EXPECT_EQ(0, ram_page_free_fake.call_count);
+    EXPECT_EQ(0, ram_page_free_n_fake.call_count);
 }
 
 TEST_F(Paging, paging_remove_pages_FailTempMap) {
     mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT;
 
     EXPECT_NE(0, paging_remove_pages(&dir, 1, 2));
-    EXPECT_EQ(0, ram_page_free_fake.call_count);
+    EXPECT_EQ(0, ram_page_free_n_fake.call_count);
     EXPECT_BALANCED();
 }
 
@@ -263,7 +691,7 @@ TEST_F(Paging, paging_remove_pages_NoPages) {
     mmu_dir_get_addr_fake.return_val  = 0x1000;
 
     EXPECT_EQ(0, paging_remove_pages(&dir, 1, 2));
-    EXPECT_EQ(0, ram_page_free_fake.call_count);
+    EXPECT_EQ(0, ram_page_free_n_fake.call_count);
     EXPECT_BALANCED();
 }
 
@@ -273,11 +701,523 @@ TEST_F(Paging, paging_remove_pages) {
     mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT;
 
     EXPECT_EQ(0, paging_remove_pages(&dir, 1, 2));
-    EXPECT_EQ(2, ram_page_free_fake.call_count);
+    EXPECT_EQ(1, ram_page_free_n_fake.call_count);
+    EXPECT_EQ(2, ram_page_free_n_fake.arg1_val);
     EXPECT_EQ(3, mmu_flush_tlb_fake.call_count); // +1 for paging_table_map call
     EXPECT_BALANCED();
 }
 
+TEST_F(Paging, paging_remove_pages_Recursive) {
+    mmu_dir_t * curr_dir = (mmu_dir_t *)VADDR_RECURSIVE_DIR;
+
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x1000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT;
+
+    EXPECT_EQ(0, paging_remove_pages(curr_dir, 1, 2));
+    EXPECT_EQ(1, ram_page_free_n_fake.call_count);
+    EXPECT_EQ(2, ram_page_free_n_fake.arg1_val);
+
+    // Only the removed pages are flushed, no temp maps
+    EXPECT_EQ(2, mmu_flush_tlb_fake.call_count);
+    EXPECT_EQ(PAGE_SIZE * 2, mmu_flush_tlb_fake.arg0_val);
+    EXPECT_EQ((mmu_table_t *)VADDR_RECURSIVE_TABLES, mmu_table_set_fake.arg0_val);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_remove_pages_Batches) {
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x1000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT;
+
+    EXPECT_EQ(0, paging_remove_pages(&dir, 0, PAGING_BATCH_SIZE + 7));
+    EXPECT_EQ(2, ram_page_free_n_fake.call_count);
+    EXPECT_EQ(PAGING_BATCH_SIZE, ram_page_free_n_fake.arg1_history[0]);
+    EXPECT_EQ(8, ram_page_free_n_fake.arg1_history[1]);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_remove_pages_MapsTableOnce) {
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x1000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT;
+
+    EXPECT_EQ(0, paging_remove_pages(&dir, MMU_TABLE_SIZE - 2, MMU_TABLE_SIZE + 1));
+    EXPECT_EQ(2, mmu_dir_get_addr_fake.call_count);
+    EXPECT_EQ(1, paging_temp_misses());
+    EXPECT_EQ(1, paging_temp_hits());
+    EXPECT_EQ(4, ram_page_free_n_fake.arg1_val);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_remove_pages_SkipsMissingTable) {
+    uint32_t flags_seq[2] = {0, MMU_DIR_FLAG_PRESENT};
+    SET_RETURN_SEQ(mmu_dir_get_flags, flags_seq, 2);
+
+    mmu_dir_get_addr_fake.return_val    = 0x1000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT;
+
+    EXPECT_EQ(0, paging_remove_pages(&dir, 0, MMU_TABLE_SIZE + 1));
+
+    // Only the second table is checked page by page
+    EXPECT_EQ(2, mmu_dir_get_flags_fake.call_count);
+    EXPECT_EQ(2, mmu_table_get_flags_fake.call_count);
+    EXPECT_EQ(2, ram_page_free_n_fake.arg1_val);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_remove_pages_FlushEachPage) {
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x1000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT;
+
+    EXPECT_EQ(0, paging_remove_pages(&dir, 0, PAGING_FLUSH_MAX_PAGES - 1));
+    EXPECT_EQ(PAGING_FLUSH_MAX_PAGES + 1, mmu_flush_tlb_fake.call_count); // +1 for temp map
+    EXPECT_EQ(0, mmu_reload_dir_fake.call_count);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_remove_pages_ReloadDir) {
+    mmu_dir_t * curr_dir = (mmu_dir_t *)VADDR_RECURSIVE_DIR;
+
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x1000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT;
+
+    EXPECT_EQ(0, paging_remove_pages(curr_dir, MMU_TABLE_SIZE, MMU_TABLE_SIZE + PAGING_FLUSH_MAX_PAGES));
+    EXPECT_EQ(0, mmu_flush_tlb_fake.call_count);
+    EXPECT_EQ(1, mmu_reload_dir_fake.call_count);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_remove_pages_ReloadDir_KernelTable) {
+    mmu_dir_t * curr_dir = (mmu_dir_t *)VADDR_RECURSIVE_DIR;
+
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x1000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT;
+
+    // Global pages are not flushed by the reload
+    EXPECT_EQ(0, paging_remove_pages(curr_dir, MMU_TABLE_SIZE - 2, MMU_TABLE_SIZE + PAGING_FLUSH_MAX_PAGES));
+    EXPECT_EQ(2, mmu_flush_tlb_fake.call_count);
+    EXPECT_EQ(PAGE2ADDR(MMU_TABLE_SIZE - 1), mmu_flush_tlb_fake.arg0_val);
+    EXPECT_EQ(1, mmu_reload_dir_fake.call_count);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_remove_pages_OtherDir) {
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x1000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT;
+
+    // Only the shared kernel table is flushed, the active dir is not reloaded
+    EXPECT_EQ(0, paging_remove_pages(&dir, MMU_TABLE_SIZE - 2, MMU_TABLE_SIZE + PAGING_FLUSH_MAX_PAGES));
+    EXPECT_EQ(3, mmu_flush_tlb_fake.call_count); // +1 for temp map
+    EXPECT_EQ(PAGE2ADDR(MMU_TABLE_SIZE - 1), mmu_flush_tlb_fake.arg0_val);
+    EXPECT_EQ(0, mmu_reload_dir_fake.call_count);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_remove_pages_ReloadDir_NoPages) {
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val  = 0x1000;
+
+    EXPECT_EQ(0, paging_remove_pages(&dir, 0, PAGING_FLUSH_MAX_PAGES));
+    EXPECT_EQ(0, mmu_reload_dir_fake.call_count);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_remove_pages_LargePage) {
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT | MMU_DIR_FLAG_PAGE_SIZE;
+    mmu_dir_get_addr_fake.return_val  = 0x400000;
+
+    EXPECT_EQ(0, paging_remove_pages(&dir, MMU_TABLE_SIZE, 2 * MMU_TABLE_SIZE - 1));
+    EXPECT_EQ(1, ram_page_free_range_fake.call_count);
+    EXPECT_EQ(0x400000, ram_page_free_range_fake.arg0_val);
+    EXPECT_EQ(MMU_TABLE_SIZE, ram_page_free_range_fake.arg1_val);
+    EXPECT_EQ(1, mmu_dir_set_fake.call_count);
+    EXPECT_EQ(1, mmu_dir_set_fake.arg1_val);
+    EXPECT_EQ(0, mmu_dir_set_fake.arg3_val);
+    EXPECT_EQ(0, ram_page_free_n_fake.call_count);
+    EXPECT_EQ(0, mmu_reload_dir_fake.call_count); // Not the active dir
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_remove_pages_LargePage_Recursive) {
+    mmu_dir_t * curr_dir = (mmu_dir_t *)VADDR_RECURSIVE_DIR;
+
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT | MMU_DIR_FLAG_PAGE_SIZE;
+    mmu_dir_get_addr_fake.return_val  = 0x400000;
+
+    EXPECT_EQ(0, paging_remove_pages(curr_dir, MMU_TABLE_SIZE, 2 * MMU_TABLE_SIZE - 1));
+    EXPECT_EQ(1, ram_page_free_range_fake.call_count);
+    EXPECT_EQ(1, mmu_reload_dir_fake.call_count);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_remove_pages_SplitLargePage) {
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT | MMU_DIR_FLAG_PAGE_SIZE;
+    mmu_dir_get_addr_fake.return_val    = 0x400000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT;
+    ram_page_alloc_fake.return_val      = 0x2000;
+
+    EXPECT_EQ(0, paging_remove_pages(&dir, MMU_TABLE_SIZE + 1, MMU_TABLE_SIZE + 2));
+
+    // Table keeps the pages of the large page
+    EXPECT_EQ(0, ram_page_free_range_fake.call_count);
+    EXPECT_EQ(1, mmu_dir_set_fake.call_count);
+    EXPECT_EQ(0x2000, mmu_dir_set_fake.arg2_val);
+    EXPECT_EQ(MMU_DIR_RW, mmu_dir_set_fake.arg3_val);
+    EXPECT_EQ(2, ram_page_free_n_fake.arg1_val);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_remove_pages_SplitLargePage_FailAlloc) {
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT | MMU_DIR_FLAG_PAGE_SIZE;
+    mmu_dir_get_addr_fake.return_val  = 0x400000;
+
+    EXPECT_NE(0, paging_remove_pages(&dir, MMU_TABLE_SIZE + 1, MMU_TABLE_SIZE + 2));
+    EXPECT_EQ(0, mmu_dir_set_fake.call_count);
+    EXPECT_EQ(0, ram_page_free_n_fake.call_count);
+    EXPECT_BALANCED();
+}
+
+// Paging Share Table
+
+TEST_F(Paging, paging_share_table_InvalidParameters) {
+    mmu_dir_t dst;
+    int       changed = 0;
+
+    EXPECT_NE(0, paging_share_table(0, &dst, 1, &changed));
+    EXPECT_NE(0, paging_share_table(&dir, 0, 1, &changed));
+    EXPECT_NE(0, paging_share_table(&dir, &dst, 1, 0));
+    EXPECT_NE(0, paging_share_table(&dir, &dst, MMU_DIR_SIZE, &changed));
+}
+
+TEST_F(Paging, paging_share_table_NotPresent) {
+    mmu_dir_t dst;
+    int       changed = 0;
+
+    EXPECT_EQ(0, paging_share_table(&dir, &dst, 1, &changed));
+    EXPECT_EQ(0, ram_page_alloc_fake.call_count);
+    EXPECT_EQ(0, mmu_dir_set_fake.call_count);
+}
+
+TEST_F(Paging, paging_share_table_FailAlloc) {
+    mmu_dir_t dst;
+    int       changed = 0;
+
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT;
+
+    EXPECT_NE(0, paging_share_table(&dir, &dst, 1, &changed));
+    EXPECT_EQ(0, mmu_dir_set_fake.call_count);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_share_table) {
+    mmu_dir_t dst;
+    int       changed = 0;
+
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x3000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_RW;
+    mmu_table_get_addr_fake.return_val  = 0x5000;
+    ram_page_alloc_fake.return_val      = 0x2000;
+
+    EXPECT_EQ(0, paging_share_table(&dir, &dst, 1, &changed));
+
+    EXPECT_EQ(MMU_TABLE_SIZE, ram_frame_ref_fake.call_count);
+    EXPECT_EQ(0x5000, ram_frame_ref_fake.arg0_val);
+
+    // Both tables get the read only copy on write entry
+    EXPECT_EQ(MMU_TABLE_FLAG_PRESENT | MMU_TABLE_FLAG_COW, mmu_table_set_fake.arg3_val);
+    EXPECT_EQ(0x5000, mmu_table_set_fake.arg2_val);
+
+    EXPECT_EQ(1, mmu_dir_set_fake.call_count);
+    EXPECT_EQ(&dst, mmu_dir_set_fake.arg0_val);
+    EXPECT_EQ(1, mmu_dir_set_fake.arg1_val);
+    EXPECT_EQ(0x2000, mmu_dir_set_fake.arg2_val);
+    EXPECT_EQ(MMU_DIR_RW, mmu_dir_set_fake.arg3_val);
+
+    // Caller reloads the dir
+    EXPECT_EQ(1, changed);
+    EXPECT_EQ(0, mmu_reload_dir_fake.call_count);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_share_table_ReadOnly) {
+    mmu_dir_t dst;
+    int       changed = 0;
+
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x3000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT;
+    mmu_table_get_addr_fake.return_val  = 0x5000;
+    ram_page_alloc_fake.return_val      = 0x2000;
+
+    EXPECT_EQ(0, paging_share_table(&dir, &dst, 1, &changed));
+    EXPECT_EQ(MMU_TABLE_FLAG_PRESENT, mmu_table_set_fake.arg3_val);
+    EXPECT_EQ(0, changed);
+    EXPECT_EQ(0, mmu_reload_dir_fake.call_count);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_share_table_FailRef) {
+    mmu_dir_t dst;
+    int       changed = 0;
+
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x3000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_RW;
+    ram_page_alloc_fake.return_val      = 0x2000;
+    ram_frame_ref_fake.return_val       = -1;
+
+    EXPECT_NE(0, paging_share_table(&dir, &dst, 1, &changed));
+    EXPECT_EQ(1, ram_frame_ref_fake.call_count);
+
+    // Table is still added so dst releases what it holds
+    EXPECT_EQ(1, mmu_dir_set_fake.call_count);
+    EXPECT_EQ(0x2000, mmu_dir_set_fake.arg2_val);
+    EXPECT_BALANCED();
+}
+
+// Paging Copy Table
+
+TEST_F(Paging, paging_copy_table_InvalidParameters) {
+    mmu_dir_t dst;
+
+    EXPECT_NE(0, paging_copy_table(0, &dst, 1));
+    EXPECT_NE(0, paging_copy_table(&dir, 0, 1));
+    EXPECT_NE(0, paging_copy_table(&dir, &dst, MMU_DIR_SIZE));
+}
+
+TEST_F(Paging, paging_copy_table_NotPresent) {
+    mmu_dir_t dst;
+
+    EXPECT_EQ(0, paging_copy_table(&dir, &dst, 1));
+    EXPECT_EQ(0, ram_page_alloc_fake.call_count);
+}
+
+TEST_F(Paging, paging_copy_table_LargePage) {
+    mmu_dir_t dst;
+
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT | MMU_DIR_FLAG_PAGE_SIZE;
+
+    EXPECT_NE(0, paging_copy_table(&dir, &dst, 1));
+    EXPECT_EQ(0, ram_page_alloc_fake.call_count);
+}
+
+TEST_F(Paging, paging_copy_table) {
+    mmu_dir_t dst;
+
+    // Same flags for src and dst, so dst already has the table and page
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x3000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_RW;
+    mmu_table_get_addr_fake.return_val  = 0x5000;
+
+    EXPECT_EQ(0, paging_copy_table(&dir, &dst, 1));
+    EXPECT_EQ(0, ram_page_alloc_fake.call_count);
+    EXPECT_EQ(MMU_TABLE_SIZE, kmemcpy_fake.call_count);
+    EXPECT_EQ(PAGE_SIZE, kmemcpy_fake.arg2_val);
+    EXPECT_EQ(MMU_TABLE_RW, mmu_table_set_fake.arg3_val);
+    EXPECT_BALANCED();
+}
+
+// Paging Copy On Write
+
+TEST_F(Paging, paging_copy_on_write_InvalidParameters) {
+    EXPECT_NE(0, paging_copy_on_write(0, 1));
+    EXPECT_NE(0, paging_copy_on_write(&dir, MMU_DIR_SIZE * MMU_TABLE_SIZE));
+}
+
+TEST_F(Paging, paging_copy_on_write_NoTable) {
+    EXPECT_NE(0, paging_copy_on_write(&dir, MMU_TABLE_SIZE));
+    EXPECT_EQ(0, mmu_table_set_fake.call_count);
+}
+
+TEST_F(Paging, paging_copy_on_write_NotCow) {
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x3000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT;
+
+    EXPECT_NE(0, paging_copy_on_write(&dir, MMU_TABLE_SIZE));
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_copy_on_write_LastRef) {
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x3000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT | MMU_TABLE_FLAG_COW;
+    mmu_table_get_addr_fake.return_val  = 0x5000;
+    ram_frame_ref_count_fake.return_val = 1;
+
+    EXPECT_EQ(0, paging_copy_on_write(&dir, MMU_TABLE_SIZE + 2));
+    EXPECT_EQ(0, ram_page_alloc_fake.call_count);
+    EXPECT_EQ(0, ram_page_free_fake.call_count);
+    EXPECT_EQ(2, mmu_table_set_fake.arg1_val);
+    EXPECT_EQ(0x5000, mmu_table_set_fake.arg2_val);
+    EXPECT_EQ(MMU_TABLE_RW, mmu_table_set_fake.arg3_val);
+    EXPECT_EQ(PAGE2ADDR(MMU_TABLE_SIZE + 2), mmu_flush_tlb_fake.arg0_val);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_copy_on_write_Shared) {
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x3000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT | MMU_TABLE_FLAG_COW;
+    mmu_table_get_addr_fake.return_val  = 0x5000;
+    ram_frame_ref_count_fake.return_val = 2;
+    ram_page_alloc_fake.return_val      = 0x6000;
+
+    EXPECT_EQ(0, paging_copy_on_write(&dir, MMU_TABLE_SIZE + 2));
+    EXPECT_EQ(1, kmemcpy_fake.call_count);
+    EXPECT_EQ(1, ram_page_free_fake.call_count);
+    EXPECT_EQ(0x5000, ram_page_free_fake.arg0_val);
+    EXPECT_EQ(0x6000, mmu_table_set_fake.arg2_val);
+    EXPECT_EQ(MMU_TABLE_RW, mmu_table_set_fake.arg3_val);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_copy_on_write_Shared_FailAlloc) {
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x3000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT | MMU_TABLE_FLAG_COW;
+    mmu_table_get_addr_fake.return_val  = 0x5000;
+    ram_frame_ref_count_fake.return_val = 2;
+
+    EXPECT_NE(0, paging_copy_on_write(&dir, MMU_TABLE_SIZE + 2));
+    EXPECT_EQ(0, ram_page_free_fake.call_count);
+    EXPECT_BALANCED();
+}
+
+// Paging Clean Page
+
+TEST_F(Paging, paging_clean_page_InvalidParameters) {
+    EXPECT_NE(0, paging_clean_page(0, 1));
+    EXPECT_NE(0, paging_clean_page(&dir, MMU_DIR_SIZE * MMU_TABLE_SIZE));
+}
+
+TEST_F(Paging, paging_clean_page_NoTable) {
+    EXPECT_NE(0, paging_clean_page(&dir, MMU_TABLE_SIZE));
+    EXPECT_EQ(0, mmu_table_set_flags_fake.call_count);
+}
+
+TEST_F(Paging, paging_clean_page_NotPresent) {
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val  = 0x3000;
+
+    EXPECT_NE(0, paging_clean_page(&dir, MMU_TABLE_SIZE));
+    EXPECT_EQ(0, mmu_table_set_flags_fake.call_count);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_clean_page) {
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x3000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_RW | MMU_TABLE_FLAG_DIRTY;
+
+    EXPECT_EQ(0, paging_clean_page(&dir, MMU_TABLE_SIZE + 2));
+    EXPECT_EQ(1, mmu_table_set_flags_fake.call_count);
+    EXPECT_EQ(2, mmu_table_set_flags_fake.arg1_val);
+    EXPECT_EQ(MMU_TABLE_RW, mmu_table_set_flags_fake.arg2_val);
+    EXPECT_EQ(1, mmu_flush_tlb_fake.call_count); // Only the temp map, not the active dir
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_clean_page_Recursive) {
+    mmu_dir_t * curr_dir = (mmu_dir_t *)VADDR_RECURSIVE_DIR;
+
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x3000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_RW | MMU_TABLE_FLAG_DIRTY;
+
+    EXPECT_EQ(0, paging_clean_page(curr_dir, MMU_TABLE_SIZE + 2));
+    EXPECT_EQ(1, mmu_flush_tlb_fake.call_count);
+    EXPECT_EQ(PAGE2ADDR(MMU_TABLE_SIZE + 2), mmu_flush_tlb_fake.arg0_val);
+    EXPECT_BALANCED();
+}
+
+// Paging Drop Clean Pages
+
+TEST_F(Paging, paging_drop_clean_pages_InvalidParameters) {
+    EXPECT_NE(0, paging_drop_clean_pages(0, 0, 1));
+    EXPECT_NE(0, paging_drop_clean_pages(&dir, 0, MMU_DIR_SIZE * MMU_TABLE_SIZE));
+}
+
+TEST_F(Paging, paging_drop_clean_pages_NoPages) {
+    EXPECT_EQ(0, paging_drop_clean_pages(&dir, 2, 1));
+    EXPECT_EQ(0, paging_drop_clean_pages(&dir, MMU_TABLE_SIZE, MMU_TABLE_SIZE + 2));
+    EXPECT_EQ(0, mmu_table_set_fake.call_count);
+}
+
+TEST_F(Paging, paging_drop_clean_pages_FailTempMap) {
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT;
+
+    EXPECT_NE(0, paging_drop_clean_pages(&dir, MMU_TABLE_SIZE, MMU_TABLE_SIZE + 2));
+    EXPECT_EQ(0, mmu_table_set_fake.call_count);
+}
+
+TEST_F(Paging, paging_drop_clean_pages_LargePage) {
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT | MMU_DIR_FLAG_PAGE_SIZE;
+    mmu_dir_get_addr_fake.return_val  = 0x400000;
+
+    EXPECT_EQ(0, paging_drop_clean_pages(&dir, MMU_TABLE_SIZE, MMU_TABLE_SIZE + 2));
+    EXPECT_EQ(0, ram_page_free_n_fake.call_count);
+}
+
+TEST_F(Paging, paging_drop_clean_pages_Dirty) {
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x3000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_RW | MMU_TABLE_FLAG_DIRTY;
+
+    EXPECT_EQ(0, paging_drop_clean_pages(&dir, MMU_TABLE_SIZE, MMU_TABLE_SIZE + 2));
+    EXPECT_EQ(1, mmu_table_set_fake.call_count); // Only the temp map
+    EXPECT_EQ(0, ram_page_free_n_fake.call_count);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_drop_clean_pages) {
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x3000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_RW;
+    mmu_table_get_addr_fake.return_val  = 0x5000;
+
+    EXPECT_EQ(3, paging_drop_clean_pages(&dir, MMU_TABLE_SIZE + 1, MMU_TABLE_SIZE + 3));
+    EXPECT_EQ(4, mmu_table_set_fake.call_count); // +1 for temp map
+    EXPECT_EQ(3, mmu_table_set_fake.arg1_val);
+    EXPECT_EQ(0, mmu_table_set_fake.arg3_val);
+    EXPECT_EQ(1, mmu_flush_tlb_fake.call_count); // Only the temp map, not the active dir
+    EXPECT_EQ(3, free_n_pages);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_drop_clean_pages_Recursive) {
+    mmu_dir_t * curr_dir = (mmu_dir_t *)VADDR_RECURSIVE_DIR;
+
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x3000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_RW;
+    mmu_table_get_addr_fake.return_val  = 0x5000;
+
+    EXPECT_EQ(3, paging_drop_clean_pages(curr_dir, MMU_TABLE_SIZE + 1, MMU_TABLE_SIZE + 3));
+    EXPECT_EQ(3, mmu_flush_tlb_fake.call_count);
+    EXPECT_EQ(PAGE2ADDR(MMU_TABLE_SIZE + 3), mmu_flush_tlb_fake.arg0_val);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_drop_clean_pages_Tables) {
+    mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val    = 0x3000;
+    mmu_table_get_flags_fake.return_val = MMU_TABLE_RW;
+
+    // Last 2 pages of table 1 and first 3 of table 2
+    EXPECT_EQ(5, paging_drop_clean_pages(&dir, 2 * MMU_TABLE_SIZE - 2, 2 * MMU_TABLE_SIZE + 2));
+    EXPECT_EQ(5, free_n_pages);
+    EXPECT_EQ(1, ram_page_free_n_fake.call_count);
+    EXPECT_BALANCED();
+}
+
 // Paging Add Table
 
 TEST_F(Paging, paging_add_table_InvalidParameters) {
@@ -319,6 +1259,17 @@ TEST_F(Paging, paging_add_table_NeedsTable) {
     EXPECT_EQ(0x3, mmu_dir_set_fake.arg3_val);
 }
 
+TEST_F(Paging, paging_add_table_Recursive) {
+    ram_page_alloc_fake.return_val = 0x1000;
+
+    EXPECT_EQ(0, paging_add_table((mmu_dir_t *)VADDR_RECURSIVE_DIR, 3));
+    EXPECT_EQ(1, mmu_dir_set_fake.call_count);
+
+    // Zeroing temp map and the table in the recursive mapping
+    EXPECT_EQ(2, mmu_flush_tlb_fake.call_count);
+    EXPECT_EQ(VADDR_RECURSIVE_TABLES + PAGE_SIZE * 3, mmu_flush_tlb_fake.arg0_val);
+}
+
 // Paging Remove Table
 
 TEST_F(Paging, paging_remove_table_InvalidParameters) {
@@ -335,7 +1286,163 @@ TEST_F(Paging, paging_remove_table_HasTable) {
     EXPECT_EQ(0x1000, ram_page_free_fake.arg0_val);
 }
 
+TEST_F(Paging, paging_remove_table_Recursive) {
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT;
+    mmu_dir_get_addr_fake.return_val  = 0x1000;
+
+    EXPECT_EQ(0, paging_remove_table((mmu_dir_t *)VADDR_RECURSIVE_DIR, 3));
+    EXPECT_EQ(1, ram_page_free_fake.call_count);
+    EXPECT_EQ(1, mmu_flush_tlb_fake.call_count);
+    EXPECT_EQ(VADDR_RECURSIVE_TABLES + PAGE_SIZE * 3, mmu_flush_tlb_fake.arg0_val);
+}
+
 TEST_F(Paging, paging_remove_table_NoTable) {
     EXPECT_EQ(0, paging_remove_table(&dir, 1));
     EXPECT_EQ(0, ram_page_free_fake.call_count);
 }
+
+// Paging Zero Pool
+
+TEST_F(Paging, paging_alloc_zeroed_FailAlloc) {
+    EXPECT_EQ(0, paging_alloc_zeroed());
+    EXPECT_EQ(1, ram_page_alloc_fake.call_count);
+}
+
+TEST_F(Paging, paging_alloc_zeroed_FailTempMap) {
+    ram_page_alloc_fake.return_val = 0x1001;
+
+    EXPECT_EQ(0, paging_alloc_zeroed());
+    EXPECT_EQ(1, ram_page_free_fake.call_count);
+    EXPECT_EQ(0x1001, ram_page_free_fake.arg0_val);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_alloc_zeroed_EmptyPool) {
+    ram_page_alloc_fake.return_val = 0x1000;
+
+    EXPECT_EQ(0x1000, paging_alloc_zeroed());
+    EXPECT_EQ(2, kmemset_fake.call_count); // +1 for paging_init
+    EXPECT_EQ(0, kmemset_fake.arg1_val);
+    EXPECT_EQ(PAGE_SIZE, kmemset_fake.arg2_val);
+    EXPECT_EQ(0, ram_page_free_fake.call_count);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_alloc_zeroed_FromPool) {
+    ram_page_alloc_fake.return_val = 0x1000;
+
+    EXPECT_EQ(1, paging_zero_pool_fill(1));
+    EXPECT_EQ(1, paging_zero_pool_count());
+
+    RESET_FAKE(kmemset);
+    RESET_FAKE(ram_page_alloc);
+
+    EXPECT_EQ(0x1000, paging_alloc_zeroed());
+    EXPECT_EQ(0, paging_zero_pool_count());
+    EXPECT_EQ(0, ram_page_alloc_fake.call_count);
+    EXPECT_EQ(0, kmemset_fake.call_count);
+}
+
+TEST_F(Paging, paging_alloc_zeroed_n_InvalidParameters) {
+    EXPECT_NE(0, paging_alloc_zeroed_n(0, 1));
+}
+
+TEST_F(Paging, paging_alloc_zeroed_n_FailAlloc) {
+    uint32_t pages[2];
+
+    ram_page_alloc_fake.return_val = 0x1000;
+    EXPECT_EQ(1, paging_zero_pool_fill(1));
+
+    EXPECT_NE(0, paging_alloc_zeroed_n(pages, 2));
+
+    // Pool is not used
+    EXPECT_EQ(1, paging_zero_pool_count());
+    EXPECT_EQ(1, ram_page_alloc_n_fake.arg1_val);
+}
+
+TEST_F(Paging, paging_alloc_zeroed_n_FailTempMap) {
+    uint32_t pages[2];
+
+    alloc_n_addr = 0x1001;
+
+    EXPECT_NE(0, paging_alloc_zeroed_n(pages, 2));
+    ASSERT_RAM_N_BALANCED();
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_alloc_zeroed_n_PoolFirst) {
+    uint32_t pages[3];
+
+    uint32_t alloc_seq[2] = {0x1000, 0x2000};
+    SET_RETURN_SEQ(ram_page_alloc, alloc_seq, 2);
+    EXPECT_EQ(2, paging_zero_pool_fill(2));
+
+    alloc_n_addr = 0x3000;
+
+    EXPECT_EQ(0, paging_alloc_zeroed_n(pages, 3));
+
+    EXPECT_EQ(0x2000, pages[0]);
+    EXPECT_EQ(0x1000, pages[1]);
+    EXPECT_EQ(0x3000, pages[2]);
+    EXPECT_EQ(0, paging_zero_pool_count());
+    EXPECT_EQ(1, ram_page_alloc_n_fake.arg1_val);
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_alloc_zeroed_n_OnlyPool) {
+    uint32_t pages[1];
+
+    uint32_t alloc_seq[2] = {0x1000, 0x2000};
+    SET_RETURN_SEQ(ram_page_alloc, alloc_seq, 2);
+    EXPECT_EQ(2, paging_zero_pool_fill(2));
+
+    EXPECT_EQ(0, paging_alloc_zeroed_n(pages, 1));
+
+    EXPECT_EQ(0x2000, pages[0]);
+    EXPECT_EQ(1, paging_zero_pool_count());
+    EXPECT_EQ(0, ram_page_alloc_n_fake.call_count);
+}
+
+TEST_F(Paging, paging_zero_pool_fill_FailAlloc) {
+    EXPECT_EQ(0, paging_zero_pool_fill(4));
+    EXPECT_EQ(0, paging_zero_pool_count());
+    EXPECT_EQ(disable_interrupts_fake.call_count, enable_interrupts_fake.call_count);
+}
+
+TEST_F(Paging, paging_zero_pool_fill_FailTempMap) {
+    ram_page_alloc_fake.return_val = 0x1001;
+
+    EXPECT_EQ(0, paging_zero_pool_fill(4));
+    EXPECT_EQ(0, paging_zero_pool_count());
+    EXPECT_EQ(1, ram_page_free_fake.call_count);
+    EXPECT_EQ(disable_interrupts_fake.call_count, enable_interrupts_fake.call_count);
+}
+
+TEST_F(Paging, paging_zero_pool_fill) {
+    ram_page_alloc_fake.return_val = 0x1000;
+
+    EXPECT_EQ(4, paging_zero_pool_fill(4));
+    EXPECT_EQ(4, paging_zero_pool_count());
+    EXPECT_EQ(4, disable_interrupts_fake.call_count);
+    EXPECT_EQ(4, enable_interrupts_fake.call_count);
+    EXPECT_EQ(5, kmemset_fake.call_count); // +1 for paging_init
+    EXPECT_BALANCED();
+}
+
+TEST_F(Paging, paging_zero_pool_fill_Full) {
+    ram_page_alloc_fake.return_val = 0x1000;
+
+    EXPECT_EQ(PAGING_ZERO_POOL_SIZE, paging_zero_pool_fill(PAGING_ZERO_POOL_SIZE + 4));
+    EXPECT_EQ(PAGING_ZERO_POOL_SIZE, paging_zero_pool_count());
+    EXPECT_EQ(PAGING_ZERO_POOL_SIZE, ram_page_alloc_fake.call_count);
+    EXPECT_EQ(disable_interrupts_fake.call_count, enable_interrupts_fake.call_count);
+}
+
+TEST_F(Paging, paging_init_ClearsZeroPool) {
+    ram_page_alloc_fake.return_val = 0x1000;
+    EXPECT_EQ(1, paging_zero_pool_fill(1));
+
+    paging_init();
+
+    EXPECT_EQ(0, paging_zero_pool_count());
+}
@@ -37,6 +37,14 @@ int custom_mmu_table_set(mmu_table_t * table, size_t i, uint32_t addr, uint32_t
 
     return 0;
 }
+
+size_t free_n_pages;
+
+int custom_ram_page_free_n(const uint32_t * addrs, size_t count) {
+    free_n_pages += count;
+
+    return 0;
+}
 }
 
 std::array<char, PAGE_SIZE * 3>                 temp_page;
@@ -64,6 +72,9 @@ protected:
         mmu_table_set_fake.custom_fake = custom_mmu_table_set;
 
         paging_temp_map_fake.return_val = temp_page.data();
+
+        free_n_pages                     = 0;
+        ram_page_free_n_fake.custom_fake = custom_ram_page_free_n;
     }
 };
 
@@ -155,14 +166,27 @@ TEST_F(Process, process_create) {
     // Dir has correct contents
     EXPECT_EQ(0x5003, dir.entries[0]);
     for (size_t i = 1; i < 1024; i++) {
-        EXPECT_EQ(0, dir.entries[i]);
+        if (i != RECURSIVE_DIR_INDEX && i != FRAME_DB_DIR_INDEX) {
+            EXPECT_EQ(0, dir.entries[i]);
+        }
     }
 
+    // Frame database table is shared with the kernel dir
+    EXPECT_EQ(0x5003, dir.entries[FRAME_DB_DIR_INDEX]);
+    EXPECT_EQ(FRAME_DB_DIR_INDEX, mmu_dir_get_addr_fake.arg1_history[1]);
+
+    // Recursive entry maps the dir to itself
+    EXPECT_EQ(0x2003, dir.entries[RECURSIVE_DIR_INDEX]);
+
     EXPECT_EQ(1, paging_add_pages_fake.call_count);
     EXPECT_EQ(&dir, paging_add_pages_fake.arg0_val);
     EXPECT_EQ(0xfffef, paging_add_pages_fake.arg1_val);
     EXPECT_EQ(0xfffff, paging_add_pages_fake.arg2_val);
 
+    // Rest of the user stack is reserved
+    EXPECT_EQ((RECURSIVE_DIR_INDEX + 1) * MMU_TABLE_SIZE, proc.reserved[0].start);
+    EXPECT_EQ(0xfffef - (RECURSIVE_DIR_INDEX + 1) * MMU_TABLE_SIZE, proc.reserved[0].count);
+
     ASSERT_TEMP_MAP_BALANCED();
     ASSERT_RAM_ALLOC_BALANCE_OFFSET(1);
 }
@@ -191,7 +215,8 @@ TEST_F(Process, process_free_FailSecondTempMap) {
     EXPECT_EQ(1, mmu_dir_get_addr_fake.call_count);
     EXPECT_EQ(2, paging_temp_map_fake.call_count);
     EXPECT_EQ(1, paging_temp_free_fake.call_count);
-    EXPECT_EQ(1, ram_page_free_fake.call_count);
+    EXPECT_EQ(1, ram_page_free_n_fake.call_count);
+    EXPECT_EQ(1, free_n_pages);
     ASSERT_TEMP_MAP_BALANCE_OFFSET(1);
 }
 
@@ -200,7 +225,9 @@ TEST_F(Process, process_free_NoPages) {
     mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT;
 
     EXPECT_EQ(0, process_free(&proc));
-    EXPECT_EQ(MMU_DIR_SIZE, ram_page_free_fake.call_count); // tables + dir
+    EXPECT_EQ(MMU_DIR_SIZE - 2, free_n_pages); // tables + dir, not recursive or frame db
+    EXPECT_EQ(MMU_DIR_SIZE / PAGING_BATCH_SIZE, ram_page_free_n_fake.call_count);
+    EXPECT_EQ(0, ram_page_free_fake.call_count);
     ASSERT_TEMP_MAP_BALANCED();
 }
 
@@ -208,7 +235,8 @@ TEST_F(Process, process_free_NoTables) {
     paging_temp_map_fake.return_val = &dir;
 
     EXPECT_EQ(0, process_free(&proc));
-    EXPECT_EQ(1, ram_page_free_fake.call_count);
+    EXPECT_EQ(1, ram_page_free_n_fake.call_count);
+    EXPECT_EQ(1, free_n_pages);
     EXPECT_EQ(1, arr_free_fake.call_count);
     ASSERT_TEMP_MAP_BALANCED();
 }
@@ -218,18 +246,35 @@ TEST_F(Process, process_free) {
     mmu_dir_get_flags_fake.return_val   = MMU_DIR_FLAG_PRESENT;
     mmu_table_get_flags_fake.return_val = MMU_TABLE_FLAG_PRESENT;
 
-    int page_count  = (MMU_DIR_SIZE - 1) * MMU_TABLE_SIZE;
-    int table_count = MMU_DIR_SIZE - 1;
+    // Kernel table, frame database and recursive entry are skipped
+    int page_count  = (MMU_DIR_SIZE - 3) * MMU_TABLE_SIZE;
+    int table_count = MMU_DIR_SIZE - 3;
     int dir_count   = 1;
 
     int expect_free_count = page_count + table_count + dir_count;
 
     EXPECT_EQ(0, process_free(&proc));
-    EXPECT_EQ(expect_free_count, ram_page_free_fake.call_count);
+    EXPECT_EQ(expect_free_count, free_n_pages);
+    EXPECT_EQ(0, ram_page_free_fake.call_count);
     EXPECT_EQ(1, arr_free_fake.call_count);
     ASSERT_TEMP_MAP_BALANCED();
 }
 
+TEST_F(Process, process_free_LargePages) {
+    paging_temp_map_fake.return_val   = &dir;
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT | MMU_DIR_FLAG_PAGE_SIZE;
+    mmu_dir_get_addr_fake.return_val  = 0x400000;
+
+    // Kernel table, frame database and recursive entry are skipped
+    EXPECT_EQ(0, process_free(&proc));
+    EXPECT_EQ(MMU_DIR_SIZE - 3, ram_page_free_range_fake.call_count);
+    EXPECT_EQ(0x400000, ram_page_free_range_fake.arg0_val);
+    EXPECT_EQ(MMU_TABLE_SIZE, ram_page_free_range_fake.arg1_val);
+    EXPECT_EQ(0, mmu_table_get_flags_fake.call_count);
+    EXPECT_EQ(1, free_n_pages); // dir
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
 // Process Set Entrypoint
 
 TEST_F(Process, process_set_entrypoint_InvalidParameters) {
@@ -359,11 +404,584 @@ TEST_F(Process, process_add_pages) {
     EXPECT_NE(nullptr, process_add_pages(&proc, 1));
     EXPECT_EQ(1, paging_add_pages_fake.call_count);
     EXPECT_EQ(next_heap, paging_add_pages_fake.arg1_val);
-    EXPECT_EQ(next_heap + 1, paging_add_pages_fake.arg2_val);
+    EXPECT_EQ(next_heap, paging_add_pages_fake.arg2_val);
     EXPECT_EQ(next_heap + 1, proc.next_heap_page);
     ASSERT_TEMP_MAP_BALANCED();
 }
 
+TEST_F(Process, process_add_pages_Many) {
+    paging_temp_map_fake.return_val = &dir;
+
+    int next_heap = proc.next_heap_page;
+
+    EXPECT_EQ((void *)PAGE2ADDR(next_heap), process_add_pages(&proc, 3));
+    EXPECT_EQ(next_heap, paging_add_pages_fake.arg1_val);
+    EXPECT_EQ(next_heap + 2, paging_add_pages_fake.arg2_val);
+    EXPECT_EQ(next_heap + 3, proc.next_heap_page);
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
+TEST_F(Process, process_add_pages_PastFrameDb) {
+    proc.next_heap_page = FRAME_DB_DIR_INDEX * MMU_TABLE_SIZE - 2;
+
+    EXPECT_EQ(0, process_add_pages(&proc, 3));
+    EXPECT_EQ(0, paging_add_pages_fake.call_count);
+
+    EXPECT_NE(nullptr, process_add_pages(&proc, 2));
+    EXPECT_EQ(1, paging_add_pages_fake.call_count);
+}
+
+TEST_F(Process, process_add_pages_Current) {
+    proc.cr3                         = 0x5000;
+    mmu_get_curr_dir_fake.return_val = 0x5000;
+
+    EXPECT_NE(nullptr, process_add_pages(&proc, 1));
+    EXPECT_EQ(1, paging_add_pages_fake.call_count);
+    EXPECT_EQ((mmu_dir_t *)VADDR_RECURSIVE_DIR, paging_add_pages_fake.arg0_val);
+    EXPECT_EQ(0, paging_temp_map_fake.call_count);
+    EXPECT_EQ(0, paging_temp_free_fake.call_count);
+}
+
+// Process Reserve Pages
+
+TEST_F(Process, process_reserve_pages_InvalidParameters) {
+    EXPECT_EQ(0, process_reserve_pages(0, 1));
+    EXPECT_EQ(0, process_reserve_pages(&proc, 0));
+
+    // Heap stops at the frame database
+    proc.next_heap_page = FRAME_DB_DIR_INDEX * MMU_TABLE_SIZE - 2;
+    EXPECT_EQ(0, process_reserve_pages(&proc, 3));
+    EXPECT_EQ(0, proc.reserved[0].count);
+}
+
+TEST_F(Process, process_reserve_pages) {
+    int next_heap = proc.next_heap_page;
+
+    EXPECT_EQ((void *)PAGE2ADDR(next_heap), process_reserve_pages(&proc, 3));
+    EXPECT_EQ(next_heap + 3, proc.next_heap_page);
+    EXPECT_EQ(next_heap, proc.reserved[0].start);
+    EXPECT_EQ(3, proc.reserved[0].count);
+
+    // Nothing is mapped until the pages are touched
+    EXPECT_EQ(0, paging_add_pages_fake.call_count);
+    EXPECT_EQ(0, paging_temp_map_fake.call_count);
+}
+
+TEST_F(Process, process_reserve_pages_Extends) {
+    int next_heap = proc.next_heap_page;
+
+    EXPECT_NE(nullptr, process_reserve_pages(&proc, 3));
+    EXPECT_NE(nullptr, process_reserve_pages(&proc, 2));
+    EXPECT_EQ(next_heap, proc.reserved[0].start);
+    EXPECT_EQ(5, proc.reserved[0].count);
+    EXPECT_EQ(0, proc.reserved[1].count);
+}
+
+TEST_F(Process, process_reserve_pages_Full) {
+    for (size_t i = 0; i < PROCESS_RESERVED_MAX; i++) {
+        proc.reserved[i].start = 0x10000 + i * 0x10;
+        proc.reserved[i].count = 1;
+    }
+
+    int next_heap = proc.next_heap_page;
+
+    EXPECT_EQ(0, process_reserve_pages(&proc, 1));
+    EXPECT_EQ(next_heap, proc.next_heap_page);
+}
+
+// Process Remove Pages
+
+TEST_F(Process, process_remove_pages_InvalidParameters) {
+    proc.next_heap_page = ADDR2PAGE(VADDR_USER_MEM) + 4;
+
+    EXPECT_NE(0, process_remove_pages(0, (void *)VADDR_USER_MEM, 1));
+    EXPECT_NE(0, process_remove_pages(&proc, (void *)VADDR_USER_MEM, 0));
+
+    // Not page aligned
+    EXPECT_NE(0, process_remove_pages(&proc, (void *)(VADDR_USER_MEM + 4), 1));
+
+    // Before heap
+    EXPECT_NE(0, process_remove_pages(&proc, (void *)(VADDR_USER_MEM - PAGE_SIZE), 1));
+
+    // Past end of heap
+    EXPECT_NE(0, process_remove_pages(&proc, (void *)VADDR_USER_MEM, 5));
+
+    EXPECT_EQ(0, paging_remove_pages_fake.call_count);
+}
+
+TEST_F(Process, process_remove_pages_FailTempMap) {
+    proc.next_heap_page             = ADDR2PAGE(VADDR_USER_MEM) + 4;
+    paging_temp_map_fake.return_val = 0;
+
+    EXPECT_NE(0, process_remove_pages(&proc, (void *)VADDR_USER_MEM, 1));
+    ASSERT_TEMP_MAP_BALANCE_OFFSET(1);
+}
+
+TEST_F(Process, process_remove_pages_FailRemovePages) {
+    proc.next_heap_page                 = ADDR2PAGE(VADDR_USER_MEM) + 4;
+    paging_temp_map_fake.return_val     = &dir;
+    paging_remove_pages_fake.return_val = -1;
+
+    EXPECT_NE(0, process_remove_pages(&proc, (void *)(VADDR_USER_MEM + PAGE_SIZE * 2), 2));
+    EXPECT_EQ(ADDR2PAGE(VADDR_USER_MEM) + 4, proc.next_heap_page);
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
+TEST_F(Process, process_remove_pages) {
+    size_t first_page   = ADDR2PAGE(VADDR_USER_MEM);
+    proc.next_heap_page = first_page + 4;
+
+    paging_temp_map_fake.return_val = &dir;
+
+    // Middle of heap
+    EXPECT_EQ(0, process_remove_pages(&proc, (void *)(VADDR_USER_MEM + PAGE_SIZE), 1));
+    EXPECT_EQ(1, paging_remove_pages_fake.call_count);
+    EXPECT_EQ(&dir, paging_remove_pages_fake.arg0_val);
+    EXPECT_EQ(first_page + 1, paging_remove_pages_fake.arg1_val);
+    EXPECT_EQ(first_page + 1, paging_remove_pages_fake.arg2_val);
+    EXPECT_EQ(first_page + 4, proc.next_heap_page);
+
+    // End of heap
+    EXPECT_EQ(0, process_remove_pages(&proc, (void *)(VADDR_USER_MEM + PAGE_SIZE * 2), 2));
+    EXPECT_EQ(2, paging_remove_pages_fake.call_count);
+    EXPECT_EQ(first_page + 2, paging_remove_pages_fake.arg1_val);
+    EXPECT_EQ(first_page + 3, paging_remove_pages_fake.arg2_val);
+    EXPECT_EQ(first_page + 2, proc.next_heap_page);
+
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
+TEST_F(Process, process_remove_pages_Current) {
+    proc.cr3                         = 0x5000;
+    proc.next_heap_page              = ADDR2PAGE(VADDR_USER_MEM) + 4;
+    mmu_get_curr_dir_fake.return_val = 0x5000;
+
+    EXPECT_EQ(0, process_remove_pages(&proc, (void *)VADDR_USER_MEM, 1));
+    EXPECT_EQ(1, paging_remove_pages_fake.call_count);
+    EXPECT_EQ((mmu_dir_t *)VADDR_RECURSIVE_DIR, paging_remove_pages_fake.arg0_val);
+    EXPECT_EQ(0, paging_temp_map_fake.call_count);
+    EXPECT_EQ(0, paging_temp_free_fake.call_count);
+}
+
+TEST_F(Process, process_remove_pages_Reserved) {
+    size_t first_page   = ADDR2PAGE(VADDR_USER_MEM);
+    proc.next_heap_page = first_page;
+
+    paging_temp_map_fake.return_val = &dir;
+
+    process_reserve_pages(&proc, 8);
+
+    // Start of range
+    EXPECT_EQ(0, process_remove_pages(&proc, (void *)VADDR_USER_MEM, 1));
+    EXPECT_EQ(first_page + 1, proc.reserved[0].start);
+    EXPECT_EQ(7, proc.reserved[0].count);
+
+    // Middle of range is split
+    EXPECT_EQ(0, process_remove_pages(&proc, (void *)(VADDR_USER_MEM + PAGE_SIZE * 3), 2));
+    EXPECT_EQ(first_page + 1, proc.reserved[0].start);
+    EXPECT_EQ(2, proc.reserved[0].count);
+    EXPECT_EQ(first_page + 5, proc.reserved[1].start);
+    EXPECT_EQ(3, proc.reserved[1].count);
+
+    // End of range
+    EXPECT_EQ(0, process_remove_pages(&proc, (void *)(VADDR_USER_MEM + PAGE_SIZE * 7), 1));
+    EXPECT_EQ(2, proc.reserved[1].count);
+
+    // Whole range
+    EXPECT_EQ(0, process_remove_pages(&proc, (void *)(VADDR_USER_MEM + PAGE_SIZE), 2));
+    EXPECT_EQ(0, proc.reserved[0].count);
+
+    EXPECT_EQ(4, paging_remove_pages_fake.call_count);
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
+TEST_F(Process, process_remove_pages_Reserved_FailSplit) {
+    size_t first_page   = ADDR2PAGE(VADDR_USER_MEM);
+    proc.next_heap_page = first_page + 4;
+
+    for (size_t i = 0; i < PROCESS_RESERVED_MAX; i++) {
+        proc.reserved[i].start = 0x10000 + i * 0x10;
+        proc.reserved[i].count = 1;
+    }
+
+    proc.reserved[0].start = first_page;
+    proc.reserved[0].count = 4;
+
+    EXPECT_NE(0, process_remove_pages(&proc, (void *)(VADDR_USER_MEM + PAGE_SIZE), 1));
+    EXPECT_EQ(4, proc.reserved[0].count);
+    EXPECT_EQ(0, paging_remove_pages_fake.call_count);
+}
+
+// Process Map File
+
+TEST_F(Process, process_map_file_InvalidParameters) {
+    EXPECT_EQ(0, process_map_file(0, (tar_fs_t *)1, 0));
+    EXPECT_EQ(0, process_map_file(&proc, 0, 0));
+}
+
+TEST_F(Process, process_map_file_EmptyFile) {
+    EXPECT_EQ(0, process_map_file(&proc, (tar_fs_t *)1, 0));
+    EXPECT_EQ(2, proc.next_heap_page);
+}
+
+TEST_F(Process, process_map_file_NoSpace) {
+    tar_file_size_fake.return_val = PAGE_SIZE;
+    proc.next_heap_page           = FRAME_DB_DIR_INDEX * MMU_TABLE_SIZE;
+
+    EXPECT_EQ(0, process_map_file(&proc, (tar_fs_t *)1, 0));
+}
+
+TEST_F(Process, process_map_file_NoFreeMap) {
+    tar_file_size_fake.return_val = PAGE_SIZE;
+
+    for (size_t i = 0; i < PROCESS_FILE_MAP_MAX; i++) {
+        proc.file_maps[i].count = 1;
+    }
+
+    EXPECT_EQ(0, process_map_file(&proc, (tar_fs_t *)1, 0));
+    EXPECT_EQ(2, proc.next_heap_page);
+}
+
+TEST_F(Process, process_map_file) {
+    tar_file_size_fake.return_val = PAGE_SIZE * 2 + 1;
+    proc.file_maps[0].count       = 1;
+
+    EXPECT_EQ((void *)PAGE2ADDR(2), process_map_file(&proc, (tar_fs_t *)1, 3));
+    EXPECT_EQ(5, proc.next_heap_page);
+    EXPECT_EQ(3, tar_file_size_fake.arg1_val);
+
+    // No pages are added until they are touched
+    EXPECT_EQ(0, paging_add_pages_fake.call_count);
+
+    EXPECT_EQ(2, proc.file_maps[1].start);
+    EXPECT_EQ(3, proc.file_maps[1].count);
+    EXPECT_EQ((tar_fs_t *)1, proc.file_maps[1].tar);
+    EXPECT_EQ(3, proc.file_maps[1].file_i);
+}
+
+// Process Unmap File
+
+TEST_F(Process, process_unmap_file_InvalidParameters) {
+    EXPECT_NE(0, process_unmap_file(0, (void *)PAGE2ADDR(2)));
+}
+
+TEST_F(Process, process_unmap_file_NotMapped) {
+    proc.file_maps[0].start = 2;
+    proc.file_maps[0].count = 3;
+
+    EXPECT_NE(0, process_unmap_file(&proc, (void *)PAGE2ADDR(3)));
+    EXPECT_EQ(0, paging_remove_pages_fake.call_count);
+}
+
+TEST_F(Process, process_unmap_file_FailRemovePages) {
+    paging_temp_map_fake.return_val     = &dir;
+    paging_remove_pages_fake.return_val = -1;
+    proc.file_maps[0].start             = 2;
+    proc.file_maps[0].count             = 3;
+
+    EXPECT_NE(0, process_unmap_file(&proc, (void *)PAGE2ADDR(2)));
+    EXPECT_EQ(3, proc.file_maps[0].count);
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
+TEST_F(Process, process_unmap_file) {
+    paging_temp_map_fake.return_val = &dir;
+    proc.next_heap_page             = 5;
+    proc.file_maps[2].start         = 2;
+    proc.file_maps[2].count         = 3;
+
+    EXPECT_EQ(0, process_unmap_file(&proc, (void *)PAGE2ADDR(2)));
+    EXPECT_EQ(1, paging_remove_pages_fake.call_count);
+    EXPECT_EQ(2, paging_remove_pages_fake.arg1_val);
+    EXPECT_EQ(4, paging_remove_pages_fake.arg2_val);
+    EXPECT_EQ(0, proc.file_maps[2].count);
+    EXPECT_EQ(2, proc.next_heap_page);
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
+// Process Drop File Pages
+
+TEST_F(Process, process_drop_file_pages_InvalidParameters) {
+    EXPECT_NE(0, process_drop_file_pages(0));
+}
+
+TEST_F(Process, process_drop_file_pages_FailTempMap) {
+    paging_temp_map_fake.return_val = 0;
+
+    EXPECT_NE(0, process_drop_file_pages(&proc));
+    EXPECT_EQ(0, paging_drop_clean_pages_fake.call_count);
+}
+
+TEST_F(Process, process_drop_file_pages_FailDrop) {
+    paging_temp_map_fake.return_val         = &dir;
+    paging_drop_clean_pages_fake.return_val = -1;
+    proc.file_maps[0].start                 = 2;
+    proc.file_maps[0].count                 = 3;
+
+    EXPECT_NE(0, process_drop_file_pages(&proc));
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
+TEST_F(Process, process_drop_file_pages) {
+    paging_temp_map_fake.return_val         = &dir;
+    paging_drop_clean_pages_fake.return_val = 2;
+    proc.file_maps[1].start                 = 2;
+    proc.file_maps[1].count                 = 3;
+    proc.file_maps[3].start                 = 8;
+    proc.file_maps[3].count                 = 1;
+
+    EXPECT_EQ(4, process_drop_file_pages(&proc));
+    EXPECT_EQ(2, paging_drop_clean_pages_fake.call_count);
+    EXPECT_EQ(&dir, paging_drop_clean_pages_fake.arg0_val);
+    EXPECT_EQ(8, paging_drop_clean_pages_fake.arg1_val);
+    EXPECT_EQ(8, paging_drop_clean_pages_fake.arg2_val);
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
+// Process Page Fault
+
+TEST_F(Process, process_page_fault_InvalidParameters) {
+    EXPECT_NE(0, process_page_fault(0, VADDR_USER_MEM));
+}
+
+TEST_F(Process, process_page_fault_NotReserved) {
+    proc.reserved[0].start = ADDR2PAGE(VADDR_USER_MEM);
+    proc.reserved[0].count = 2;
+
+    EXPECT_NE(0, process_page_fault(&proc, VADDR_USER_MEM - 1));
+    EXPECT_NE(0, process_page_fault(&proc, VADDR_USER_MEM + PAGE_SIZE * 2));
+    EXPECT_EQ(0, paging_add_pages_fake.call_count);
+}
+
+TEST_F(Process, process_page_fault_FailTempMap) {
+    proc.reserved[0].start          = ADDR2PAGE(VADDR_USER_MEM);
+    proc.reserved[0].count          = 2;
+    paging_temp_map_fake.return_val = 0;
+
+    EXPECT_NE(0, process_page_fault(&proc, VADDR_USER_MEM));
+    EXPECT_EQ(0, paging_add_pages_fake.call_count);
+}
+
+TEST_F(Process, process_page_fault_FailAddPages) {
+    proc.reserved[0].start           = ADDR2PAGE(VADDR_USER_MEM);
+    proc.reserved[0].count           = 2;
+    paging_temp_map_fake.return_val  = &dir;
+    paging_add_pages_fake.return_val = -1;
+
+    EXPECT_NE(0, process_page_fault(&proc, VADDR_USER_MEM));
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
+TEST_F(Process, process_page_fault) {
+    proc.cr3                         = 0x5000;
+    mmu_get_curr_dir_fake.return_val = 0x5000;
+    proc.reserved[1].start           = ADDR2PAGE(VADDR_USER_MEM);
+    proc.reserved[1].count           = 2;
+
+    EXPECT_EQ(0, process_page_fault(&proc, VADDR_USER_MEM + PAGE_SIZE + 12));
+    EXPECT_EQ(1, paging_add_pages_fake.call_count);
+    EXPECT_EQ((mmu_dir_t *)VADDR_RECURSIVE_DIR, paging_add_pages_fake.arg0_val);
+    EXPECT_EQ(ADDR2PAGE(VADDR_USER_MEM) + 1, paging_add_pages_fake.arg1_val);
+    EXPECT_EQ(ADDR2PAGE(VADDR_USER_MEM) + 1, paging_add_pages_fake.arg2_val);
+}
+
+// Process Fork
+
+TEST_F(Process, process_fork_InvalidParameters) {
+    EXPECT_NE(0, process_fork(0, &alt_proc, 0));
+    EXPECT_NE(0, process_fork(&proc, 0, 0));
+}
+
+TEST_F(Process, process_fork_FailCreate) {
+    EXPECT_NE(0, process_fork(&proc, &alt_proc, 0));
+    EXPECT_EQ(0, paging_share_table_fake.call_count);
+}
+
+TEST_F(Process, process_fork_FailTempMap) {
+    ram_page_alloc_fake.return_val  = 0x2000;
+    paging_temp_map_fake.return_val = &dir;
+    proc.cr3                        = 0x5000;
+
+    // Create maps the child dir once, fork fails on the parent dir
+    void * maps[] = {&dir, 0, &dir};
+    SET_RETURN_SEQ(paging_temp_map, maps, 3);
+
+    EXPECT_NE(0, process_fork(&proc, &alt_proc, 0));
+    EXPECT_EQ(0, paging_share_table_fake.call_count);
+    EXPECT_EQ(1, arr_free_fake.call_count);
+    ASSERT_TEMP_MAP_BALANCE_OFFSET(1);
+}
+
+TEST_F(Process, process_fork_FailShare) {
+    ram_page_alloc_fake.return_val     = 0x2000;
+    paging_temp_map_fake.return_val    = &dir;
+    paging_share_table_fake.return_val = -1;
+    proc.cr3                           = 0x5000;
+
+    EXPECT_NE(0, process_fork(&proc, &alt_proc, 0));
+    EXPECT_EQ(1, paging_share_table_fake.call_count);
+    EXPECT_EQ(0, paging_copy_table_fake.call_count);
+
+    // Child is freed with what it shares so far
+    EXPECT_EQ(1, arr_free_fake.call_count);
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
+TEST_F(Process, process_fork_FailCopy) {
+    ram_page_alloc_fake.return_val    = 0x2000;
+    paging_temp_map_fake.return_val   = &dir;
+    paging_copy_table_fake.return_val = -1;
+    proc.cr3                          = 0x5000;
+
+    EXPECT_NE(0, process_fork(&proc, &alt_proc, 0));
+    EXPECT_EQ(1, arr_free_fake.call_count);
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
+TEST_F(Process, process_fork) {
+    ram_page_alloc_fake.return_val   = 0x2000;
+    paging_temp_map_fake.return_val  = &dir;
+    proc.cr3                         = 0x5000;
+    mmu_get_curr_dir_fake.return_val = 0x5000;
+
+    proc.esp0               = 0x1234;
+    proc.next_heap_page     = 0x500;
+    proc.stack_page_count   = 3;
+    proc.signals_callback   = (signals_master_cb_t)0x4321;
+    proc.reserved[1].start  = ADDR2PAGE(VADDR_USER_MEM);
+    proc.reserved[1].count  = 2;
+    proc.memory.large       = (memory_entry_t *)0x10;
+    proc.file_maps[0].start = 0x600;
+    proc.file_maps[0].count = 4;
+
+    EXPECT_EQ(0, process_fork(&proc, &alt_proc, 0x3000));
+
+    EXPECT_EQ(0x2000, alt_proc.cr3);
+    EXPECT_EQ(0x3000, alt_proc.esp);
+    EXPECT_EQ(0x1234, alt_proc.esp0);
+    EXPECT_EQ(0x500, alt_proc.next_heap_page);
+    EXPECT_EQ(3, alt_proc.stack_page_count);
+    EXPECT_EQ(proc.signals_callback, alt_proc.signals_callback);
+    EXPECT_EQ(PROCESS_STATE_LOADED, alt_proc.state);
+    EXPECT_EQ(ADDR2PAGE(VADDR_USER_MEM), alt_proc.reserved[1].start);
+    EXPECT_EQ(2, alt_proc.reserved[1].count);
+    EXPECT_EQ(proc.memory.large, alt_proc.memory.large);
+    EXPECT_EQ(proc.file_maps[0].start, alt_proc.file_maps[0].start);
+    EXPECT_EQ(proc.file_maps[0].count, alt_proc.file_maps[0].count);
+
+    // Heap tables are shared, kernel, frame database and recursive tables are skipped
+    EXPECT_EQ(FRAME_DB_DIR_INDEX - 1, paging_share_table_fake.call_count);
+    EXPECT_EQ((mmu_dir_t *)VADDR_RECURSIVE_DIR, paging_share_table_fake.arg0_val);
+    EXPECT_EQ(&dir, paging_share_table_fake.arg1_val);
+    EXPECT_EQ(FRAME_DB_DIR_INDEX - 1, paging_share_table_fake.arg2_val);
+
+    // Stack table is copied
+    EXPECT_EQ(1, paging_copy_table_fake.call_count);
+    EXPECT_EQ(MMU_DIR_SIZE - 1, paging_copy_table_fake.arg2_val);
+
+    // Nothing was made read only
+    EXPECT_EQ(0, mmu_reload_dir_fake.call_count);
+
+    EXPECT_EQ(0, arr_free_fake.call_count);
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
+static int custom_paging_share_table(mmu_dir_t *, mmu_dir_t *, size_t, int * changed) {
+    *changed = 1;
+    return 0;
+}
+
+TEST_F(Process, process_fork_ReloadOnce) {
+    ram_page_alloc_fake.return_val      = 0x2000;
+    paging_temp_map_fake.return_val     = &dir;
+    paging_share_table_fake.custom_fake = custom_paging_share_table;
+    proc.cr3                            = 0x5000;
+    mmu_get_curr_dir_fake.return_val    = 0x5000;
+
+    EXPECT_EQ(0, process_fork(&proc, &alt_proc, 0x3000));
+    EXPECT_EQ(FRAME_DB_DIR_INDEX - 1, paging_share_table_fake.call_count);
+    EXPECT_EQ(1, mmu_reload_dir_fake.call_count);
+}
+
+TEST_F(Process, process_fork_NotActive_NoReload) {
+    ram_page_alloc_fake.return_val      = 0x2000;
+    paging_temp_map_fake.return_val     = &dir;
+    paging_share_table_fake.custom_fake = custom_paging_share_table;
+    proc.cr3                            = 0x5000;
+
+    EXPECT_EQ(0, process_fork(&proc, &alt_proc, 0x3000));
+    EXPECT_EQ(0, mmu_reload_dir_fake.call_count);
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
+TEST_F(Process, process_page_fault_File_NotActive) {
+    proc.cr3                = 0x5000;
+    proc.file_maps[0].start = ADDR2PAGE(VADDR_USER_MEM);
+    proc.file_maps[0].count = 2;
+
+    EXPECT_NE(0, process_page_fault(&proc, VADDR_USER_MEM));
+    EXPECT_EQ(0, tar_file_open_i_fake.call_count);
+    EXPECT_EQ(0, paging_add_pages_fake.call_count);
+}
+
+TEST_F(Process, process_page_fault_File_FailOpen) {
+    proc.cr3                         = 0x5000;
+    mmu_get_curr_dir_fake.return_val = 0x5000;
+    proc.file_maps[0].start          = ADDR2PAGE(VADDR_USER_MEM);
+    proc.file_maps[0].count          = 2;
+
+    EXPECT_NE(0, process_page_fault(&proc, VADDR_USER_MEM));
+    EXPECT_EQ(0, paging_add_pages_fake.call_count);
+}
+
+TEST_F(Process, process_page_fault_File_FailAddPages) {
+    proc.cr3                         = 0x5000;
+    mmu_get_curr_dir_fake.return_val = 0x5000;
+    tar_file_open_i_fake.return_val  = (tar_fs_file_t *)1;
+    paging_add_pages_fake.return_val = -1;
+    proc.file_maps[0].start          = ADDR2PAGE(VADDR_USER_MEM);
+    proc.file_maps[0].count          = 2;
+
+    EXPECT_NE(0, process_page_fault(&proc, VADDR_USER_MEM));
+    EXPECT_EQ(0, tar_file_read_fake.call_count);
+    EXPECT_EQ(1, tar_file_close_fake.call_count);
+}
+
+TEST_F(Process, process_page_fault_File) {
+    proc.cr3                         = 0x5000;
+    mmu_get_curr_dir_fake.return_val = 0x5000;
+    tar_file_open_i_fake.return_val  = (tar_fs_file_t *)1;
+    proc.file_maps[1].start          = ADDR2PAGE(VADDR_USER_MEM);
+    proc.file_maps[1].count          = 3;
+    proc.file_maps[1].tar            = (tar_fs_t *)2;
+    proc.file_maps[1].file_i         = 4;
+
+    uint32_t page = ADDR2PAGE(VADDR_USER_MEM) + 2;
+
+    EXPECT_EQ(0, process_page_fault(&proc, PAGE2ADDR(page) + 12));
+
+    EXPECT_EQ((tar_fs_t *)2, tar_file_open_i_fake.arg0_val);
+    EXPECT_EQ(4, tar_file_open_i_fake.arg1_val);
+
+    EXPECT_EQ(1, paging_add_pages_fake.call_count);
+    EXPECT_EQ((mmu_dir_t *)VADDR_RECURSIVE_DIR, paging_add_pages_fake.arg0_val);
+    EXPECT_EQ(page, paging_add_pages_fake.arg1_val);
+    EXPECT_EQ(page, paging_add_pages_fake.arg2_val);
+
+    // Page is read from its offset in the file
+    EXPECT_EQ(PAGE_SIZE * 2, tar_file_seek_fake.arg1_val);
+    EXPECT_EQ(TAR_SEEK_ORIGIN_START, tar_file_seek_fake.arg2_val);
+    EXPECT_EQ((char *)PAGE2ADDR(page), tar_file_read_fake.arg1_val);
+    EXPECT_EQ(PAGE_SIZE, tar_file_read_fake.arg2_val);
+    EXPECT_EQ(1, tar_file_close_fake.call_count);
+
+    EXPECT_EQ(1, paging_clean_page_fake.call_count);
+    EXPECT_EQ(page, paging_clean_page_fake.arg1_val);
+
+    // Reserved ranges are not checked
+    EXPECT_EQ(1, paging_add_pages_fake.call_count);
+}
+
 // Process Grow Stack
 
 TEST_F(Process, process_grow_stack_InvalidParameters) {
@@ -394,6 +1012,26 @@ TEST_F(Process, process_grow_stack) {
     ASSERT_TEMP_MAP_BALANCED();
 }
 
+TEST_F(Process, process_grow_stack_Current) {
+    proc.cr3                         = 0x5000;
+    mmu_get_curr_dir_fake.return_val = 0x5000;
+
+    EXPECT_EQ(0, process_grow_stack(&proc));
+    EXPECT_EQ(1, paging_add_pages_fake.call_count);
+    EXPECT_EQ((mmu_dir_t *)VADDR_RECURSIVE_DIR, paging_add_pages_fake.arg0_val);
+    EXPECT_EQ(0, paging_temp_map_fake.call_count);
+    EXPECT_EQ(0, paging_temp_free_fake.call_count);
+}
+
+TEST_F(Process, process_grow_stack_PastRecursive) {
+    paging_temp_map_fake.return_val = &dir;
+    proc.stack_page_count           = MMU_TABLE_SIZE;
+
+    EXPECT_NE(0, process_grow_stack(&proc));
+    EXPECT_EQ(0, paging_add_pages_fake.call_count);
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
 // Process Load Heap
 
 TEST_F(Process, process_load_heap_InvalidParameters) {
@@ -448,6 +1086,21 @@ TEST_F(Process, process_load_heap_SinglePage) {
     ASSERT_TEMP_MAP_BALANCED();
 }
 
+TEST_F(Process, process_load_heap_LargePage) {
+    mmu_dir_get_flags_fake.return_val = MMU_DIR_FLAG_PRESENT | MMU_DIR_FLAG_PAGE_SIZE;
+    mmu_dir_get_addr_fake.return_val  = 0x400000;
+
+    uint32_t heap_page = proc.next_heap_page;
+
+    // Page address comes from the dir entry, no table is mapped
+    EXPECT_EQ(0, process_load_heap(&proc, heap_data.data(), PAGE_SIZE));
+    EXPECT_EQ(1, kmemcpy_fake.call_count);
+    EXPECT_EQ(3, paging_temp_map_fake.call_count);
+    EXPECT_EQ(0x400000 + PAGE2ADDR(heap_page % MMU_TABLE_SIZE), paging_temp_map_fake.arg0_val);
+    EXPECT_EQ(0, mmu_table_get_addr_fake.call_count);
+    ASSERT_TEMP_MAP_BALANCED();
+}
+
 TEST_F(Process, process_load_heap_MultiplePages) {
     EXPECT_EQ(0, process_load_heap(&proc, heap_data.data(), heap_data.size()));
     EXPECT_EQ(3, kmemcpy_fake.call_count);
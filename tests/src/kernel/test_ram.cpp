@@ -8,6 +8,9 @@
 #define REGION_MAX_PAGE_COUNT 0x8000
 #define REGION_MAX_SIZE       (REGION_MAX_PAGE_COUNT * PAGE_SIZE)
 
+#define NEXT_FREE(ENTRY)           (((ENTRY).addr_flags >> 1) & 0x3ff)
+#define SET_NEXT_FREE(ENTRY, WORD) ((ENTRY).addr_flags |= (WORD) << 1)
+
 extern "C" {
 #include "ram.h"
 
@@ -17,8 +20,8 @@ extern "C" {
 // 2 pages for each region in the table + 1 for alignment
 #define BUFFER_SIZE (REGION_MAX_SIZE * 2)
 
-std::array<char, BITMASK_SIZE> bitmasks;
-std::array<char, BUFFER_SIZE>  buffer;
+alignas(PAGE_SIZE) std::array<char, BITMASK_SIZE> bitmasks;
+std::array<char, BUFFER_SIZE>                     buffer;
 
 static ram_table_t ram;
 }
@@ -98,6 +101,11 @@ protected:
         RESET_FAKE(kmemset);
     }
 
+    // Bitmask of the first region as words
+    uint32_t * words() {
+        return (uint32_t *)bitmasks.data();
+    }
+
     char * add_region(size_t pages = 3) {
         char * data = region_1.data + PAGE_SIZE * next_page;
 
@@ -180,6 +188,15 @@ TEST_F(EmptyRam, ram_region_add_memory_TooSmall) {
     EXPECT_EQ(0, kmemmove_fake.call_count);
 }
 
+TEST_F(EmptyRam, ram_region_add_memory_Above4GiB) {
+    EXPECT_NE(0, ram_region_add_memory(0x100000000ull, PAGE_SIZE * 4));
+    EXPECT_NE(0, ram_region_add_memory(0x200000000ull, REGION_MAX_SIZE * 2));
+    EXPECT_EQ(0, ram_region_table_count());
+
+    EXPECT_EQ(0, kmemset_fake.call_count);
+    EXPECT_EQ(0, kmemmove_fake.call_count);
+}
+
 TEST_F(EmptyRam, ram_region_add_memory_Single) {
     EXPECT_EQ(0, ram_region_add_memory(region_1.addr, region_1.size));
     EXPECT_EQ(1, ram_region_table_count());
@@ -382,6 +399,53 @@ TEST_F(Ram, ram_page_alloc_AfterFree) {
     EXPECT_EQ(0, bitmasks[0]);
 }
 
+TEST_F(Ram, ram_page_alloc_SecondWord) {
+    ram.entries[0].page_count = 64;
+    ram.entries[0].free_count = 1;
+    words()[0]                = 0;
+    words()[1]                = 1 << 8;
+
+    EXPECT_EQ(region_1.addr + PAGE_SIZE * 40, ram_page_alloc());
+    EXPECT_EQ(0, words()[1]);
+    EXPECT_EQ(1, NEXT_FREE(ram.entries[0]));
+}
+
+TEST_F(Ram, ram_page_alloc_StartsAtHint) {
+    ram.entries[0].page_count = 64;
+    ram.entries[0].free_count = 2;
+    SET_NEXT_FREE(ram.entries[0], 1);
+    words()[0]                = 0x2;
+    words()[1]                = 0x2;
+
+    EXPECT_EQ(region_1.addr + PAGE_SIZE * 33, ram_page_alloc());
+    EXPECT_EQ(1, NEXT_FREE(ram.entries[0]));
+
+    // Wraps to the start once the words after the hint are used
+    EXPECT_EQ(region_1.addr + PAGE_SIZE, ram_page_alloc());
+    EXPECT_EQ(0, NEXT_FREE(ram.entries[0]));
+}
+
+TEST_F(Ram, ram_page_alloc_HintPastEnd) {
+    SET_NEXT_FREE(ram.entries[0], 5);
+
+    EXPECT_EQ(region_1.addr + PAGE_SIZE, ram_page_alloc());
+    EXPECT_EQ(0, NEXT_FREE(ram.entries[0]));
+}
+
+TEST_F(Ram, ram_page_alloc_KeepsHintAfterFree) {
+    ram.entries[0].page_count = 64;
+    ram.entries[0].free_count = 3;
+    words()[0]                = 0;
+    words()[1]                = 0x3;
+
+    EXPECT_EQ(region_1.addr + PAGE_SIZE * 32, ram_page_alloc());
+
+    // Freed page before the hint is used after the pages that follow
+    words()[0] = 0x2;
+    EXPECT_EQ(region_1.addr + PAGE_SIZE * 33, ram_page_alloc());
+    EXPECT_EQ(region_1.addr + PAGE_SIZE, ram_page_alloc());
+}
+
 // ram_page_palloc
 
 TEST_F(EmptyRam, ram_page_palloc_NoFreeRegion) {
@@ -468,3 +532,533 @@ TEST_F(Ram, ram_page_free_SecondRegion) {
     EXPECT_EQ(0b110, bitmasks[PAGE_SIZE]);
     EXPECT_EQ(2, ram.entries[1].free_count);
 }
+
+TEST_F(Ram, ram_page_free_RegionEnd) {
+    ram.entries[0].free_count = 0;
+    bitmasks[0]               = 0;
+
+    EXPECT_NE(0, ram_page_free(region_1.addr + PAGE_SIZE * 3));
+
+    EXPECT_EQ(0, bitmasks[0]);
+    EXPECT_EQ(0, ram.entries[0].free_count);
+}
+
+TEST_F(Ram, ram_page_free_NextRegionStart) {
+    add_region();
+    ram.entries[0].free_count = 0;
+    bitmasks[0]               = 0;
+
+    // Bitmask page of the second region, not past the end of the first
+    EXPECT_NE(0, ram_page_free(region_1.addr + PAGE_SIZE * 3));
+
+    EXPECT_EQ(0, bitmasks[0]);
+    EXPECT_EQ(0b110, bitmasks[PAGE_SIZE]);
+    EXPECT_EQ(0, ram.entries[0].free_count);
+    EXPECT_EQ(2, ram.entries[1].free_count);
+}
+
+TEST_F(Ram, ram_page_free_ManyRegions) {
+    for (size_t i = 1; i < 9; i++) {
+        add_region();
+    }
+
+    for (size_t i = 0; i < 9; i++) {
+        ram.entries[i].free_count = 0;
+        bitmasks[PAGE_SIZE * i]   = 0;
+    }
+
+    EXPECT_EQ(0, ram_page_free(region_1.addr + PAGE_SIZE * 1));
+    EXPECT_EQ(0, ram_page_free(region_1.addr + PAGE_SIZE * 14));
+    EXPECT_EQ(0, ram_page_free(region_1.addr + PAGE_SIZE * 26));
+
+    for (size_t i = 0; i < 9; i++) {
+        uint8_t expect = 0;
+        if (i == 0) {
+            expect = 0b10;
+        }
+        else if (i == 4) {
+            expect = 0b100;
+        }
+        else if (i == 8) {
+            expect = 0b100;
+        }
+        EXPECT_EQ(expect, (uint8_t)bitmasks[PAGE_SIZE * i]) << "region " << i;
+        EXPECT_EQ(expect ? 1 : 0, ram.entries[i].free_count) << "region " << i;
+    }
+
+    // Past the last region
+    EXPECT_NE(0, ram_page_free(region_1.addr + PAGE_SIZE * 27));
+}
+
+// ram_page_alloc_range
+
+TEST_F(Ram, ram_page_alloc_range_InvalidParameters) {
+    EXPECT_EQ(0, ram_page_alloc_range(0, PAGE_SIZE));
+    EXPECT_EQ(0, ram_page_alloc_range(1, 0));
+    EXPECT_EQ(0, ram_page_alloc_range(1, PAGE_SIZE * 3));
+}
+
+TEST_F(EmptyRam, ram_page_alloc_range_NoFreeRegion) {
+    EXPECT_EQ(0, ram_page_alloc_range(1, PAGE_SIZE));
+}
+
+TEST_F(Ram, ram_page_alloc_range_TooMany) {
+    EXPECT_EQ(0, ram_page_alloc_range(3, PAGE_SIZE));
+
+    EXPECT_EQ(0b110, bitmasks[0]);
+    EXPECT_EQ(2, ram.entries[0].free_count);
+}
+
+TEST_F(Ram, ram_page_alloc_range_Whole) {
+    EXPECT_EQ(region_1.addr + PAGE_SIZE, ram_page_alloc_range(2, PAGE_SIZE));
+
+    EXPECT_EQ(0, bitmasks[0]);
+    EXPECT_EQ(0, ram.entries[0].free_count);
+}
+
+TEST_F(Ram, ram_page_alloc_range_SmallAlign) {
+    EXPECT_EQ(region_1.addr + PAGE_SIZE, ram_page_alloc_range(1, 4));
+
+    EXPECT_EQ(0b100, bitmasks[0]);
+    EXPECT_EQ(1, ram.entries[0].free_count);
+}
+
+TEST_F(Ram, ram_page_alloc_range_AcrossWords) {
+    ram.entries[0].page_count = 96;
+    ram.entries[0].free_count = 94;
+    words()[0]                = 0xfffefffe;
+    words()[1]                = 0xffffffff;
+    words()[2]                = 0xffffffff;
+
+    // Skips the used page 16
+    EXPECT_EQ(region_1.addr + PAGE_SIZE * 17, ram_page_alloc_range(40, PAGE_SIZE));
+
+    EXPECT_EQ(0x0000fffe, words()[0]);
+    EXPECT_EQ(0xfe000000, words()[1]);
+    EXPECT_EQ(0xffffffff, words()[2]);
+    EXPECT_EQ(54, ram.entries[0].free_count);
+}
+
+TEST_F(Ram, ram_page_alloc_range_Aligned) {
+    uint32_t align = PAGE_SIZE * 8;
+    uint32_t first = (region_1.addr + PAGE_SIZE + align - 1) & ~(align - 1);
+
+    ram.entries[0].page_count = 64;
+    ram.entries[0].free_count = 63;
+    words()[0]                = 0xfffffffe;
+    words()[1]                = 0xffffffff;
+
+    EXPECT_EQ(first, ram_page_alloc_range(4, align));
+    EXPECT_EQ(first + align, ram_page_alloc_range(4, align));
+    EXPECT_EQ(55, ram.entries[0].free_count);
+}
+
+TEST_F(Ram, ram_page_alloc_range_AlignedFragmented) {
+    uint32_t align = PAGE_SIZE * 8;
+    uint32_t first = (region_1.addr + PAGE_SIZE + align - 1) & ~(align - 1);
+    size_t   bit   = (first - region_1.addr) / PAGE_SIZE;
+
+    ram.entries[0].page_count = 64;
+    ram.entries[0].free_count = 62;
+    words()[0]                = 0xfffffffe;
+    words()[1]                = 0xffffffff;
+
+    // Last page of the first aligned run is used
+    words()[(bit + 3) / 32] &= ~(1 << ((bit + 3) % 32));
+
+    EXPECT_EQ(first + align, ram_page_alloc_range(4, align));
+    EXPECT_EQ(58, ram.entries[0].free_count);
+}
+
+TEST_F(Ram, ram_page_alloc_range_SecondRegion) {
+    add_region();
+    ram.entries[0].free_count = 1;
+    bitmasks[0]               = 0b10;
+
+    EXPECT_EQ(region_1.addr + PAGE_SIZE * 4, ram_page_alloc_range(2, PAGE_SIZE));
+
+    EXPECT_EQ(0b10, bitmasks[0]);
+    EXPECT_EQ(0, bitmasks[PAGE_SIZE]);
+    EXPECT_EQ(0, ram.entries[1].free_count);
+}
+
+// ram_page_free_range
+
+TEST_F(Ram, ram_page_free_range_InvalidParameters) {
+    EXPECT_NE(0, ram_page_free_range(region_1.addr + PAGE_SIZE, 0));
+    EXPECT_NE(0, ram_page_free_range(region_1.addr + PAGE_SIZE + 1, 1));
+}
+
+TEST_F(Ram, ram_page_free_range_NotFound) {
+    EXPECT_NE(0, ram_page_free_range(0x1000, 1));
+}
+
+TEST_F(Ram, ram_page_free_range_Bitmask) {
+    EXPECT_NE(0, ram_page_free_range(region_1.addr, 1));
+}
+
+TEST_F(Ram, ram_page_free_range_PastEnd) {
+    bitmasks[0]               = 0;
+    ram.entries[0].free_count = 0;
+
+    EXPECT_NE(0, ram_page_free_range(region_1.addr + PAGE_SIZE, 3));
+
+    EXPECT_EQ(0, bitmasks[0]);
+    EXPECT_EQ(0, ram.entries[0].free_count);
+}
+
+TEST_F(Ram, ram_page_free_range_AlreadyFree) {
+    bitmasks[0]               = 0b100;
+    ram.entries[0].free_count = 1;
+
+    EXPECT_NE(0, ram_page_free_range(region_1.addr + PAGE_SIZE, 2));
+
+    EXPECT_EQ(0b100, bitmasks[0]);
+    EXPECT_EQ(1, ram.entries[0].free_count);
+}
+
+TEST_F(Ram, ram_page_free_range) {
+    bitmasks[0]               = 0;
+    ram.entries[0].free_count = 0;
+
+    EXPECT_EQ(0, ram_page_free_range(region_1.addr + PAGE_SIZE, 2));
+
+    EXPECT_EQ(0b110, bitmasks[0]);
+    EXPECT_EQ(2, ram.entries[0].free_count);
+}
+
+TEST_F(Ram, ram_page_free_range_AcrossWords) {
+    ram.entries[0].page_count = 96;
+    ram.entries[0].free_count = 94;
+    words()[0]                = 0xfffefffe;
+    words()[1]                = 0xffffffff;
+    words()[2]                = 0xffffffff;
+
+    uint32_t addr = ram_page_alloc_range(40, PAGE_SIZE);
+
+    EXPECT_EQ(0, ram_page_free_range(addr, 40));
+
+    EXPECT_EQ(0xfffefffe, words()[0]);
+    EXPECT_EQ(0xffffffff, words()[1]);
+    EXPECT_EQ(94, ram.entries[0].free_count);
+}
+
+// ram_page_alloc_n
+
+TEST_F(Ram, ram_page_alloc_n_InvalidParameters) {
+    EXPECT_NE(0, ram_page_alloc_n(0, 1));
+}
+
+TEST_F(Ram, ram_page_alloc_n_TooMany) {
+    uint32_t pages[3] = {0};
+
+    EXPECT_NE(0, ram_page_alloc_n(pages, 3));
+
+    EXPECT_EQ(0, pages[0]);
+    EXPECT_EQ(0b110, bitmasks[0]);
+    EXPECT_EQ(2, ram.entries[0].free_count);
+}
+
+TEST_F(Ram, ram_page_alloc_n_Zero) {
+    uint32_t pages[1] = {0};
+
+    EXPECT_EQ(0, ram_page_alloc_n(pages, 0));
+    EXPECT_EQ(0b110, bitmasks[0]);
+}
+
+TEST_F(Ram, ram_page_alloc_n) {
+    uint32_t pages[2] = {0};
+
+    EXPECT_EQ(0, ram_page_alloc_n(pages, 2));
+
+    EXPECT_EQ(region_1.addr + PAGE_SIZE, pages[0]);
+    EXPECT_EQ(region_1.addr + PAGE_SIZE * 2, pages[1]);
+    EXPECT_EQ(0, bitmasks[0]);
+    EXPECT_EQ(0, ram.entries[0].free_count);
+}
+
+TEST_F(Ram, ram_page_alloc_n_AcrossWords) {
+    uint32_t pages[4] = {0};
+
+    ram.entries[0].page_count = 96;
+    ram.entries[0].free_count = 4;
+    words()[0]                = 0x80000002;
+    words()[2]                = 0x00000011;
+
+    EXPECT_EQ(0, ram_page_alloc_n(pages, 4));
+
+    EXPECT_EQ(region_1.addr + PAGE_SIZE * 1, pages[0]);
+    EXPECT_EQ(region_1.addr + PAGE_SIZE * 31, pages[1]);
+    EXPECT_EQ(region_1.addr + PAGE_SIZE * 64, pages[2]);
+    EXPECT_EQ(region_1.addr + PAGE_SIZE * 68, pages[3]);
+    EXPECT_EQ(0, words()[0]);
+    EXPECT_EQ(0, words()[2]);
+    EXPECT_EQ(0, ram.entries[0].free_count);
+    EXPECT_EQ(2, NEXT_FREE(ram.entries[0]));
+}
+
+TEST_F(Ram, ram_page_alloc_n_SecondRegion) {
+    uint32_t pages[3] = {0};
+
+    add_region();
+
+    EXPECT_EQ(0, ram_page_alloc_n(pages, 3));
+
+    EXPECT_EQ(region_1.addr + PAGE_SIZE, pages[0]);
+    EXPECT_EQ(region_1.addr + PAGE_SIZE * 2, pages[1]);
+    EXPECT_EQ(region_1.addr + PAGE_SIZE * 4, pages[2]);
+    EXPECT_EQ(0, bitmasks[0]);
+    EXPECT_EQ(0b100, bitmasks[PAGE_SIZE]);
+    EXPECT_EQ(0, ram.entries[0].free_count);
+    EXPECT_EQ(1, ram.entries[1].free_count);
+}
+
+// ram_page_free_n
+
+TEST_F(Ram, ram_page_free_n_InvalidParameters) {
+    EXPECT_NE(0, ram_page_free_n(0, 1));
+}
+
+TEST_F(Ram, ram_page_free_n) {
+    uint32_t pages[2] = {region_1.addr + PAGE_SIZE * 2, region_1.addr + PAGE_SIZE};
+
+    bitmasks[0]               = 0;
+    ram.entries[0].free_count = 0;
+
+    EXPECT_EQ(0, ram_page_free_n(pages, 2));
+
+    EXPECT_EQ(0b110, bitmasks[0]);
+    EXPECT_EQ(2, ram.entries[0].free_count);
+}
+
+TEST_F(Ram, ram_page_free_n_SkipsInvalid) {
+    uint32_t pages[4] = {0x1000, region_1.addr, region_1.addr + PAGE_SIZE, region_1.addr + PAGE_SIZE * 2};
+
+    bitmasks[0]               = 0b10;
+    ram.entries[0].free_count = 1;
+
+    // Not found, bitmask page and already free are skipped
+    EXPECT_NE(0, ram_page_free_n(pages, 4));
+
+    EXPECT_EQ(0b110, bitmasks[0]);
+    EXPECT_EQ(2, ram.entries[0].free_count);
+}
+
+TEST_F(Ram, ram_page_free_n_SecondRegion) {
+    uint32_t pages[3] = {0};
+
+    add_region();
+
+    EXPECT_EQ(0, ram_page_alloc_n(pages, 3));
+    EXPECT_EQ(0, ram_page_free_n(pages, 3));
+
+    EXPECT_EQ(0b110, bitmasks[0]);
+    EXPECT_EQ(0b110, bitmasks[PAGE_SIZE]);
+    EXPECT_EQ(2, ram.entries[0].free_count);
+    EXPECT_EQ(2, ram.entries[1].free_count);
+}
+
+// ram_frame_db
+
+class FrameRam : public Ram {
+protected:
+    std::array<ram_frame_t, 16> frames;
+
+    void SetUp() override {
+        Ram::SetUp();
+
+        frames.fill(0xffff);
+    }
+};
+
+TEST_F(Ram, ram_frame_db_size) {
+    EXPECT_EQ(3 * sizeof(ram_frame_t), ram_frame_db_size());
+
+    add_region(4);
+
+    EXPECT_EQ(7 * sizeof(ram_frame_t), ram_frame_db_size());
+}
+
+TEST_F(Ram, ram_frame_NotInitialized) {
+    uint32_t addr = ram_page_alloc();
+
+    EXPECT_NE(0, ram_frame_ref(addr));
+    EXPECT_EQ(-1, ram_frame_ref_count(addr));
+    EXPECT_NE(0, ram_frame_set_flags(addr, RAM_FRAME_FLAG_KERNEL));
+    EXPECT_EQ(-1, ram_frame_get_flags(addr));
+
+    // Single reference without the database
+    EXPECT_EQ(0, ram_page_free(addr));
+    EXPECT_EQ(0b110, bitmasks[0]);
+}
+
+TEST_F(FrameRam, ram_frame_db_init_InvalidParameters) {
+    EXPECT_NE(0, ram_frame_db_init(0));
+}
+
+TEST_F(FrameRam, ram_frame_db_init) {
+    bitmasks[0]               = 0b100;
+    ram.entries[0].free_count = 1;
+
+    EXPECT_EQ(0, ram_frame_db_init(frames.data()));
+
+    EXPECT_EQ(RAM_FRAME_FLAG_KERNEL | 1, frames[0]);
+    EXPECT_EQ(RAM_FRAME_FLAG_KERNEL | 1, frames[1]);
+    EXPECT_EQ(0, frames[2]);
+    EXPECT_EQ(0xffff, frames[3]);
+
+    EXPECT_EQ(1, ram_frame_ref_count(region_1.addr + PAGE_SIZE));
+    EXPECT_EQ(RAM_FRAME_FLAG_KERNEL, ram_frame_get_flags(region_1.addr + PAGE_SIZE));
+    EXPECT_EQ(0, ram_frame_ref_count(region_1.addr + PAGE_SIZE * 2));
+    EXPECT_EQ(0, ram_frame_get_flags(region_1.addr + PAGE_SIZE * 2));
+}
+
+TEST_F(FrameRam, ram_frame_db_init_SecondRegion) {
+    add_region(4);
+    bitmasks[PAGE_SIZE]       = 0b1100;
+    ram.entries[1].free_count = 2;
+
+    EXPECT_EQ(0, ram_frame_db_init(frames.data()));
+
+    // Second region starts after the 3 pages of the first
+    EXPECT_EQ(RAM_FRAME_FLAG_KERNEL | 1, frames[3]);
+    EXPECT_EQ(RAM_FRAME_FLAG_KERNEL | 1, frames[4]);
+    EXPECT_EQ(0, frames[5]);
+    EXPECT_EQ(0, frames[6]);
+    EXPECT_EQ(0xffff, frames[7]);
+
+    EXPECT_EQ(1, ram_frame_ref_count(region_1.addr + PAGE_SIZE * 4));
+    EXPECT_EQ(0, ram_frame_ref_count(region_1.addr + PAGE_SIZE * 5));
+}
+
+TEST_F(FrameRam, ram_frame_ref_NotFound) {
+    EXPECT_EQ(0, ram_frame_db_init(frames.data()));
+
+    EXPECT_NE(0, ram_frame_ref(0x1000));
+    EXPECT_EQ(-1, ram_frame_ref_count(0x1000));
+    EXPECT_NE(0, ram_frame_set_flags(0x1000, RAM_FRAME_FLAG_KERNEL));
+    EXPECT_EQ(-1, ram_frame_get_flags(0x1000));
+}
+
+TEST_F(FrameRam, ram_frame_ref_FreePage) {
+    EXPECT_EQ(0, ram_frame_db_init(frames.data()));
+
+    EXPECT_NE(0, ram_frame_ref(region_1.addr + PAGE_SIZE));
+    EXPECT_EQ(0, ram_frame_ref_count(region_1.addr + PAGE_SIZE));
+}
+
+TEST_F(FrameRam, ram_frame_ref_Max) {
+    EXPECT_EQ(0, ram_frame_db_init(frames.data()));
+
+    uint32_t addr = ram_page_alloc();
+    frames[1]     = RAM_FRAME_REF_MASK;
+
+    EXPECT_NE(0, ram_frame_ref(addr));
+    EXPECT_EQ(RAM_FRAME_REF_MASK, ram_frame_ref_count(addr));
+    EXPECT_EQ(0, ram_frame_get_flags(addr));
+}
+
+TEST_F(FrameRam, ram_page_alloc) {
+    EXPECT_EQ(0, ram_frame_db_init(frames.data()));
+
+    uint32_t addr = ram_page_alloc();
+
+    EXPECT_EQ(region_1.addr + PAGE_SIZE, addr);
+    EXPECT_EQ(1, frames[1]);
+    EXPECT_EQ(1, ram_frame_ref_count(addr));
+}
+
+TEST_F(FrameRam, ram_page_free_Shared) {
+    EXPECT_EQ(0, ram_frame_db_init(frames.data()));
+
+    uint32_t addr = ram_page_alloc();
+
+    EXPECT_EQ(0, ram_frame_ref(addr));
+    EXPECT_EQ(2, ram_frame_ref_count(addr));
+
+    // First free only drops a reference
+    EXPECT_EQ(0, ram_page_free(addr));
+    EXPECT_EQ(1, ram_frame_ref_count(addr));
+    EXPECT_EQ(0b100, bitmasks[0]);
+    EXPECT_EQ(1, ram.entries[0].free_count);
+
+    EXPECT_EQ(0, ram_page_free(addr));
+    EXPECT_EQ(0, ram_frame_ref_count(addr));
+    EXPECT_EQ(0b110, bitmasks[0]);
+    EXPECT_EQ(2, ram.entries[0].free_count);
+
+    EXPECT_NE(0, ram_page_free(addr));
+}
+
+TEST_F(FrameRam, ram_frame_set_flags) {
+    EXPECT_EQ(0, ram_frame_db_init(frames.data()));
+
+    uint32_t addr = ram_page_alloc();
+
+    EXPECT_EQ(0, ram_frame_set_flags(addr, RAM_FRAME_FLAG_KERNEL | 0x3));
+    EXPECT_EQ(RAM_FRAME_FLAG_KERNEL, ram_frame_get_flags(addr));
+    EXPECT_EQ(1, ram_frame_ref_count(addr));
+
+    EXPECT_EQ(0, ram_frame_ref(addr));
+    EXPECT_EQ(RAM_FRAME_FLAG_KERNEL, ram_frame_get_flags(addr));
+    EXPECT_EQ(2, ram_frame_ref_count(addr));
+
+    EXPECT_EQ(0, ram_frame_set_flags(addr, 0));
+    EXPECT_EQ(0, ram_frame_get_flags(addr));
+    EXPECT_EQ(2, ram_frame_ref_count(addr));
+}
+
+TEST_F(FrameRam, ram_frame_set_flags_FreePage) {
+    EXPECT_EQ(0, ram_frame_db_init(frames.data()));
+
+    EXPECT_NE(0, ram_frame_set_flags(region_1.addr + PAGE_SIZE, RAM_FRAME_FLAG_KERNEL));
+    EXPECT_EQ(0, ram_frame_get_flags(region_1.addr + PAGE_SIZE));
+}
+
+TEST_F(FrameRam, ram_frame_set_flags_ClearedOnFree) {
+    EXPECT_EQ(0, ram_frame_db_init(frames.data()));
+
+    uint32_t addr = ram_page_alloc();
+
+    EXPECT_EQ(0, ram_frame_set_flags(addr, RAM_FRAME_FLAG_KERNEL));
+    EXPECT_EQ(0, ram_page_free(addr));
+
+    EXPECT_EQ(0, frames[1]);
+    EXPECT_EQ(0, ram_frame_get_flags(addr));
+}
+
+TEST_F(FrameRam, ram_page_alloc_n) {
+    uint32_t pages[2] = {0};
+
+    EXPECT_EQ(0, ram_frame_db_init(frames.data()));
+    EXPECT_EQ(0, ram_page_alloc_n(pages, 2));
+
+    EXPECT_EQ(1, frames[1]);
+    EXPECT_EQ(1, frames[2]);
+
+    EXPECT_EQ(0, ram_frame_ref(pages[1]));
+    EXPECT_EQ(0, ram_page_free_n(pages, 2));
+
+    EXPECT_EQ(0, frames[1]);
+    EXPECT_EQ(1, frames[2]);
+    EXPECT_EQ(0b010, bitmasks[0]);
+    EXPECT_EQ(1, ram.entries[0].free_count);
+}
+
+TEST_F(FrameRam, ram_page_alloc_range) {
+    EXPECT_EQ(0, ram_frame_db_init(frames.data()));
+
+    uint32_t addr = ram_page_alloc_range(2, PAGE_SIZE);
+
+    EXPECT_EQ(region_1.addr + PAGE_SIZE, addr);
+    EXPECT_EQ(1, frames[1]);
+    EXPECT_EQ(1, frames[2]);
+
+    EXPECT_EQ(0, ram_frame_ref(addr));
+    EXPECT_EQ(0, ram_page_free_range(addr, 2));
+
+    EXPECT_EQ(1, frames[1]);
+    EXPECT_EQ(0, frames[2]);
+    EXPECT_EQ(0b100, bitmasks[0]);
+    EXPECT_EQ(1, ram.entries[0].free_count);
+}
@@ -0,0 +1,168 @@
+#include <cstdlib>
+#include <vector>
+
+#include "test_common.h"
+
+extern "C" {
+#include "libc/arena.h"
+}
+
+#define CHUNK_SIZE 128
+#define CHUNK_DATA (CHUNK_SIZE - sizeof(arena_chunk_t))
+
+class Arena : public testing::Test {
+protected:
+    arena_t arena;
+
+    void SetUp() override {
+        init_mocks();
+
+        ASSERT_EQ(0, arena_create(&arena, CHUNK_SIZE));
+    }
+
+    void TearDown() override {
+        arena_free(&arena);
+    }
+};
+
+TEST_F(Arena, arena_create) {
+    // Invalid Parameters
+    EXPECT_NE(0, arena_create(0, CHUNK_SIZE));
+    EXPECT_NE(0, arena_create(&arena, 0));
+    EXPECT_NE(0, arena_create(&arena, sizeof(arena_chunk_t)));
+
+    EXPECT_EQ(0, arena_create(&arena, CHUNK_SIZE));
+    EXPECT_EQ(nullptr, arena.head);
+    EXPECT_EQ(CHUNK_SIZE, arena.chunk_size);
+
+    // No chunks until first alloc
+    EXPECT_EQ(0, pmalloc_fake.call_count);
+}
+
+TEST_F(Arena, arena_free) {
+    // Invalid Parameters
+    arena_free(0);
+
+    // No chunks
+    arena_free(&arena);
+    EXPECT_EQ(0, pfree_fake.call_count);
+
+    arena_alloc(&arena, CHUNK_DATA);
+    arena_alloc(&arena, CHUNK_DATA);
+
+    arena_free(&arena);
+    EXPECT_EQ(2, pfree_fake.call_count);
+    EXPECT_EQ(nullptr, arena.head);
+}
+
+TEST_F(Arena, arena_alloc) {
+    // Invalid Parameters
+    EXPECT_EQ(nullptr, arena_alloc(0, 4));
+    EXPECT_EQ(nullptr, arena_alloc(&arena, 0));
+
+    char * ptr_1 = (char *)arena_alloc(&arena, 4);
+    ASSERT_NE(nullptr, ptr_1);
+    EXPECT_EQ(1, pmalloc_fake.call_count);
+    EXPECT_EQ(CHUNK_SIZE, pmalloc_fake.arg0_val);
+    EXPECT_EQ((char *)arena.head + sizeof(arena_chunk_t), ptr_1);
+
+    // Next allocation follows the last, aligned to 4 bytes
+    char * ptr_2 = (char *)arena_alloc(&arena, 3);
+    EXPECT_EQ(ptr_1 + 4, ptr_2);
+
+    char * ptr_3 = (char *)arena_alloc(&arena, 4);
+    EXPECT_EQ(ptr_2 + 4, ptr_3);
+
+    EXPECT_EQ(1, pmalloc_fake.call_count);
+    EXPECT_EQ(12, arena.head->used);
+}
+
+TEST_F(Arena, arena_alloc_NewChunk) {
+    arena_alloc(&arena, CHUNK_DATA - 4);
+    arena_chunk_t * first = arena.head;
+
+    // Exactly fills the chunk
+    arena_alloc(&arena, 4);
+    EXPECT_EQ(1, pmalloc_fake.call_count);
+    EXPECT_EQ(CHUNK_DATA, first->used);
+
+    void * ptr = arena_alloc(&arena, 4);
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(2, pmalloc_fake.call_count);
+    EXPECT_NE(first, arena.head);
+    EXPECT_EQ(first, arena.head->next);
+    EXPECT_EQ((char *)arena.head + sizeof(arena_chunk_t), ptr);
+}
+
+TEST_F(Arena, arena_alloc_LargeChunk) {
+    void * ptr_1 = arena_alloc(&arena, 4);
+
+    arena_chunk_t * first = arena.head;
+
+    void * large = arena_alloc(&arena, CHUNK_SIZE * 2);
+    ASSERT_NE(nullptr, large);
+    EXPECT_EQ(2, pmalloc_fake.call_count);
+    EXPECT_EQ(CHUNK_SIZE * 2 + sizeof(arena_chunk_t), pmalloc_fake.arg0_val);
+
+    // Current chunk is still used
+    EXPECT_EQ(first, arena.head);
+    EXPECT_EQ(large, (char *)first->next + sizeof(arena_chunk_t));
+
+    void * ptr_2 = arena_alloc(&arena, 4);
+    EXPECT_EQ((char *)ptr_1 + 4, ptr_2);
+    EXPECT_EQ(2, pmalloc_fake.call_count);
+}
+
+TEST_F(Arena, arena_alloc_LargeFirst) {
+    void * large = arena_alloc(&arena, CHUNK_SIZE);
+    ASSERT_NE(nullptr, large);
+    EXPECT_EQ(1, pmalloc_fake.call_count);
+
+    // Large chunk is full, next allocation adds a chunk
+    void * ptr = arena_alloc(&arena, 4);
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(2, pmalloc_fake.call_count);
+    EXPECT_EQ(CHUNK_SIZE, pmalloc_fake.arg0_val);
+}
+
+TEST_F(Arena, arena_alloc_MallocFails) {
+    pmalloc_fake.custom_fake = 0;
+    pmalloc_fake.return_val  = 0;
+
+    EXPECT_EQ(nullptr, arena_alloc(&arena, 4));
+    EXPECT_EQ(nullptr, arena.head);
+}
+
+TEST_F(Arena, arena_reset) {
+    // Invalid Parameters
+    arena_reset(0);
+
+    // No chunks
+    arena_reset(&arena);
+    EXPECT_EQ(nullptr, arena.head);
+
+    void * ptr = arena_alloc(&arena, 4);
+    arena_alloc(&arena, CHUNK_DATA);
+    arena_alloc(&arena, CHUNK_SIZE * 2);
+    EXPECT_EQ(3, pmalloc_fake.call_count);
+
+    arena_reset(&arena);
+    EXPECT_EQ(2, pfree_fake.call_count);
+    ASSERT_NE(nullptr, arena.head);
+    EXPECT_EQ(nullptr, arena.head->next);
+    EXPECT_EQ(0, arena.head->used);
+    EXPECT_EQ(CHUNK_DATA, arena.head->size);
+
+    // Kept chunk is reused
+    void * ptr_2 = arena_alloc(&arena, 4);
+    EXPECT_EQ(3, pmalloc_fake.call_count);
+    EXPECT_EQ((char *)arena.head + sizeof(arena_chunk_t), ptr_2);
+}
+
+TEST_F(Arena, arena_reset_OnlyLarge) {
+    arena_alloc(&arena, CHUNK_SIZE * 2);
+
+    arena_reset(&arena);
+    EXPECT_EQ(1, pfree_fake.call_count);
+    EXPECT_EQ(nullptr, arena.head);
+}
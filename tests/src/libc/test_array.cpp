@@ -116,7 +116,25 @@ TEST_F(Array, arr_size) {
 
     ASSERT_EQ(1, prealloc_fake.call_count);
     EXPECT_EQ(old_data, prealloc_fake.arg0_val);
-    EXPECT_EQ(4, prealloc_fake.arg1_val);
+    EXPECT_EQ(6, prealloc_fake.arg1_val);
+}
+
+TEST_F(Array, arr_insert_grow_elem_size) {
+    arr_free(&arr);
+    ASSERT_EQ(0, arr_create(&arr, 2, 4));
+
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(0, arr_insert(&arr, i, &i));
+    }
+
+    // Size is in bytes
+    ASSERT_EQ(1, prealloc_fake.call_count);
+    EXPECT_EQ(16, prealloc_fake.arg1_val);
+    EXPECT_EQ(4, arr.size);
+
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(i, *(int *)arr_at(&arr, i));
+    }
 }
 
 TEST_F(Array, arr_data) {
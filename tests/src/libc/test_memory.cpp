@@ -29,6 +29,14 @@ TEST_F(LibC, pmalloc) {
     EXPECT_EQ(12, memory_alloc_fake.arg1_val);
 }
 
+TEST_F(LibC, pmalloc_aligned) {
+    void * ptr = pmalloc_aligned(12, 64);
+    EXPECT_EQ(1, memory_alloc_aligned_fake.call_count);
+    EXPECT_EQ(&memory, memory_alloc_aligned_fake.arg0_val);
+    EXPECT_EQ(12, memory_alloc_aligned_fake.arg1_val);
+    EXPECT_EQ(64, memory_alloc_aligned_fake.arg2_val);
+}
+
 TEST_F(LibC, prealloc) {
     char buff[12];
 
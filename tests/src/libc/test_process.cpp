@@ -69,3 +69,9 @@ TEST_F(LibC, getpid) {
     EXPECT_EQ(2, getpid());
     ASSERT_EQ(1, _sys_proc_getpid_fake.call_count);
 }
+
+TEST_F(LibC, proc_fork) {
+    _sys_proc_fork_fake.return_val = 3;
+    EXPECT_EQ(3, proc_fork());
+    ASSERT_EQ(1, _sys_proc_fork_fake.call_count);
+}
@@ -112,6 +112,33 @@ TEST_F(LibK, page_alloc) {
     EXPECT_EQ(send_call_fake.arg1_val, 1);
 }
 
+TEST_F(LibK, page_free) {
+    send_call_fake.return_val = 0;
+    EXPECT_EQ(0, _sys_page_free((void *)0x1000, 2));
+    EXPECT_EQ(send_call_fake.call_count, 1);
+    EXPECT_EQ(send_call_fake.arg0_val, 0x204);
+    EXPECT_EQ(send_call_fake.arg1_val, 0x1000);
+    EXPECT_EQ(send_call_fake.arg2_val, 2);
+}
+
+TEST_F(LibK, map_file) {
+    const char * filename = "data.bin";
+
+    send_call_fake.return_val = 0x400000;
+    EXPECT_EQ((void *)0x400000, _sys_map_file(filename));
+    EXPECT_EQ(send_call_fake.call_count, 1);
+    EXPECT_EQ(send_call_fake.arg0_val, 0x205);
+    EXPECT_EQ(filename, (const char *)send_call_fake.arg1_val);
+}
+
+TEST_F(LibK, unmap_file) {
+    send_call_fake.return_val = 0;
+    EXPECT_EQ(0, _sys_unmap_file((void *)0x400000));
+    EXPECT_EQ(send_call_fake.call_count, 1);
+    EXPECT_EQ(send_call_fake.arg0_val, 0x206);
+    EXPECT_EQ(send_call_fake.arg1_val, 0x400000);
+}
+
 TEST_F(LibK, exit) {
     _sys_proc_exit(200);
     EXPECT_EQ(send_call_noret_fake.call_count, 1);
@@ -154,6 +181,13 @@ TEST_F(LibK, getpid) {
     EXPECT_EQ(0x304, send_call_fake.arg0_val);
 }
 
+TEST_F(LibK, proc_fork) {
+    send_call_fake.return_val = 4;
+    EXPECT_EQ(4, _sys_proc_fork());
+    ASSERT_EQ(1, send_call_fake.call_count);
+    EXPECT_EQ(0x307, send_call_fake.arg0_val);
+}
+
 TEST_F(LibK, queue_event) {
     ebus_event_t event;
     event.event_id   = EBUS_EVENT_TIMER;
@@ -1,22 +1,42 @@
 #include <array>
 #include <cstdlib>
+#include <vector>
 
 #include "test_common.h"
 
 #define PAGE_SIZE 4096
 
-#define MAGIC_FREE 0x46524545
-#define MAGIC_USED 0x55534544
+#define MAGIC_FREE  0x46524545
+#define MAGIC_USED  0x55534544
+#define MAGIC_LARGE 0x4c415247
 
-#define PAGE_COUNT_MAX 5
+#define PAGE_COUNT_MAX 8
 
-std::array<char, PAGE_SIZE * PAGE_COUNT_MAX> pages;
-size_t                                       page_count;
+// Class index of a free entry that fills one page
+#define PAGE_ENTRY_CLASS (MEMORY_SMALL_CLASS_COUNT + 4)
+
+// Free entries keep their next free entry at the start of the payload
+#define FREE_LINK_NEXT(ENTRY) (*(memory_entry_t **)ENTRY_PTR(ENTRY))
+
+// Head of the free list that ENTRY belongs to
+#define FREE_LIST_HEAD(ENTRY) (mem.free_lists[free_class((ENTRY)->size)])
+
+static size_t free_class(size_t size) {
+    if (size < MEMORY_SMALL_CLASS_MAX) {
+        return size >> 2;
+    }
+
+    return MEMORY_SMALL_CLASS_COUNT + (31 - __builtin_clz(size)) - 7;
+}
+
+alignas(PAGE_SIZE) std::array<char, PAGE_SIZE * PAGE_COUNT_MAX> pages;
+size_t                                                          page_count;
 
 extern "C" {
 #include "memory_alloc.h"
 
 FAKE_VALUE_FUNC(void *, alloc_page, size_t);
+FAKE_VALUE_FUNC(int, free_page, void *, size_t);
 }
 
 class MemoryAlloc : public ::testing::Test {
@@ -31,24 +51,26 @@ protected:
         init_mocks();
 
         RESET_FAKE(alloc_page);
+        RESET_FAKE(free_page);
 
         pages.fill(0);
+        memset(&mem, 0, sizeof(mem));
 
         entry_1 = (memory_entry_t *)(pages.data());
         entry_2 = (memory_entry_t *)(pages.data() + PAGE_SIZE);
         entry_3 = (memory_entry_t *)(pages.data() + PAGE_SIZE * 2);
 
-        entry_1->magic = MAGIC_FREE;
+        entry_1->magic = MAGIC_USED;
         entry_1->size  = PAGE_SIZE - sizeof(memory_entry_t);
         entry_1->prev  = 0;
         entry_1->next  = entry_2;
 
-        entry_2->magic = MAGIC_FREE;
+        entry_2->magic = MAGIC_USED;
         entry_2->size  = PAGE_SIZE - sizeof(memory_entry_t);
         entry_2->prev  = entry_1;
         entry_2->next  = entry_3;
 
-        entry_3->magic = MAGIC_FREE;
+        entry_3->magic = MAGIC_USED;
         entry_3->size  = PAGE_SIZE - sizeof(memory_entry_t);
         entry_3->prev  = entry_2;
         entry_3->next  = 0;
@@ -60,6 +82,12 @@ protected:
         alloc_page_fake.return_val = pages.data() + PAGE_SIZE * 3;
     }
 
+    void free_entries(std::initializer_list<memory_entry_t *> entries) {
+        for (auto entry : entries) {
+            ASSERT_EQ(0, memory_free(&mem, ENTRY_PTR(entry)));
+        }
+    }
+
     void expect_memory_joined() {
         memory_entry_t * entry = mem.first;
 
@@ -78,21 +106,22 @@ protected:
 };
 
 #define ASSERT_MEMORY_JOINED() ASSERT_NO_FATAL_FAILURE(expect_memory_joined())
+#define FREE_ENTRIES(...)      ASSERT_NO_FATAL_FAILURE(free_entries({__VA_ARGS__}))
 
 TEST_F(MemoryAlloc, memory_init) {
-    EXPECT_NE(0, memory_init(&mem, 0));
-    EXPECT_NE(0, memory_init(0, alloc_page));
+    EXPECT_NE(0, memory_init(&mem, 0, 0));
+    EXPECT_NE(0, memory_init(0, alloc_page, 0));
 
     alloc_page_fake.return_val = 0;
 
-    EXPECT_NE(0, memory_init(&mem, alloc_page));
+    EXPECT_NE(0, memory_init(&mem, alloc_page, 0));
     EXPECT_EQ(1, alloc_page_fake.call_count);
     EXPECT_EQ(1, alloc_page_fake.arg0_val);
 
     alloc_page_fake.return_val = pages.data();
     pages.fill(0);
 
-    EXPECT_EQ(0, memory_init(&mem, alloc_page));
+    EXPECT_EQ(0, memory_init(&mem, alloc_page, 0));
     EXPECT_EQ(entry_1, mem.first);
     EXPECT_EQ(entry_1, mem.last);
 
@@ -102,6 +131,7 @@ TEST_F(MemoryAlloc, memory_init) {
     EXPECT_EQ(PAGE_SIZE - sizeof(memory_entry_t), entry_1->size);
     EXPECT_EQ(nullptr, entry_1->next);
     EXPECT_EQ(nullptr, entry_1->prev);
+    EXPECT_EQ(entry_1, mem.free_lists[PAGE_ENTRY_CLASS]);
 }
 
 TEST_F(MemoryAlloc, memory_alloc_InvalidParameters) {
@@ -110,15 +140,17 @@ TEST_F(MemoryAlloc, memory_alloc_InvalidParameters) {
 }
 
 TEST_F(MemoryAlloc, memory_alloc_FoundEntry) {
+    FREE_ENTRIES(entry_1, entry_2, entry_3);
+
     void * ptr = memory_alloc(&mem, 1);
     EXPECT_EQ(ENTRY_PTR(entry_1), ptr);
     EXPECT_EQ(MAGIC_USED, entry_1->magic);
-    EXPECT_EQ(4, entry_1->size);
+    EXPECT_EQ(8, entry_1->size);
     ASSERT_MEMORY_JOINED();
 }
 
 TEST_F(MemoryAlloc, memory_alloc_FirstUsed) {
-    entry_1->magic = MAGIC_USED;
+    FREE_ENTRIES(entry_2, entry_3);
 
     void * ptr = memory_alloc(&mem, PAGE_SIZE - sizeof(memory_entry_t));
     EXPECT_EQ(ENTRY_PTR(entry_2), ptr);
@@ -135,15 +167,16 @@ TEST_F(MemoryAlloc, memory_alloc_AfterInit_OneEntryFree) {
     memset(entry_2, 0, sizeof(memory_entry_t));
     memset(entry_3, 0, sizeof(memory_entry_t));
 
+    FREE_ENTRIES(entry_1);
+
     void * ptr = memory_alloc(&mem, 1);
     EXPECT_EQ(ENTRY_PTR(entry_1), ptr);
     EXPECT_EQ(MAGIC_USED, entry_1->magic);
-    EXPECT_EQ(4, entry_1->size);
+    EXPECT_EQ(8, entry_1->size);
     ASSERT_MEMORY_JOINED();
 }
 
 TEST_F(MemoryAlloc, memory_alloc_AfterInit_OneEntryUsed) {
-    entry_1->magic             = MAGIC_USED;
     entry_1->next              = 0;
     mem.last                   = entry_1;
     alloc_page_fake.return_val = entry_2;
@@ -154,11 +187,13 @@ TEST_F(MemoryAlloc, memory_alloc_AfterInit_OneEntryUsed) {
     void * ptr = memory_alloc(&mem, 1);
     EXPECT_EQ(ENTRY_PTR(entry_2), ptr);
     EXPECT_EQ(MAGIC_USED, entry_2->magic);
-    EXPECT_EQ(4, entry_2->size);
+    EXPECT_EQ(8, entry_2->size);
     ASSERT_MEMORY_JOINED();
 }
 
 TEST_F(MemoryAlloc, memory_alloc_FirstFoundTooSmall) {
+    FREE_ENTRIES(entry_1, entry_2, entry_3);
+
     void * ptr = memory_alloc(&mem, PAGE_SIZE);
     EXPECT_EQ(ENTRY_PTR(entry_1), ptr);
     EXPECT_EQ(MAGIC_USED, entry_1->magic);
@@ -167,7 +202,7 @@ TEST_F(MemoryAlloc, memory_alloc_FirstFoundTooSmall) {
 }
 
 TEST_F(MemoryAlloc, memory_alloc_FirstFoundTooSmall_CantMerge) {
-    entry_2->magic = MAGIC_USED;
+    FREE_ENTRIES(entry_1, entry_3);
 
     void * ptr = memory_alloc(&mem, PAGE_SIZE);
     EXPECT_EQ(ENTRY_PTR(entry_3), ptr);
@@ -179,7 +214,7 @@ TEST_F(MemoryAlloc, memory_alloc_FirstFoundTooSmall_CantMerge) {
 }
 
 TEST_F(MemoryAlloc, memory_alloc_MergeWithLast) {
-    entry_1->magic = MAGIC_USED;
+    FREE_ENTRIES(entry_2, entry_3);
 
     void * ptr = memory_alloc(&mem, PAGE_SIZE);
     EXPECT_EQ(ENTRY_PTR(entry_2), ptr);
@@ -189,6 +224,7 @@ TEST_F(MemoryAlloc, memory_alloc_MergeWithLast) {
 }
 
 TEST_F(MemoryAlloc, memory_alloc_MergeAll) {
+    FREE_ENTRIES(entry_1, entry_2, entry_3);
 
     void * ptr = memory_alloc(&mem, PAGE_SIZE * 3 - sizeof(memory_entry_t));
     EXPECT_EQ(ENTRY_PTR(entry_1), ptr);
@@ -201,10 +237,6 @@ TEST_F(MemoryAlloc, memory_alloc_MergeAll) {
 }
 
 TEST_F(MemoryAlloc, memory_alloc_AllocPage_SizeAligned) {
-    entry_1->magic = MAGIC_USED;
-    entry_2->magic = MAGIC_USED;
-    entry_3->magic = MAGIC_USED;
-
     memory_entry_t * entry_4 = (memory_entry_t *)(pages.data() + PAGE_SIZE * 3);
 
     void * ptr = memory_alloc(&mem, PAGE_SIZE - sizeof(memory_entry_t));
@@ -217,8 +249,7 @@ TEST_F(MemoryAlloc, memory_alloc_AllocPage_SizeAligned) {
 }
 
 TEST_F(MemoryAlloc, memory_alloc_AllocPage_LastFree) {
-    entry_1->magic = MAGIC_USED;
-    entry_2->magic = MAGIC_USED;
+    FREE_ENTRIES(entry_3);
 
     void * ptr = memory_alloc(&mem, PAGE_SIZE);
     EXPECT_EQ(ENTRY_PTR(entry_3), ptr);
@@ -230,10 +261,6 @@ TEST_F(MemoryAlloc, memory_alloc_AllocPage_LastFree) {
 }
 
 TEST_F(MemoryAlloc, memory_alloc_AllocPage_AllocPageFails) {
-    entry_1->magic = MAGIC_USED;
-    entry_2->magic = MAGIC_USED;
-    entry_3->magic = MAGIC_USED;
-
     alloc_page_fake.return_val = 0;
 
     // Keep as 1 to test size not aligned to 4 bytes
@@ -241,67 +268,456 @@ TEST_F(MemoryAlloc, memory_alloc_AllocPage_AllocPageFails) {
     ASSERT_MEMORY_JOINED();
 }
 
+TEST_F(MemoryAlloc, memory_alloc_AllocPage_NotAdjacent) {
+    entry_1->next = 0;
+    mem.last      = entry_1;
+    FREE_ENTRIES(entry_1);
+
+    // First page leaves a gap after entry_1, the second follows the first
+    void * page_seq[] = {entry_3, pages.data() + PAGE_SIZE * 3};
+    SET_RETURN_SEQ(alloc_page, page_seq, 2);
+
+    void * ptr = memory_alloc(&mem, PAGE_SIZE);
+    EXPECT_EQ(ENTRY_PTR(entry_3), ptr);
+    EXPECT_EQ(MAGIC_USED, entry_3->magic);
+    EXPECT_EQ(PAGE_SIZE, entry_3->size);
+    EXPECT_EQ(MAGIC_FREE, entry_1->magic);
+    EXPECT_EQ(PAGE_SIZE - sizeof(memory_entry_t), entry_1->size);
+    EXPECT_EQ(entry_3, entry_1->next);
+    ASSERT_EQ(2, alloc_page_fake.call_count);
+    EXPECT_EQ(1, alloc_page_fake.arg0_history[0]);
+    EXPECT_EQ(2, alloc_page_fake.arg0_history[1]);
+}
+
+TEST_F(MemoryAlloc, memory_alloc_ReuseSmallClass) {
+    alloc_page_fake.return_val = pages.data();
+    ASSERT_EQ(0, memory_init(&mem, alloc_page, 0));
+
+    void * ptr_1 = memory_alloc(&mem, 16);
+    void * ptr_2 = memory_alloc(&mem, 16);
+    ASSERT_NE(nullptr, ptr_1);
+    ASSERT_NE(nullptr, ptr_2);
+
+    EXPECT_EQ(0, memory_free(&mem, ptr_1));
+    EXPECT_EQ(entry_1, mem.free_lists[4]);
+
+    EXPECT_EQ(ptr_1, memory_alloc(&mem, 13));
+    EXPECT_EQ(nullptr, mem.free_lists[4]);
+    EXPECT_EQ(0, mem.class_mask[0] & (1 << 4));
+    EXPECT_EQ(1, alloc_page_fake.call_count);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_alloc_SplitLargerClass) {
+    alloc_page_fake.return_val = pages.data();
+    ASSERT_EQ(0, memory_init(&mem, alloc_page, 0));
+
+    void * ptr_1 = memory_alloc(&mem, 96);
+    void * ptr_2 = memory_alloc(&mem, 16);
+    ASSERT_NE(nullptr, ptr_2);
+
+    EXPECT_EQ(0, memory_free(&mem, ptr_1));
+
+    // Smallest non-empty class is the freed 96 byte entry
+    EXPECT_EQ(ptr_1, memory_alloc(&mem, 32));
+    EXPECT_EQ(32, entry_1->size);
+
+    memory_entry_t * remain = entry_1->next;
+    EXPECT_EQ(MAGIC_FREE, remain->magic);
+    EXPECT_EQ(96 - 32 - sizeof(memory_entry_t), remain->size);
+    EXPECT_EQ(remain, mem.free_lists[remain->size >> 2]);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_alloc_LargeClassTooSmall) {
+    alloc_page_fake.return_val = pages.data();
+    ASSERT_EQ(0, memory_init(&mem, alloc_page, 0));
+
+    void * ptr_1 = memory_alloc(&mem, 200);
+    void * ptr_2 = memory_alloc(&mem, 16);
+    void * ptr_3 = memory_alloc(&mem, 240);
+    void * ptr_4 = memory_alloc(&mem, 16);
+    ASSERT_NE(nullptr, ptr_4);
+
+    EXPECT_EQ(0, memory_free(&mem, ptr_1));
+    EXPECT_EQ(0, memory_free(&mem, ptr_3));
+
+    // 200 and 240 share a class, only the second is large enough
+    EXPECT_EQ(ptr_3, memory_alloc(&mem, 220));
+
+    // Neither is large enough
+    void * ptr_5 = memory_alloc(&mem, 252);
+    EXPECT_NE(ptr_1, ptr_5);
+    EXPECT_NE(nullptr, ptr_5);
+    EXPECT_EQ(1, alloc_page_fake.call_count);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_alloc_Large_NoFreePages) {
+    FREE_ENTRIES(entry_3);
+
+    // Large allocations use the heap if pages can't be released
+    void * ptr = memory_alloc(&mem, MEMORY_LARGE_SIZE);
+    EXPECT_EQ(ENTRY_PTR(entry_3), ptr);
+    EXPECT_EQ(1, alloc_page_fake.call_count);
+    EXPECT_EQ(nullptr, mem.large);
+}
+
+TEST_F(MemoryAlloc, memory_alloc_Large) {
+    mem.free_pages_fn = free_page;
+
+    memory_entry_t * large = (memory_entry_t *)(pages.data() + PAGE_SIZE * 3);
+
+    void * ptr = memory_alloc(&mem, 5000);
+    EXPECT_EQ(ENTRY_PTR(large), ptr);
+    EXPECT_EQ(1, alloc_page_fake.call_count);
+    EXPECT_EQ(2, alloc_page_fake.arg0_val);
+
+    EXPECT_EQ(MAGIC_LARGE, large->magic);
+    EXPECT_EQ(PAGE_SIZE * 2 - sizeof(memory_entry_t), large->size);
+    EXPECT_EQ(large, mem.large);
+    EXPECT_EQ(nullptr, large->next);
+    EXPECT_EQ(nullptr, large->prev);
+
+    // Heap is not changed
+    EXPECT_EQ(entry_3, mem.last);
+    EXPECT_EQ(nullptr, entry_3->next);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_alloc_Large_Exact) {
+    mem.free_pages_fn = free_page;
+
+    // One page with it's header would take two pages, so it uses the heap
+    EXPECT_NE(nullptr, memory_alloc(&mem, MEMORY_LARGE_SIZE));
+    EXPECT_EQ(nullptr, mem.large);
+
+    memory_alloc(&mem, MEMORY_LARGE_SIZE + 4);
+    EXPECT_EQ(2, alloc_page_fake.arg0_val);
+    ASSERT_NE(nullptr, mem.large);
+
+    memory_alloc(&mem, PAGE_SIZE * 2 - sizeof(memory_entry_t));
+    EXPECT_EQ(2, alloc_page_fake.arg0_val);
+}
+
+TEST_F(MemoryAlloc, memory_alloc_Large_AllocPageFails) {
+    mem.free_pages_fn          = free_page;
+    alloc_page_fake.return_val = 0;
+
+    EXPECT_EQ(nullptr, memory_alloc(&mem, 5000));
+    EXPECT_EQ(nullptr, mem.large);
+}
+
+TEST_F(MemoryAlloc, memory_alloc_aligned_InvalidParameters) {
+    EXPECT_EQ(nullptr, memory_alloc_aligned(0, 1, 16));
+    EXPECT_EQ(nullptr, memory_alloc_aligned(&mem, 0, 16));
+    EXPECT_EQ(nullptr, memory_alloc_aligned(&mem, 1, 0));
+
+    // Not a power of 2
+    EXPECT_EQ(nullptr, memory_alloc_aligned(&mem, 1, 24));
+}
+
+TEST_F(MemoryAlloc, memory_alloc_aligned_SmallAlign) {
+    FREE_ENTRIES(entry_2);
+
+    EXPECT_EQ(ENTRY_PTR(entry_2), memory_alloc_aligned(&mem, 16, 4));
+}
+
+TEST_F(MemoryAlloc, memory_alloc_aligned_AlreadyAligned) {
+    FREE_ENTRIES(entry_2);
+
+    // Largest alignment of the entry pointer
+    uint32_t align = (uint32_t)ENTRY_PTR(entry_2) & -(uint32_t)ENTRY_PTR(entry_2);
+
+    void * ptr = memory_alloc_aligned(&mem, 64, align);
+    EXPECT_EQ(ENTRY_PTR(entry_2), ptr);
+    EXPECT_EQ(MAGIC_USED, entry_2->magic);
+    EXPECT_EQ(64, entry_2->size);
+    EXPECT_EQ(0, alloc_page_fake.call_count);
+}
+
+TEST_F(MemoryAlloc, memory_alloc_aligned) {
+    FREE_ENTRIES(entry_2);
+
+    for (size_t align : {16, 64, 256, 1024}) {
+        void * ptr = memory_alloc_aligned(&mem, 100, align);
+        ASSERT_NE(nullptr, ptr);
+        EXPECT_EQ(0, (uint32_t)ptr & (align - 1)) << "Align " << align;
+
+        memory_entry_t * entry = (memory_entry_t *)((uint32_t)ptr - sizeof(memory_entry_t));
+        EXPECT_EQ(MAGIC_USED, entry->magic);
+        EXPECT_EQ(100, entry->size);
+
+        // Gap is a free entry
+        memory_entry_t * gap = entry->prev;
+        if (gap != entry_1) {
+            EXPECT_EQ(MAGIC_FREE, gap->magic);
+            EXPECT_EQ(gap, FREE_LIST_HEAD(gap));
+        }
+
+        ASSERT_MEMORY_JOINED();
+        ASSERT_EQ(0, memory_free(&mem, ptr));
+    }
+
+    EXPECT_EQ(0, alloc_page_fake.call_count);
+    EXPECT_EQ(MAGIC_FREE, entry_2->magic);
+    EXPECT_EQ(PAGE_SIZE - sizeof(memory_entry_t), entry_2->size);
+}
+
+TEST_F(MemoryAlloc, memory_alloc_aligned_SmallGap) {
+    FREE_ENTRIES(entry_2);
+
+    // Next free pointer is 8 bytes before a 64 byte boundary
+    void * first = memory_alloc(&mem, 120 - sizeof(memory_entry_t) * 2);
+    ASSERT_EQ((uint32_t)entry_2 + sizeof(memory_entry_t), (uint32_t)first);
+
+    // Gap too small for an entry is moved to the next boundary
+    void * ptr = memory_alloc_aligned(&mem, 16, 64);
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ((uint32_t)entry_2 + 192, (uint32_t)ptr);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_alloc_aligned_Page) {
+    mem.free_pages_fn = free_page;
+
+    alloc_page_fake.return_val = pages.data() + PAGE_SIZE * 3;
+
+    void * ptr = memory_alloc_aligned(&mem, PAGE_SIZE, PAGE_SIZE);
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(0, (uint32_t)ptr & 0xfff);
+
+    // Not a separate large allocation
+    EXPECT_EQ(nullptr, mem.large);
+    EXPECT_EQ(1, alloc_page_fake.call_count);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_alloc_aligned_AllocPageFails) {
+    alloc_page_fake.return_val = 0;
+
+    EXPECT_EQ(nullptr, memory_alloc_aligned(&mem, 16, 64));
+}
+
 TEST_F(MemoryAlloc, memory_realloc) {
     EXPECT_EQ(nullptr, memory_realloc(&mem, ENTRY_PTR(entry_1), 0));
     EXPECT_EQ(nullptr, memory_realloc(&mem, 0, 2));
     EXPECT_EQ(nullptr, memory_realloc(0, ENTRY_PTR(entry_1), 2));
 
-    // Not free
-    EXPECT_EQ(nullptr, memory_realloc(&mem, ENTRY_PTR(entry_1), 2));
-
     // Not found
     EXPECT_EQ(nullptr, memory_realloc(&mem, (void *)4, 2));
 
     // Not aligned
     EXPECT_EQ(nullptr, memory_realloc(&mem, (void *)1, 2));
 
-    // TODO success
+    // Not used
+    FREE_ENTRIES(entry_1);
+    EXPECT_EQ(nullptr, memory_realloc(&mem, ENTRY_PTR(entry_1), 2));
+
+    EXPECT_EQ(0, alloc_page_fake.call_count);
+}
+
+TEST_F(MemoryAlloc, memory_realloc_SameSize) {
+    EXPECT_EQ(ENTRY_PTR(entry_1), memory_realloc(&mem, ENTRY_PTR(entry_1), PAGE_SIZE - sizeof(memory_entry_t)));
+    EXPECT_EQ(PAGE_SIZE - sizeof(memory_entry_t), entry_1->size);
+    EXPECT_EQ(entry_2, entry_1->next);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_realloc_Shrink) {
+    EXPECT_EQ(ENTRY_PTR(entry_1), memory_realloc(&mem, ENTRY_PTR(entry_1), 1024));
+    EXPECT_EQ(MAGIC_USED, entry_1->magic);
+    EXPECT_EQ(1024, entry_1->size);
+
+    memory_entry_t * remain = entry_1->next;
+    EXPECT_EQ(MAGIC_FREE, remain->magic);
+    EXPECT_EQ(PAGE_SIZE - 1024 - sizeof(memory_entry_t) * 2, remain->size);
+    EXPECT_EQ(entry_2, remain->next);
+    EXPECT_EQ(remain, FREE_LIST_HEAD(remain));
+    ASSERT_MEMORY_JOINED();
+}
 
-    // entry_1->magic = MAGIC_USED;
+TEST_F(MemoryAlloc, memory_realloc_ShrinkTooSmallToSplit) {
+    EXPECT_EQ(ENTRY_PTR(entry_1), memory_realloc(&mem, ENTRY_PTR(entry_1), PAGE_SIZE - sizeof(memory_entry_t) - 4));
+    EXPECT_EQ(PAGE_SIZE - sizeof(memory_entry_t), entry_1->size);
+    EXPECT_EQ(entry_2, entry_1->next);
+    ASSERT_MEMORY_JOINED();
+}
 
-    // void * expect_ptr = ENTRY_PTR(entry_1);
+TEST_F(MemoryAlloc, memory_realloc_ShrinkJoinNext) {
+    FREE_ENTRIES(entry_2);
 
-    // // Size does not change
-    // EXPECT_EQ(expect_ptr, memory_realloc(&mem, ENTRY_PTR(entry_1), entry_1->size));
+    EXPECT_EQ(ENTRY_PTR(entry_1), memory_realloc(&mem, ENTRY_PTR(entry_1), 1024));
+    EXPECT_EQ(1024, entry_1->size);
 
-    // // Size is less
-    // EXPECT_EQ(expect_ptr, memory_realloc(&mem, ENTRY_PTR(entry_1), entry_1->size - 8));
-    // EXPECT_EQ(PAGE_SIZE - sizeof(memory_entry_t) - 4, entry_1->size);
-    // EXPECT_EQ(MAGIC_USED, entry_1->magic);
+    memory_entry_t * remain = entry_1->next;
+    EXPECT_EQ(MAGIC_FREE, remain->magic);
+    EXPECT_EQ(PAGE_SIZE * 2 - 1024 - sizeof(memory_entry_t) * 2, remain->size);
+    EXPECT_EQ(entry_3, remain->next);
+    EXPECT_EQ(remain, entry_3->prev);
+    EXPECT_EQ(nullptr, mem.free_lists[PAGE_ENTRY_CLASS]);
+    EXPECT_EQ(remain, FREE_LIST_HEAD(remain));
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_realloc_GrowIntoNext) {
+    FREE_ENTRIES(entry_2);
+
+    EXPECT_EQ(ENTRY_PTR(entry_1), memory_realloc(&mem, ENTRY_PTR(entry_1), 6000));
+    EXPECT_EQ(6000, entry_1->size);
 
-    // memory_entry_t * entry_1_5 = (memory_entry_t *)(pages.data() + PAGE_SIZE - sizeof(memory_entry_t) * 2 - 8);
+    memory_entry_t * remain = entry_1->next;
+    EXPECT_EQ(MAGIC_FREE, remain->magic);
+    EXPECT_EQ(PAGE_SIZE * 2 - 6000 - sizeof(memory_entry_t) * 2, remain->size);
+    EXPECT_EQ(entry_3, remain->next);
+    EXPECT_EQ(0, alloc_page_fake.call_count);
+    ASSERT_MEMORY_JOINED();
+}
 
-    // EXPECT_EQ(MAGIC_FREE, entry_1_5->magic);
-    // EXPECT_EQ(4, entry_1_5->size);
-    // EXPECT_EQ(entry_1_5, entry_1->next);
-    // EXPECT_EQ(entry_1, entry_1_5->next);
-    // EXPECT_EQ(entry_2, entry_1_5->prev);
-    // EXPECT_EQ(entry_1_5, entry_2->prev);
+TEST_F(MemoryAlloc, memory_realloc_GrowIntoNextExact) {
+    FREE_ENTRIES(entry_2);
 
-    // // Size is more (next is free)
-    // EXPECT_EQ(expect_ptr, memory_realloc(&mem, ENTRY_PTR(entry_1), entry_1->size + 8));
-    // EXPECT_EQ(PAGE_SIZE - sizeof(memory_entry_t) - 4, entry_1->size);
-    // EXPECT_EQ(MAGIC_USED, entry_1->magic);
-    // EXPECT_EQ(entry_2, entry_1->next);
-    // EXPECT_EQ(entry_1, entry_2->prev);
+    EXPECT_EQ(ENTRY_PTR(entry_1), memory_realloc(&mem, ENTRY_PTR(entry_1), PAGE_SIZE * 2 - sizeof(memory_entry_t)));
+    EXPECT_EQ(PAGE_SIZE * 2 - sizeof(memory_entry_t), entry_1->size);
+    EXPECT_EQ(entry_3, entry_1->next);
+    EXPECT_EQ(nullptr, mem.free_lists[PAGE_ENTRY_CLASS]);
+    EXPECT_EQ(0, alloc_page_fake.call_count);
+    ASSERT_MEMORY_JOINED();
+}
 
-    // // Next is free (too small)
-    // EXPECT_EQ(ENTRY_PTR(entry_1), memory_realloc(&mem, ENTRY_PTR(entry_1), PAGE_SIZE * 2));
-    // EXPECT_EQ(PAGE_SIZE * 2, entry_1->size);
+TEST_F(MemoryAlloc, memory_realloc_GrowLast) {
+    EXPECT_EQ(ENTRY_PTR(entry_3), memory_realloc(&mem, ENTRY_PTR(entry_3), 6000));
+    EXPECT_EQ(6000, entry_3->size);
+    EXPECT_EQ(1, alloc_page_fake.call_count);
+    EXPECT_EQ(1, alloc_page_fake.arg0_val);
 
-    // entry_1_5 = (memory_entry_t *)(pages.data() + PAGE_SIZE * 2 + sizeof(memory_entry_t));
-    // EXPECT_EQ(entry_1_5, entry_1->next);
-    // EXPECT_EQ(entry_1, entry_1_5->prev);
-    // EXPECT_EQ(nullptr, entry_1_5->prev);
-    // EXPECT_EQ(entry_1_5, mem.last);
+    memory_entry_t * remain = entry_3->next;
+    EXPECT_EQ(MAGIC_FREE, remain->magic);
+    EXPECT_EQ(PAGE_SIZE * 2 - 6000 - sizeof(memory_entry_t) * 2, remain->size);
+    EXPECT_EQ(remain, mem.last);
+    ASSERT_MEMORY_JOINED();
+}
 
-    /*
-    - Next is free (too small)
-    - Next is free (good size)
-    - Next is free (too big)
-    - Add memory (last is free)
-    - Add memory(last is not free)
-    */
+TEST_F(MemoryAlloc, memory_realloc_GrowLastSmall) {
+    // Need less than one entry header of new memory
+    EXPECT_EQ(ENTRY_PTR(entry_3), memory_realloc(&mem, ENTRY_PTR(entry_3), PAGE_SIZE - sizeof(memory_entry_t) + 4));
+    EXPECT_EQ(PAGE_SIZE - sizeof(memory_entry_t) + 4, entry_3->size);
+    EXPECT_EQ(1, alloc_page_fake.call_count);
+    EXPECT_EQ(1, alloc_page_fake.arg0_val);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_realloc_GrowNextIsLast) {
+    FREE_ENTRIES(entry_3);
+
+    EXPECT_EQ(ENTRY_PTR(entry_2), memory_realloc(&mem, ENTRY_PTR(entry_2), PAGE_SIZE * 3 - sizeof(memory_entry_t)));
+    EXPECT_EQ(PAGE_SIZE * 3 - sizeof(memory_entry_t), entry_2->size);
+    EXPECT_EQ(nullptr, entry_2->next);
+    EXPECT_EQ(entry_2, mem.last);
+    EXPECT_EQ(nullptr, mem.free_lists[PAGE_ENTRY_CLASS]);
+    EXPECT_EQ(1, alloc_page_fake.call_count);
+    EXPECT_EQ(1, alloc_page_fake.arg0_val);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_realloc_GrowLastFails) {
+    alloc_page_fake.return_val = 0;
+
+    EXPECT_EQ(nullptr, memory_realloc(&mem, ENTRY_PTR(entry_3), 6000));
+    EXPECT_EQ(MAGIC_USED, entry_3->magic);
+    EXPECT_EQ(PAGE_SIZE - sizeof(memory_entry_t), entry_3->size);
+    EXPECT_EQ(entry_3, mem.last);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_realloc_Copy) {
+    uint32_t * data = (uint32_t *)ENTRY_PTR(entry_1);
+    for (size_t i = 0; i < entry_1->size / 4; i++) {
+        data[i] = i;
+    }
+
+    memory_entry_t * entry_4 = (memory_entry_t *)(pages.data() + PAGE_SIZE * 3);
+
+    void * ptr = memory_realloc(&mem, ENTRY_PTR(entry_1), 6000);
+    EXPECT_EQ(ENTRY_PTR(entry_4), ptr);
+    EXPECT_EQ(MAGIC_USED, entry_4->magic);
+    EXPECT_EQ(MAGIC_FREE, entry_1->magic);
+    EXPECT_EQ(1, alloc_page_fake.call_count);
+    EXPECT_EQ(2, alloc_page_fake.arg0_val);
+
+    uint32_t * new_data = (uint32_t *)ptr;
+    for (size_t i = 0; i < (PAGE_SIZE - sizeof(memory_entry_t)) / 4; i++) {
+        ASSERT_EQ(i, new_data[i]) << "Index " << i;
+    }
+
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_realloc_GrowLastNotAdjacent) {
+    memory_entry_t * entry_5 = (memory_entry_t *)(pages.data() + PAGE_SIZE * 4);
+
+    void * page_seq[] = {entry_5, 0};
+    SET_RETURN_SEQ(alloc_page, page_seq, 2);
+
+    EXPECT_EQ(nullptr, memory_realloc(&mem, ENTRY_PTR(entry_3), 6000));
+    EXPECT_EQ(MAGIC_USED, entry_3->magic);
+    EXPECT_EQ(PAGE_SIZE - sizeof(memory_entry_t), entry_3->size);
+
+    // New page is kept as a free entry
+    EXPECT_EQ(entry_5, entry_3->next);
+    EXPECT_EQ(entry_5, mem.last);
+    EXPECT_EQ(MAGIC_FREE, entry_5->magic);
+    EXPECT_EQ(entry_5, mem.free_lists[PAGE_ENTRY_CLASS]);
+    EXPECT_EQ(2, alloc_page_fake.call_count);
+}
+
+TEST_F(MemoryAlloc, memory_realloc_CopyFails) {
+    alloc_page_fake.return_val = 0;
+
+    EXPECT_EQ(nullptr, memory_realloc(&mem, ENTRY_PTR(entry_1), 6000));
+    EXPECT_EQ(MAGIC_USED, entry_1->magic);
+    EXPECT_EQ(PAGE_SIZE - sizeof(memory_entry_t), entry_1->size);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_realloc_Large) {
+    mem.free_pages_fn = free_page;
+
+    void * ptr = memory_alloc(&mem, 5000);
+    ASSERT_NE(nullptr, ptr);
+
+    // Fits in the pages already used
+    EXPECT_EQ(ptr, memory_realloc(&mem, ptr, 6000));
+    EXPECT_EQ(ptr, memory_realloc(&mem, ptr, 16));
+    EXPECT_EQ(1, alloc_page_fake.call_count);
+    EXPECT_EQ(0, free_page_fake.call_count);
+}
+
+TEST_F(MemoryAlloc, memory_realloc_LargeCopy) {
+    mem.free_pages_fn = free_page;
+
+    memory_entry_t * large_1 = (memory_entry_t *)(pages.data() + PAGE_SIZE * 3);
+    memory_entry_t * large_2 = (memory_entry_t *)(pages.data() + PAGE_SIZE * 5);
+
+    void * page_seq[] = {large_1, large_2};
+    SET_RETURN_SEQ(alloc_page, page_seq, 2);
+
+    uint32_t * ptr = (uint32_t *)memory_alloc(&mem, 5000);
+    ASSERT_NE(nullptr, ptr);
+    ptr[0]    = 0x1234;
+    ptr[1000] = 0x5678;
+
+    uint32_t * new_ptr = (uint32_t *)memory_realloc(&mem, ptr, 10000);
+    EXPECT_EQ(ENTRY_PTR(large_2), new_ptr);
+    EXPECT_EQ(3, alloc_page_fake.arg0_val);
+    EXPECT_EQ(0x1234, new_ptr[0]);
+    EXPECT_EQ(0x5678, new_ptr[1000]);
+
+    EXPECT_EQ(1, free_page_fake.call_count);
+    EXPECT_EQ(large_1, free_page_fake.arg0_val);
+    EXPECT_EQ(2, free_page_fake.arg1_val);
+    EXPECT_EQ(large_2, mem.large);
+    EXPECT_EQ(nullptr, large_2->next);
 }
 
 TEST_F(MemoryAlloc, memory_free) {
@@ -318,7 +734,554 @@ TEST_F(MemoryAlloc, memory_free) {
 
     EXPECT_EQ(0, memory_free(&mem, ENTRY_PTR(entry_2)));
     EXPECT_EQ(MAGIC_FREE, entry_2->magic);
+    EXPECT_EQ(entry_2, mem.free_lists[PAGE_ENTRY_CLASS]);
+
+    // Double free
+    EXPECT_NE(0, memory_free(&mem, ENTRY_PTR(entry_2)));
 
     // Does not exist
     EXPECT_NE(0, memory_free(&mem, (void *)0x1000));
 }
+
+TEST_F(MemoryAlloc, memory_free_OutsideHeap) {
+    // Header would be before the first entry
+    EXPECT_NE(0, memory_free(&mem, pages.data() + 4));
+
+    // Header would be after the last entry
+    EXPECT_NE(0, memory_free(&mem, ENTRY_PTR(entry_3) + 4));
+}
+
+TEST_F(MemoryAlloc, memory_free_NotEntry) {
+    EXPECT_NE(0, memory_free(&mem, ENTRY_PTR(entry_1) + 32));
+    EXPECT_EQ(MAGIC_USED, entry_1->magic);
+}
+
+TEST_F(MemoryAlloc, memory_free_NotAdjacent) {
+    // Gap between entry_1 and entry_3
+    entry_1->next = entry_3;
+    entry_3->prev = entry_1;
+
+    FREE_ENTRIES(entry_1, entry_3);
+
+    EXPECT_EQ(PAGE_SIZE - sizeof(memory_entry_t), entry_1->size);
+    EXPECT_EQ(PAGE_SIZE - sizeof(memory_entry_t), entry_3->size);
+    EXPECT_EQ(entry_3, entry_1->next);
+    EXPECT_EQ(entry_3, mem.free_lists[PAGE_ENTRY_CLASS]);
+    EXPECT_EQ(entry_1, FREE_LINK_NEXT(entry_3));
+}
+
+TEST_F(MemoryAlloc, memory_free_JoinNext) {
+    FREE_ENTRIES(entry_2, entry_1);
+
+    EXPECT_EQ(MAGIC_FREE, entry_1->magic);
+    EXPECT_EQ(PAGE_SIZE * 2 - sizeof(memory_entry_t), entry_1->size);
+    EXPECT_EQ(entry_3, entry_1->next);
+    EXPECT_EQ(entry_1, entry_3->prev);
+    EXPECT_EQ(nullptr, mem.free_lists[PAGE_ENTRY_CLASS]);
+    EXPECT_EQ(entry_1, mem.free_lists[PAGE_ENTRY_CLASS + 1]);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_free_JoinPrev) {
+    FREE_ENTRIES(entry_1, entry_2);
+
+    EXPECT_EQ(MAGIC_FREE, entry_1->magic);
+    EXPECT_EQ(PAGE_SIZE * 2 - sizeof(memory_entry_t), entry_1->size);
+    EXPECT_EQ(entry_3, entry_1->next);
+    EXPECT_EQ(entry_1, entry_3->prev);
+    EXPECT_EQ(nullptr, mem.free_lists[PAGE_ENTRY_CLASS]);
+    EXPECT_EQ(entry_1, mem.free_lists[PAGE_ENTRY_CLASS + 1]);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_free_JoinBoth) {
+    FREE_ENTRIES(entry_1, entry_3);
+
+    EXPECT_EQ(entry_3, mem.free_lists[PAGE_ENTRY_CLASS]);
+    EXPECT_EQ(entry_1, FREE_LINK_NEXT(entry_3));
+
+    FREE_ENTRIES(entry_2);
+
+    EXPECT_EQ(MAGIC_FREE, entry_1->magic);
+    EXPECT_EQ(PAGE_SIZE * 3 - sizeof(memory_entry_t), entry_1->size);
+    EXPECT_EQ(nullptr, entry_1->next);
+    EXPECT_EQ(entry_1, mem.last);
+    EXPECT_EQ(nullptr, mem.free_lists[PAGE_ENTRY_CLASS]);
+    EXPECT_EQ(0, mem.class_mask[PAGE_ENTRY_CLASS >> 5] & (1 << (PAGE_ENTRY_CLASS & 0x1f)));
+    EXPECT_EQ(entry_1, mem.free_lists[PAGE_ENTRY_CLASS + 2]);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_free_Large) {
+    mem.free_pages_fn = free_page;
+
+    memory_entry_t * large_1 = (memory_entry_t *)(pages.data() + PAGE_SIZE * 3);
+    memory_entry_t * large_2 = (memory_entry_t *)(pages.data() + PAGE_SIZE * 5);
+
+    void * page_seq[] = {large_1, large_2};
+    SET_RETURN_SEQ(alloc_page, page_seq, 2);
+
+    void * ptr_1 = memory_alloc(&mem, 5000);
+    void * ptr_2 = memory_alloc(&mem, 5000);
+    ASSERT_NE(nullptr, ptr_2);
+
+    EXPECT_EQ(large_2, mem.large);
+    EXPECT_EQ(large_1, large_2->next);
+    EXPECT_EQ(large_2, large_1->prev);
+
+    EXPECT_EQ(0, memory_free(&mem, ptr_1));
+    EXPECT_EQ(1, free_page_fake.call_count);
+    EXPECT_EQ(large_1, free_page_fake.arg0_val);
+    EXPECT_EQ(2, free_page_fake.arg1_val);
+    EXPECT_EQ(large_2, mem.large);
+    EXPECT_EQ(nullptr, large_2->next);
+
+    // Double free
+    EXPECT_NE(0, memory_free(&mem, ptr_1));
+    EXPECT_EQ(1, free_page_fake.call_count);
+
+    EXPECT_EQ(0, memory_free(&mem, ptr_2));
+    EXPECT_EQ(2, free_page_fake.call_count);
+    EXPECT_EQ(nullptr, mem.large);
+}
+
+TEST_F(MemoryAlloc, memory_free_LargeFails) {
+    mem.free_pages_fn = free_page;
+
+    memory_entry_t * large = (memory_entry_t *)(pages.data() + PAGE_SIZE * 3);
+
+    void * ptr = memory_alloc(&mem, 5000);
+    EXPECT_EQ(ENTRY_PTR(large), ptr);
+
+    free_page_fake.return_val = -1;
+
+    // Pages are kept by the heap instead
+    EXPECT_EQ(0, memory_free(&mem, ptr));
+    EXPECT_EQ(nullptr, mem.large);
+
+    EXPECT_EQ(MAGIC_FREE, large->magic);
+    EXPECT_EQ(large, mem.last);
+    EXPECT_EQ(entry_3, large->prev);
+    EXPECT_EQ(large, entry_3->next);
+    ASSERT_MEMORY_JOINED();
+
+    // Double free
+    EXPECT_NE(0, memory_free(&mem, ptr));
+
+    // Heap uses the pages
+    EXPECT_EQ(ptr, memory_alloc(&mem, 16));
+}
+
+TEST_F(MemoryAlloc, memory_free_ReleaseMiddle) {
+    mem.free_pages_fn = free_page;
+
+    FREE_ENTRIES(entry_2);
+
+    EXPECT_EQ(1, free_page_fake.call_count);
+    EXPECT_EQ(entry_2, free_page_fake.arg0_val);
+    EXPECT_EQ(1, free_page_fake.arg1_val);
+
+    EXPECT_EQ(entry_3, entry_1->next);
+    EXPECT_EQ(entry_1, entry_3->prev);
+    EXPECT_EQ(nullptr, mem.free_lists[PAGE_ENTRY_CLASS]);
+}
+
+TEST_F(MemoryAlloc, memory_free_ReleaseLast) {
+    mem.free_pages_fn = free_page;
+
+    FREE_ENTRIES(entry_3);
+
+    EXPECT_EQ(1, free_page_fake.call_count);
+    EXPECT_EQ(entry_3, free_page_fake.arg0_val);
+    EXPECT_EQ(1, free_page_fake.arg1_val);
+
+    EXPECT_EQ(nullptr, entry_2->next);
+    EXPECT_EQ(entry_2, mem.last);
+    EXPECT_EQ(nullptr, mem.free_lists[PAGE_ENTRY_CLASS]);
+}
+
+TEST_F(MemoryAlloc, memory_free_ReleaseFirstKeepsHead) {
+    mem.free_pages_fn = free_page;
+
+    FREE_ENTRIES(entry_1);
+
+    // First page is never released
+    EXPECT_EQ(0, free_page_fake.call_count);
+    EXPECT_EQ(entry_1, mem.free_lists[PAGE_ENTRY_CLASS]);
+
+    FREE_ENTRIES(entry_2);
+
+    EXPECT_EQ(1, free_page_fake.call_count);
+    EXPECT_EQ(entry_2, free_page_fake.arg0_val);
+    EXPECT_EQ(1, free_page_fake.arg1_val);
+
+    EXPECT_EQ(entry_1, mem.first);
+    EXPECT_EQ(PAGE_SIZE - sizeof(memory_entry_t), entry_1->size);
+    EXPECT_EQ(entry_3, entry_1->next);
+    EXPECT_EQ(entry_1, entry_3->prev);
+    EXPECT_EQ(entry_1, mem.free_lists[PAGE_ENTRY_CLASS]);
+}
+
+TEST_F(MemoryAlloc, memory_free_ReleaseSplitHeadTail) {
+    mem.free_pages_fn = free_page;
+
+    // entry_2 starts in the first page and ends in the third
+    memory_entry_t * entry = (memory_entry_t *)(pages.data() + 128);
+    memory_entry_t * next  = (memory_entry_t *)(pages.data() + PAGE_SIZE * 2 + 256);
+
+    entry_1->size = 128 - sizeof(memory_entry_t);
+    entry_1->next = entry;
+
+    entry->magic = MAGIC_USED;
+    entry->size  = (uint32_t)next - (uint32_t)ENTRY_PTR(entry);
+    entry->prev  = entry_1;
+    entry->next  = next;
+
+    next->magic = MAGIC_USED;
+    next->size  = PAGE_SIZE - 256 - sizeof(memory_entry_t);
+    next->prev  = entry;
+    next->next  = 0;
+
+    mem.last = next;
+
+    FREE_ENTRIES(entry);
+
+    EXPECT_EQ(1, free_page_fake.call_count);
+    EXPECT_EQ(entry_2, free_page_fake.arg0_val);
+    EXPECT_EQ(1, free_page_fake.arg1_val);
+
+    // Head is the rest of the first page
+    EXPECT_EQ(MAGIC_FREE, entry->magic);
+    EXPECT_EQ((uint32_t)entry_2, (uint32_t)ENTRY_PTR(entry) + entry->size);
+
+    // Tail is the start of the third page
+    memory_entry_t * tail = entry_3;
+    EXPECT_EQ(MAGIC_FREE, tail->magic);
+    EXPECT_EQ(256 - sizeof(memory_entry_t), tail->size);
+
+    EXPECT_EQ(tail, entry->next);
+    EXPECT_EQ(entry, tail->prev);
+    EXPECT_EQ(next, tail->next);
+    EXPECT_EQ(tail, next->prev);
+    EXPECT_EQ(next, mem.last);
+
+    EXPECT_EQ(entry, FREE_LIST_HEAD(entry));
+    EXPECT_EQ(tail, FREE_LIST_HEAD(tail));
+}
+
+TEST_F(MemoryAlloc, memory_free_ReleaseTailTooSmall) {
+    mem.free_pages_fn = free_page;
+
+    // Only 8 bytes of entry_2 are in the next page
+    memory_entry_t * next = (memory_entry_t *)(pages.data() + PAGE_SIZE * 2 + 8);
+
+    entry_2->size = (uint32_t)next - (uint32_t)ENTRY_PTR(entry_2);
+    entry_2->next = next;
+
+    next->magic = MAGIC_USED;
+    next->size  = PAGE_SIZE - 8 - sizeof(memory_entry_t);
+    next->prev  = entry_2;
+    next->next  = 0;
+
+    mem.last = next;
+
+    FREE_ENTRIES(entry_2);
+
+    // The page can't be released without leaving a tail too small for an entry
+    EXPECT_EQ(0, free_page_fake.call_count);
+    EXPECT_EQ(next, entry_2->next);
+    EXPECT_EQ(entry_2, FREE_LIST_HEAD(entry_2));
+}
+
+TEST_F(MemoryAlloc, memory_free_ReleaseFails) {
+    mem.free_pages_fn         = free_page;
+    free_page_fake.return_val = -1;
+
+    FREE_ENTRIES(entry_2);
+
+    EXPECT_EQ(1, free_page_fake.call_count);
+    EXPECT_EQ(MAGIC_FREE, entry_2->magic);
+    EXPECT_EQ(entry_2, entry_1->next);
+    EXPECT_EQ(entry_2, mem.free_lists[PAGE_ENTRY_CLASS]);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_free_ReleaseThenAlloc) {
+    mem.free_pages_fn = free_page;
+
+    FREE_ENTRIES(entry_3);
+    EXPECT_EQ(entry_2, mem.last);
+
+    // Released page is added back as a new entry
+    alloc_page_fake.return_val = entry_3;
+
+    void * ptr = memory_alloc(&mem, 64);
+    EXPECT_EQ(ENTRY_PTR(entry_3), ptr);
+    EXPECT_EQ(1, alloc_page_fake.call_count);
+    EXPECT_EQ(entry_3, entry_2->next);
+}
+
+TEST_F(MemoryAlloc, memory_free_ReleasedPage) {
+    mem.free_pages_fn = free_page;
+
+    FREE_ENTRIES(entry_2);
+    EXPECT_EQ(1, mem.released_count);
+
+    // Released page is not mapped, a stale header must not be read
+    entry_2->magic = MAGIC_USED;
+
+    EXPECT_NE(0, memory_free(&mem, ENTRY_PTR(entry_2)));
+    EXPECT_EQ(nullptr, memory_realloc(&mem, ENTRY_PTR(entry_2), 64));
+    EXPECT_EQ(1, free_page_fake.call_count);
+}
+
+TEST_F(MemoryAlloc, memory_free_ReleasedLargeInHeap) {
+    mem.free_pages_fn = free_page;
+
+    memory_entry_t * large = (memory_entry_t *)(pages.data() + PAGE_SIZE * 3);
+    memory_entry_t * tail  = (memory_entry_t *)(pages.data() + PAGE_SIZE * 5);
+
+    void * page_seq[] = {large, tail};
+    SET_RETURN_SEQ(alloc_page, page_seq, 2);
+
+    void * ptr = memory_alloc(&mem, 5000);
+    EXPECT_EQ(ENTRY_PTR(large), ptr);
+
+    // Heap grows past the large pages
+    EXPECT_EQ(ENTRY_PTR(tail), memory_alloc(&mem, 64));
+    EXPECT_LT(large, mem.last);
+
+    EXPECT_EQ(0, memory_free(&mem, ptr));
+    EXPECT_EQ(1, free_page_fake.call_count);
+
+    // Double free with a stale header in the released pages
+    large->magic = MAGIC_USED;
+
+    EXPECT_NE(0, memory_free(&mem, ptr));
+    EXPECT_EQ(1, free_page_fake.call_count);
+}
+
+TEST_F(MemoryAlloc, memory_free_ReleasedFull) {
+    mem.free_pages_fn  = free_page;
+    mem.released_count = MEMORY_RELEASED_MAX;
+
+    FREE_ENTRIES(entry_2);
+
+    // No room to track the page, so it is kept
+    EXPECT_EQ(0, free_page_fake.call_count);
+    EXPECT_EQ(entry_2, mem.free_lists[PAGE_ENTRY_CLASS]);
+    ASSERT_MEMORY_JOINED();
+}
+
+TEST_F(MemoryAlloc, memory_free_ReleaseThenAllocTracked) {
+    mem.free_pages_fn = free_page;
+
+    FREE_ENTRIES(entry_3);
+    EXPECT_EQ(1, mem.released_count);
+
+    alloc_page_fake.return_val = entry_3;
+
+    // Page is mapped again, so it's entries can be freed
+    void * ptr = memory_alloc(&mem, 64);
+    EXPECT_EQ(ENTRY_PTR(entry_3), ptr);
+    EXPECT_EQ(0, mem.released_count);
+    EXPECT_EQ(0, memory_free(&mem, ptr));
+}
+
+// Memory Alloc Pages
+
+TEST_F(MemoryAlloc, memory_alloc_pages_InvalidParameters) {
+    EXPECT_EQ(nullptr, memory_alloc_pages(0, 1));
+    EXPECT_EQ(nullptr, memory_alloc_pages(&mem, 0));
+    EXPECT_EQ(0, alloc_page_fake.call_count);
+}
+
+TEST_F(MemoryAlloc, memory_alloc_pages_AllocFails) {
+    alloc_page_fake.return_val = 0;
+
+    EXPECT_EQ(nullptr, memory_alloc_pages(&mem, 1));
+}
+
+TEST_F(MemoryAlloc, memory_alloc_pages_SplitsReleased) {
+    mem.free_pages_fn = free_page;
+
+    EXPECT_EQ(0, memory_free_pages(&mem, pages.data() + PAGE_SIZE * 3, 3));
+
+    alloc_page_fake.return_val = pages.data() + PAGE_SIZE * 4;
+
+    EXPECT_EQ(pages.data() + PAGE_SIZE * 4, memory_alloc_pages(&mem, 1));
+    ASSERT_EQ(2, mem.released_count);
+    EXPECT_EQ((uint32_t)(pages.data() + PAGE_SIZE * 3), mem.released[0].start);
+    EXPECT_EQ((uint32_t)(pages.data() + PAGE_SIZE * 4), mem.released[0].end);
+    EXPECT_EQ((uint32_t)(pages.data() + PAGE_SIZE * 5), mem.released[1].start);
+    EXPECT_EQ((uint32_t)(pages.data() + PAGE_SIZE * 6), mem.released[1].end);
+}
+
+TEST_F(MemoryAlloc, memory_alloc_pages_SplitFull) {
+    mem.free_pages_fn = free_page;
+
+    EXPECT_EQ(0, memory_free_pages(&mem, pages.data() + PAGE_SIZE * 3, 3));
+    mem.released_count = MEMORY_RELEASED_MAX;
+
+    alloc_page_fake.return_val = pages.data() + PAGE_SIZE * 4;
+
+    // Pages are given back, they are still tracked as released
+    EXPECT_EQ(nullptr, memory_alloc_pages(&mem, 1));
+    EXPECT_EQ(2, free_page_fake.call_count);
+    EXPECT_EQ(pages.data() + PAGE_SIZE * 4, free_page_fake.arg0_val);
+}
+
+// Memory Free Pages
+
+TEST_F(MemoryAlloc, memory_free_pages_InvalidParameters) {
+    EXPECT_NE(0, memory_free_pages(0, pages.data(), 1));
+    EXPECT_NE(0, memory_free_pages(&mem, 0, 1));
+    EXPECT_NE(0, memory_free_pages(&mem, pages.data(), 0));
+    EXPECT_NE(0, memory_free_pages(&mem, pages.data() + 4, 1));
+
+    // No free_pages_fn
+    EXPECT_NE(0, memory_free_pages(&mem, pages.data(), 1));
+}
+
+TEST_F(MemoryAlloc, memory_free_pages) {
+    mem.free_pages_fn = free_page;
+
+    EXPECT_EQ(0, memory_free_pages(&mem, pages.data() + PAGE_SIZE * 3, 1));
+    EXPECT_EQ(1, free_page_fake.call_count);
+    EXPECT_EQ(pages.data() + PAGE_SIZE * 3, free_page_fake.arg0_val);
+
+    // Touching ranges are joined
+    EXPECT_EQ(0, memory_free_pages(&mem, pages.data() + PAGE_SIZE * 5, 1));
+    EXPECT_EQ(0, memory_free_pages(&mem, pages.data() + PAGE_SIZE * 4, 1));
+    ASSERT_EQ(1, mem.released_count);
+    EXPECT_EQ((uint32_t)(pages.data() + PAGE_SIZE * 3), mem.released[0].start);
+    EXPECT_EQ((uint32_t)(pages.data() + PAGE_SIZE * 6), mem.released[0].end);
+}
+
+TEST_F(MemoryAlloc, memory_free_pages_Fails) {
+    mem.free_pages_fn         = free_page;
+    free_page_fake.return_val = -1;
+
+    EXPECT_NE(0, memory_free_pages(&mem, pages.data() + PAGE_SIZE * 3, 1));
+    EXPECT_EQ(0, mem.released_count);
+}
+
+TEST_F(MemoryAlloc, memory_free_pages_Full) {
+    mem.free_pages_fn  = free_page;
+    mem.released_count = MEMORY_RELEASED_MAX;
+
+    EXPECT_NE(0, memory_free_pages(&mem, pages.data() + PAGE_SIZE * 3, 1));
+    EXPECT_EQ(0, free_page_fake.call_count);
+}
+
+TEST_F(MemoryAlloc, memory_profile_top_Disabled) {
+    memory_profile_site_t site;
+
+    EXPECT_EQ(-1, memory_profile_top(&mem, &site, 1, MEMORY_PROFILE_SORT_BYTES));
+}
+
+#define THROUGHPUT_PAGE_COUNT 1024
+
+static std::array<char, PAGE_SIZE * THROUGHPUT_PAGE_COUNT> throughput_pages;
+static size_t                                              throughput_next_page;
+
+static void * throughput_alloc_pages(size_t count) {
+    if (throughput_next_page + count > THROUGHPUT_PAGE_COUNT) {
+        return 0;
+    }
+
+    void * ptr = throughput_pages.data() + throughput_next_page * PAGE_SIZE;
+    throughput_next_page += count;
+    return ptr;
+}
+
+class MemoryAllocThroughput : public ::testing::Test {
+protected:
+    memory_t            mem;
+    std::vector<void *> live;
+
+    void SetUp() override {
+        init_mocks();
+
+        RESET_FAKE(alloc_page);
+
+        throughput_next_page        = 0;
+        alloc_page_fake.custom_fake = throughput_alloc_pages;
+
+        ASSERT_EQ(0, memory_init(&mem, alloc_page, 0));
+    }
+
+    // Fill the heap with `count` live allocations of mixed sizes
+    void fill_heap(size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            void * ptr = memory_alloc(&mem, 8 + (i % 8) * 4);
+            ASSERT_NE(nullptr, ptr);
+            live.push_back(ptr);
+        }
+    }
+
+    // Unlink every entry after the first from the heap list, so a walk from
+    // the first entry finds nothing. Entries can still be reached from the
+    // free lists and from their pointers.
+    void cut_heap() {
+        mem.first->next = 0;
+    }
+};
+
+TEST_F(MemoryAllocThroughput, SmallAllocWithoutHeapWalk) {
+    ASSERT_NO_FATAL_FAILURE(fill_heap(8192));
+
+    // Two free 16 byte entries far apart, the lower one is freed first
+    void * low  = live[2];
+    void * high = live[8186];
+    ASSERT_EQ(0, memory_free(&mem, low));
+    ASSERT_EQ(0, memory_free(&mem, high));
+
+    size_t pages_before = throughput_next_page;
+
+    cut_heap();
+
+    // Head of the class list is used, a first fit walk would find the lower one
+    EXPECT_EQ(high, memory_alloc(&mem, 16));
+    EXPECT_EQ(low, memory_alloc(&mem, 16));
+    EXPECT_EQ(pages_before, throughput_next_page);
+}
+
+TEST_F(MemoryAllocThroughput, FreeWithoutHeapWalk) {
+    ASSERT_NO_FATAL_FAILURE(fill_heap(8192));
+
+    cut_heap();
+
+    // Entry is found from it's pointer
+    memory_entry_t * entry = (memory_entry_t *)((uint32_t)live[4002] - sizeof(memory_entry_t));
+
+    EXPECT_EQ(0, memory_free(&mem, live[4002]));
+    EXPECT_EQ(MAGIC_FREE, entry->magic);
+    EXPECT_EQ(entry, FREE_LIST_HEAD(entry));
+
+    // Joined with the free entry before it through the neighbour links
+    EXPECT_EQ(0, memory_free(&mem, live[4003]));
+    EXPECT_EQ(16 + 20 + sizeof(memory_entry_t), entry->size);
+    EXPECT_EQ(entry, FREE_LIST_HEAD(entry));
+}
+
+TEST_F(MemoryAllocThroughput, ReuseAfterFreeWithoutHeapWalk) {
+    ASSERT_NO_FATAL_FAILURE(fill_heap(8192));
+
+    // Free every other entry so each class has many free entries spread out
+    for (size_t i = 0; i < live.size(); i += 2) {
+        ASSERT_EQ(0, memory_free(&mem, live[i]));
+    }
+
+    size_t pages_before = throughput_next_page;
+
+    cut_heap();
+
+    for (size_t i = 0; i < live.size(); i += 2) {
+        live[i] = memory_alloc(&mem, 8 + (i % 8) * 4);
+        ASSERT_NE(nullptr, live[i]);
+    }
+
+    // All requests are served from the free lists
+    EXPECT_EQ(pages_before, throughput_next_page);
+}
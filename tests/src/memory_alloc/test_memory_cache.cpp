@@ -0,0 +1,381 @@
+#include <array>
+#include <cstdlib>
+#include <vector>
+
+#include "test_common.h"
+
+#define PAGE_SIZE 4096
+
+#define MAGIC_SLAB 0x534c4142
+
+#define PAGE_COUNT_MAX 4
+
+alignas(PAGE_SIZE) static std::array<char, PAGE_SIZE * PAGE_COUNT_MAX> pages;
+
+extern "C" {
+#include "memory_cache.h"
+
+FAKE_VALUE_FUNC(void *, alloc_page, size_t);
+FAKE_VALUE_FUNC(int, free_page, void *, size_t);
+FAKE_VOID_FUNC(ctor, void *);
+
+// Pages go straight to the page callbacks of the cache memory
+void * custom_memory_alloc_pages(memory_t * mem, size_t count) {
+    return mem->alloc_pages_fn(count);
+}
+
+int custom_memory_free_pages(memory_t * mem, void * addr, size_t count) {
+    return mem->free_pages_fn(addr, count);
+}
+}
+
+class MemoryCache : public ::testing::Test {
+protected:
+    memory_t       mem;
+    memory_cache_t cache;
+
+    memory_slab_t * slab_1;
+    memory_slab_t * slab_2;
+
+    void SetUp() override {
+        init_mocks();
+
+        RESET_FAKE(alloc_page);
+        RESET_FAKE(free_page);
+        RESET_FAKE(ctor);
+
+        pages.fill(0);
+        memset(&mem, 0, sizeof(mem));
+        memset(&cache, 0, sizeof(cache));
+
+        slab_1 = (memory_slab_t *)pages.data();
+        slab_2 = (memory_slab_t *)(pages.data() + PAGE_SIZE);
+
+        void * page_seq[] = {slab_1, slab_2, 0};
+        SET_RETURN_SEQ(alloc_page, page_seq, 3);
+
+        mem.alloc_pages_fn = alloc_page;
+
+        memory_alloc_pages_fake.custom_fake = custom_memory_alloc_pages;
+        memory_free_pages_fake.custom_fake  = custom_memory_free_pages;
+
+        ASSERT_EQ(0, memory_cache_init(&cache, &mem, 100, 0));
+    }
+};
+
+TEST_F(MemoryCache, memory_cache_init) {
+    EXPECT_NE(0, memory_cache_init(0, &mem, 4, 0));
+    EXPECT_NE(0, memory_cache_init(&cache, 0, 4, 0));
+    EXPECT_NE(0, memory_cache_init(&cache, &mem, 0, 0));
+
+    // Too large for one page
+    EXPECT_NE(0, memory_cache_init(&cache, &mem, PAGE_SIZE, 0));
+
+    EXPECT_EQ(0, memory_cache_init(&cache, &mem, 13, ctor));
+    EXPECT_EQ(&mem, cache.mem);
+    EXPECT_EQ(16, cache.obj_size);
+    EXPECT_EQ((void *)ctor, (void *)cache.ctor);
+    EXPECT_EQ(nullptr, cache.partial);
+    EXPECT_EQ(nullptr, cache.full);
+
+    // Objects, free stack and free bitmap fit in one page
+    size_t count = cache.slab_obj_count;
+    EXPECT_LT(0, count);
+    EXPECT_GE(PAGE_SIZE, sizeof(memory_slab_t) + count * (16 + sizeof(uint16_t)) + (count + 7) / 8);
+    EXPECT_LT(PAGE_SIZE, sizeof(memory_slab_t) + (count + 1) * (16 + sizeof(uint16_t)) + (count + 8) / 8);
+
+    // No pages until first alloc
+    EXPECT_EQ(0, alloc_page_fake.call_count);
+
+    // Largest object
+    size_t max_size = (PAGE_SIZE - sizeof(memory_slab_t) - sizeof(uint16_t) - 1) & ~0x3;
+    EXPECT_EQ(0, memory_cache_init(&cache, &mem, max_size, 0));
+    EXPECT_EQ(1, cache.slab_obj_count);
+    EXPECT_NE(0, memory_cache_init(&cache, &mem, max_size + 1, 0));
+}
+
+TEST_F(MemoryCache, memory_cache_alloc) {
+    EXPECT_EQ(nullptr, memory_cache_alloc(0));
+
+    void * obj_1 = memory_cache_alloc(&cache);
+    ASSERT_NE(nullptr, obj_1);
+    EXPECT_EQ(1, alloc_page_fake.call_count);
+    EXPECT_EQ(1, alloc_page_fake.arg0_val);
+
+    EXPECT_EQ(MAGIC_SLAB, slab_1->magic);
+    EXPECT_EQ(&cache, slab_1->cache);
+    EXPECT_EQ(slab_1, cache.partial);
+    EXPECT_EQ(slab_1->objects, obj_1);
+    EXPECT_EQ(cache.slab_obj_count - 1, slab_1->free_count);
+    EXPECT_EQ(0, (uint32_t)obj_1 & 0x3);
+
+    // Next object follows the first
+    void * obj_2 = memory_cache_alloc(&cache);
+    EXPECT_EQ((char *)obj_1 + cache.obj_size, obj_2);
+    EXPECT_EQ(1, alloc_page_fake.call_count);
+}
+
+TEST_F(MemoryCache, memory_cache_alloc_FillSlab) {
+    std::vector<void *> objs;
+
+    for (size_t i = 0; i < cache.slab_obj_count; i++) {
+        objs.push_back(memory_cache_alloc(&cache));
+        ASSERT_NE(nullptr, objs.back());
+        ASSERT_EQ(slab_1, (memory_slab_t *)((uintptr_t)objs.back() & ~0xfff));
+    }
+
+    EXPECT_EQ(nullptr, cache.partial);
+    EXPECT_EQ(slab_1, cache.full);
+    EXPECT_EQ(0, slab_1->free_count);
+
+    // Last object fits in the page
+    EXPECT_GE((uintptr_t)slab_1 + PAGE_SIZE, (uintptr_t)objs.back() + cache.obj_size);
+
+    void * obj = memory_cache_alloc(&cache);
+    ASSERT_NE(nullptr, obj);
+    EXPECT_EQ(slab_2->objects, obj);
+    EXPECT_EQ(2, alloc_page_fake.call_count);
+    EXPECT_EQ(slab_2, cache.partial);
+    EXPECT_EQ(slab_1, cache.full);
+}
+
+TEST_F(MemoryCache, memory_cache_alloc_AllocPageFails) {
+    alloc_page_fake.return_val_seq_idx = 2;
+
+    EXPECT_EQ(nullptr, memory_cache_alloc(&cache));
+    EXPECT_EQ(nullptr, cache.partial);
+}
+
+TEST_F(MemoryCache, memory_cache_alloc_Ctor) {
+    ASSERT_EQ(0, memory_cache_init(&cache, &mem, 100, ctor));
+
+    void * obj = memory_cache_alloc(&cache);
+    ASSERT_NE(nullptr, obj);
+
+    // Every object in the slab is constructed once
+    EXPECT_EQ(cache.slab_obj_count, ctor_fake.call_count);
+    EXPECT_EQ(slab_1->objects, ctor_fake.arg0_history[0]);
+
+    EXPECT_EQ(0, memory_cache_free(&cache, obj));
+    EXPECT_EQ(obj, memory_cache_alloc(&cache));
+    EXPECT_EQ(cache.slab_obj_count, ctor_fake.call_count);
+}
+
+TEST_F(MemoryCache, memory_cache_free) {
+    void * obj_1 = memory_cache_alloc(&cache);
+    void * obj_2 = memory_cache_alloc(&cache);
+    ASSERT_NE(nullptr, obj_2);
+
+    EXPECT_NE(0, memory_cache_free(0, obj_1));
+    EXPECT_NE(0, memory_cache_free(&cache, 0));
+
+    // Not in an object slot
+    EXPECT_NE(0, memory_cache_free(&cache, (char *)obj_1 + 4));
+
+    // In the slab header
+    EXPECT_NE(0, memory_cache_free(&cache, slab_1));
+
+    // Different cache
+    memory_cache_t other;
+    ASSERT_EQ(0, memory_cache_init(&other, &mem, 100, 0));
+    EXPECT_NE(0, memory_cache_free(&other, obj_1));
+
+    // Not a slab
+    EXPECT_NE(0, memory_cache_free(&cache, pages.data() + PAGE_SIZE * 3 + 64));
+
+    size_t free_count = slab_1->free_count;
+
+    EXPECT_EQ(0, memory_cache_free(&cache, obj_1));
+    EXPECT_EQ(free_count + 1, slab_1->free_count);
+
+    // Last freed is used first
+    EXPECT_EQ(obj_1, memory_cache_alloc(&cache));
+}
+
+TEST_F(MemoryCache, memory_cache_free_AllFree) {
+    void * obj = memory_cache_alloc(&cache);
+    ASSERT_NE(nullptr, obj);
+
+    EXPECT_EQ(0, memory_cache_free(&cache, obj));
+    EXPECT_EQ(cache.slab_obj_count, slab_1->free_count);
+
+    // Double free
+    EXPECT_NE(0, memory_cache_free(&cache, obj));
+    EXPECT_EQ(cache.slab_obj_count, slab_1->free_count);
+}
+
+TEST_F(MemoryCache, memory_cache_free_DoubleFreePartial) {
+    void * obj_1 = memory_cache_alloc(&cache);
+    void * obj_2 = memory_cache_alloc(&cache);
+    ASSERT_NE(nullptr, obj_2);
+
+    EXPECT_EQ(0, memory_cache_free(&cache, obj_1));
+    size_t free_count = slab_1->free_count;
+
+    // Slab still has a live object, so it isn't caught by the free count
+    EXPECT_NE(0, memory_cache_free(&cache, obj_1));
+    EXPECT_EQ(free_count, slab_1->free_count);
+
+    // Object is only handed out once
+    EXPECT_EQ(obj_1, memory_cache_alloc(&cache));
+    EXPECT_NE(obj_1, memory_cache_alloc(&cache));
+
+    // Freed again after it was reused
+    EXPECT_EQ(0, memory_cache_free(&cache, obj_1));
+    EXPECT_EQ(0, memory_cache_free(&cache, obj_2));
+}
+
+TEST_F(MemoryCache, memory_cache_free_PastLastObject) {
+    void * obj = memory_cache_alloc(&cache);
+    ASSERT_NE(nullptr, obj);
+
+    // Slot aligned, but past the objects of the slab
+    char * past = (char *)slab_1->objects + cache.slab_obj_count * cache.obj_size;
+    ASSERT_GT((char *)slab_1 + PAGE_SIZE, past);
+    EXPECT_NE(0, memory_cache_free(&cache, past));
+}
+
+TEST_F(MemoryCache, memory_cache_free_FullSlab) {
+    std::vector<void *> objs;
+
+    for (size_t i = 0; i < cache.slab_obj_count + 1; i++) {
+        objs.push_back(memory_cache_alloc(&cache));
+    }
+
+    EXPECT_EQ(slab_1, cache.full);
+    EXPECT_EQ(slab_2, cache.partial);
+
+    // Full slab becomes partial
+    EXPECT_EQ(0, memory_cache_free(&cache, objs[3]));
+    EXPECT_EQ(nullptr, cache.full);
+    EXPECT_EQ(slab_1, cache.partial);
+    EXPECT_EQ(slab_2, slab_1->next);
+    EXPECT_EQ(slab_1, slab_2->prev);
+
+    EXPECT_EQ(objs[3], memory_cache_alloc(&cache));
+    EXPECT_EQ(slab_1, cache.full);
+    EXPECT_EQ(slab_2, cache.partial);
+    EXPECT_EQ(nullptr, slab_2->prev);
+    EXPECT_EQ(2, alloc_page_fake.call_count);
+}
+
+TEST_F(MemoryCache, memory_cache_free_ReleaseEmpty) {
+    mem.free_pages_fn = free_page;
+
+    std::vector<void *> objs;
+
+    for (size_t i = 0; i < cache.slab_obj_count + 1; i++) {
+        objs.push_back(memory_cache_alloc(&cache));
+    }
+
+    // Only partial slab is kept when empty
+    EXPECT_EQ(0, memory_cache_free(&cache, objs.back()));
+    EXPECT_EQ(0, free_page_fake.call_count);
+    EXPECT_EQ(slab_2, cache.partial);
+    objs.pop_back();
+
+    for (auto obj : objs) {
+        EXPECT_EQ(0, memory_cache_free(&cache, obj));
+    }
+
+    EXPECT_EQ(1, free_page_fake.call_count);
+    EXPECT_EQ(slab_1, free_page_fake.arg0_val);
+    EXPECT_EQ(1, free_page_fake.arg1_val);
+    EXPECT_EQ(0, slab_1->magic);
+    EXPECT_EQ(slab_2, cache.partial);
+    EXPECT_EQ(nullptr, slab_2->next);
+    EXPECT_EQ(nullptr, cache.full);
+
+    // Released slab is no longer valid
+    EXPECT_NE(0, memory_cache_free(&cache, objs[0]));
+}
+
+TEST_F(MemoryCache, memory_cache_free_ReleaseFails) {
+    mem.free_pages_fn         = free_page;
+    free_page_fake.return_val = -1;
+
+    std::vector<void *> objs;
+
+    for (size_t i = 0; i < cache.slab_obj_count + 1; i++) {
+        objs.push_back(memory_cache_alloc(&cache));
+    }
+
+    for (size_t i = 0; i < cache.slab_obj_count; i++) {
+        EXPECT_EQ(0, memory_cache_free(&cache, objs[i]));
+    }
+
+    EXPECT_EQ(1, free_page_fake.call_count);
+    EXPECT_EQ(MAGIC_SLAB, slab_1->magic);
+    EXPECT_EQ(slab_1, cache.partial);
+    EXPECT_EQ(slab_2, slab_1->next);
+}
+
+TEST_F(MemoryCache, memory_cache_destroy_InvalidParameters) {
+    EXPECT_NE(0, memory_cache_destroy(0));
+
+    // No way to release pages
+    EXPECT_NE(0, memory_cache_destroy(&cache));
+}
+
+TEST_F(MemoryCache, memory_cache_destroy_Empty) {
+    mem.free_pages_fn = free_page;
+
+    EXPECT_EQ(0, memory_cache_destroy(&cache));
+    EXPECT_EQ(0, free_page_fake.call_count);
+}
+
+TEST_F(MemoryCache, memory_cache_destroy) {
+    mem.free_pages_fn = free_page;
+
+    // Fill the first slab and start a second
+    for (size_t i = 0; i < cache.slab_obj_count + 1; i++) {
+        ASSERT_NE(nullptr, memory_cache_alloc(&cache));
+    }
+
+    ASSERT_EQ(slab_1, cache.full);
+    ASSERT_EQ(slab_2, cache.partial);
+
+    EXPECT_EQ(0, memory_cache_destroy(&cache));
+    EXPECT_EQ(2, free_page_fake.call_count);
+    EXPECT_EQ(slab_2, free_page_fake.arg0_history[0]);
+    EXPECT_EQ(slab_1, free_page_fake.arg0_history[1]);
+    EXPECT_EQ(1, free_page_fake.arg1_val);
+    EXPECT_EQ(nullptr, cache.partial);
+    EXPECT_EQ(nullptr, cache.full);
+    EXPECT_EQ(0, slab_1->magic);
+}
+
+TEST_F(MemoryCache, memory_cache_destroy_ReleaseFails) {
+    mem.free_pages_fn         = free_page;
+    free_page_fake.return_val = -1;
+
+    ASSERT_NE(nullptr, memory_cache_alloc(&cache));
+
+    EXPECT_NE(0, memory_cache_destroy(&cache));
+    EXPECT_EQ(1, free_page_fake.call_count);
+    EXPECT_EQ(nullptr, cache.partial);
+}
+
+TEST_F(MemoryCache, memory_cache_Throughput) {
+    std::vector<void *> objs;
+
+    // Objects per slab for two slabs
+    for (size_t i = 0; i < cache.slab_obj_count * 2; i++) {
+        objs.push_back(memory_cache_alloc(&cache));
+        ASSERT_NE(nullptr, objs.back());
+    }
+
+    for (size_t r = 0; r < 1000; r++) {
+        for (size_t i = 0; i < objs.size(); i += 3) {
+            ASSERT_EQ(0, memory_cache_free(&cache, objs[i]));
+        }
+
+        for (size_t i = 0; i < objs.size(); i += 3) {
+            objs[i] = memory_cache_alloc(&cache);
+            ASSERT_NE(nullptr, objs[i]);
+        }
+    }
+
+    // All churn is served from the two slabs
+    EXPECT_EQ(2, alloc_page_fake.call_count);
+}
@@ -0,0 +1,261 @@
+#include <array>
+#include <cstdlib>
+
+#include "test_common.h"
+
+#define PAGE_SIZE 4096
+
+#define PAGE_COUNT_MAX 8
+
+#define SITE_A ((void *)0x1000)
+#define SITE_B ((void *)0x2000)
+#define SITE_C ((void *)0x1100)
+
+alignas(PAGE_SIZE) static std::array<char, PAGE_SIZE * PAGE_COUNT_MAX> pages;
+static size_t                                                          next_page;
+
+extern "C" {
+#include "memory_alloc.h"
+
+FAKE_VALUE_FUNC(void *, alloc_page, size_t);
+FAKE_VALUE_FUNC(int, free_page, void *, size_t);
+}
+
+static void * profile_alloc_pages(size_t count) {
+    if (next_page + count > PAGE_COUNT_MAX) {
+        return 0;
+    }
+
+    void * ptr = pages.data() + next_page * PAGE_SIZE;
+    next_page += count;
+    return ptr;
+}
+
+// Different call sites for memory_alloc
+__attribute__((noinline)) static void * alloc_here_1(memory_t * mem, size_t size) {
+    return memory_alloc(mem, size);
+}
+
+__attribute__((noinline)) static void * alloc_here_2(memory_t * mem, size_t size) {
+    return memory_alloc(mem, size);
+}
+
+class MemoryProfile : public ::testing::Test {
+protected:
+    memory_t mem;
+
+    void SetUp() override {
+        init_mocks();
+
+        RESET_FAKE(alloc_page);
+        RESET_FAKE(free_page);
+
+        pages.fill(0);
+        next_page = 0;
+
+        alloc_page_fake.custom_fake = profile_alloc_pages;
+
+        ASSERT_EQ(0, memory_init(&mem, alloc_page, 0));
+    }
+
+    memory_profile_site_t * find_site(void * caller) {
+        for (auto & site : mem.profile.sites) {
+            if (site.caller == caller) {
+                return &site;
+            }
+        }
+
+        return nullptr;
+    }
+};
+
+TEST_F(MemoryProfile, memory_init) {
+    mem.profile.clock           = 3;
+    mem.profile.dropped         = 2;
+    mem.profile.sites[0].caller = SITE_A;
+
+    ASSERT_EQ(0, memory_init(&mem, alloc_page, 0));
+    EXPECT_EQ(0, mem.profile.clock);
+    EXPECT_EQ(0, mem.profile.dropped);
+    EXPECT_EQ(nullptr, mem.profile.caller);
+    EXPECT_EQ(nullptr, find_site(SITE_A));
+}
+
+TEST_F(MemoryProfile, memory_alloc_from) {
+    EXPECT_EQ(nullptr, memory_alloc_from(0, 4, SITE_A));
+    EXPECT_EQ(nullptr, memory_alloc_from(&mem, 0, SITE_A));
+    EXPECT_EQ(nullptr, mem.profile.caller);
+
+    void * ptr = memory_alloc_from(&mem, 30, SITE_A);
+    ASSERT_NE(nullptr, ptr);
+
+    memory_profile_site_t * site = find_site(SITE_A);
+    ASSERT_NE(nullptr, site);
+    EXPECT_EQ(1, site->alloc_count);
+    EXPECT_EQ(32, site->alloc_bytes);
+    EXPECT_EQ(1, site->live_count);
+    EXPECT_EQ(32, site->live_bytes);
+    EXPECT_EQ(1, mem.profile.clock);
+
+    // Caller is only used once
+    EXPECT_EQ(nullptr, mem.profile.caller);
+}
+
+TEST_F(MemoryProfile, memory_alloc_ReturnAddress) {
+    alloc_here_1(&mem, 8);
+    alloc_here_1(&mem, 8);
+    alloc_here_2(&mem, 8);
+
+    memory_profile_site_t sites[4];
+
+    ASSERT_EQ(2, memory_profile_top(&mem, sites, 4, MEMORY_PROFILE_SORT_COUNT));
+    EXPECT_NE(sites[0].caller, sites[1].caller);
+    EXPECT_EQ(2, sites[0].alloc_count);
+    EXPECT_EQ(1, sites[1].alloc_count);
+}
+
+TEST_F(MemoryProfile, memory_alloc_aligned_from) {
+    EXPECT_EQ(nullptr, memory_alloc_aligned_from(&mem, 8, 3, SITE_A));
+    EXPECT_EQ(nullptr, mem.profile.caller);
+
+    void * ptr = memory_alloc_aligned_from(&mem, 8, 64, SITE_A);
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(0, (uintptr_t)ptr & 63);
+
+    // Small alignment is passed on to memory_alloc
+    ptr = memory_alloc_aligned_from(&mem, 8, 4, SITE_A);
+    ASSERT_NE(nullptr, ptr);
+
+    memory_profile_site_t * site = find_site(SITE_A);
+    ASSERT_NE(nullptr, site);
+    EXPECT_EQ(2, site->alloc_count);
+    EXPECT_EQ(2, site->live_count);
+    EXPECT_EQ(nullptr, mem.profile.caller);
+}
+
+TEST_F(MemoryProfile, memory_free) {
+    void * ptr_1 = memory_alloc_from(&mem, 16, SITE_A);
+    memory_alloc_from(&mem, 16, SITE_B);
+    memory_alloc_from(&mem, 16, SITE_B);
+    void * ptr_2 = memory_alloc_from(&mem, 32, SITE_A);
+
+    ASSERT_EQ(0, memory_free(&mem, ptr_1));
+
+    memory_profile_site_t * site = find_site(SITE_A);
+    ASSERT_NE(nullptr, site);
+    EXPECT_EQ(2, site->alloc_count);
+    EXPECT_EQ(48, site->alloc_bytes);
+    EXPECT_EQ(1, site->live_count);
+    EXPECT_EQ(32, site->live_bytes);
+
+    // Allocated at tick 0 and freed after 4 allocations
+    EXPECT_EQ(4, site->lifetime);
+
+    ASSERT_EQ(0, memory_free(&mem, ptr_2));
+    EXPECT_EQ(0, site->live_count);
+    EXPECT_EQ(0, site->live_bytes);
+    EXPECT_EQ(5, site->lifetime);
+
+    // Double free is not counted
+    EXPECT_NE(0, memory_free(&mem, ptr_2));
+    EXPECT_EQ(0, site->live_count);
+}
+
+TEST_F(MemoryProfile, memory_realloc_InPlace) {
+    void * ptr = memory_alloc_from(&mem, 16, SITE_A);
+
+    ASSERT_EQ(ptr, memory_realloc(&mem, ptr, 64));
+
+    memory_profile_site_t * site = find_site(SITE_A);
+    ASSERT_NE(nullptr, site);
+    EXPECT_EQ(1, site->alloc_count);
+    EXPECT_EQ(1, site->live_count);
+    EXPECT_EQ(64, site->live_bytes);
+
+    ASSERT_EQ(ptr, memory_realloc(&mem, ptr, 24));
+    EXPECT_EQ(24, site->live_bytes);
+}
+
+TEST_F(MemoryProfile, memory_realloc_Moved) {
+    void * ptr = memory_alloc_from(&mem, 16, SITE_A);
+    memory_alloc_from(&mem, 16, SITE_B);
+
+    void * new_ptr = memory_realloc(&mem, ptr, 64);
+    ASSERT_NE(nullptr, new_ptr);
+    ASSERT_NE(ptr, new_ptr);
+
+    // Moved memory is a new allocation from the same site
+    memory_profile_site_t * site = find_site(SITE_A);
+    ASSERT_NE(nullptr, site);
+    EXPECT_EQ(2, site->alloc_count);
+    EXPECT_EQ(1, site->live_count);
+    EXPECT_EQ(64, site->live_bytes);
+
+    // Old memory is freed after the new allocation
+    EXPECT_EQ(3, site->lifetime);
+
+    EXPECT_EQ(1, find_site(SITE_B)->alloc_count);
+}
+
+TEST_F(MemoryProfile, memory_alloc_Large) {
+    mem.free_pages_fn = free_page;
+
+    void * ptr = memory_alloc_from(&mem, MEMORY_LARGE_SIZE + 4, SITE_A);
+    ASSERT_NE(nullptr, ptr);
+
+    memory_profile_site_t * site = find_site(SITE_A);
+    ASSERT_NE(nullptr, site);
+    EXPECT_EQ(1, site->live_count);
+    EXPECT_LT(MEMORY_LARGE_SIZE, site->live_bytes);
+
+    ASSERT_EQ(0, memory_free(&mem, ptr));
+    EXPECT_EQ(0, site->live_count);
+    EXPECT_EQ(0, site->live_bytes);
+}
+
+TEST_F(MemoryProfile, memory_alloc_TableFull) {
+    for (size_t i = 0; i < MEMORY_PROFILE_SITES; i++) {
+        ASSERT_NE(nullptr, memory_alloc_from(&mem, 4, (void *)(0x1000 + i * 4)));
+    }
+
+    EXPECT_EQ(0, mem.profile.dropped);
+
+    void * ptr = memory_alloc_from(&mem, 4, SITE_B);
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(1, mem.profile.dropped);
+    EXPECT_EQ(nullptr, find_site(SITE_B));
+
+    // Untracked memory can still be freed
+    EXPECT_EQ(0, memory_free(&mem, ptr));
+}
+
+TEST_F(MemoryProfile, memory_profile_top) {
+    memory_profile_site_t sites[3];
+
+    EXPECT_EQ(-1, memory_profile_top(0, sites, 3, MEMORY_PROFILE_SORT_BYTES));
+    EXPECT_EQ(-1, memory_profile_top(&mem, 0, 3, MEMORY_PROFILE_SORT_BYTES));
+    EXPECT_EQ(0, memory_profile_top(&mem, sites, 3, MEMORY_PROFILE_SORT_BYTES));
+
+    // A has the most bytes, B the most allocations
+    memory_alloc_from(&mem, 256, SITE_A);
+    for (size_t i = 0; i < 3; i++) {
+        memory_alloc_from(&mem, 8, SITE_B);
+    }
+    memory_alloc_from(&mem, 64, SITE_C);
+    memory_alloc_from(&mem, 64, SITE_C);
+
+    ASSERT_EQ(3, memory_profile_top(&mem, sites, 3, MEMORY_PROFILE_SORT_BYTES));
+    EXPECT_EQ(SITE_A, sites[0].caller);
+    EXPECT_EQ(SITE_C, sites[1].caller);
+    EXPECT_EQ(SITE_B, sites[2].caller);
+
+    ASSERT_EQ(3, memory_profile_top(&mem, sites, 3, MEMORY_PROFILE_SORT_COUNT));
+    EXPECT_EQ(SITE_B, sites[0].caller);
+    EXPECT_EQ(SITE_C, sites[1].caller);
+    EXPECT_EQ(SITE_A, sites[2].caller);
+
+    // Only the top sites are copied
+    ASSERT_EQ(1, memory_profile_top(&mem, sites, 1, MEMORY_PROFILE_SORT_COUNT));
+    EXPECT_EQ(SITE_B, sites[0].caller);
+    EXPECT_EQ(0, memory_profile_top(&mem, sites, 0, MEMORY_PROFILE_SORT_COUNT));
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "fff.h"
+
+// cpu/isr.h is not included as _Noreturn is not valid C++
+
+DECLARE_FAKE_VOID_FUNC(disable_interrupts);
+DECLARE_FAKE_VOID_FUNC(enable_interrupts);
+
+void reset_cpu_isr_mock(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
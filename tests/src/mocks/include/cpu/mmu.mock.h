@@ -20,6 +20,10 @@ DECLARE_FAKE_VALUE_FUNC(int, mmu_table_set, mmu_table_t *, size_t, uint32_t, uin
 DECLARE_FAKE_VALUE_FUNC(uint32_t, mmu_table_get_addr, mmu_table_t *, size_t);
 DECLARE_FAKE_VALUE_FUNC(uint32_t, mmu_table_get_flags, mmu_table_t *, size_t);
 DECLARE_FAKE_VOID_FUNC(mmu_flush_tlb, uint32_t);
+DECLARE_FAKE_VALUE_FUNC(bool, mmu_pse_supported);
+DECLARE_FAKE_VOID_FUNC(mmu_enable_pse);
+DECLARE_FAKE_VALUE_FUNC(bool, mmu_pge_supported);
+DECLARE_FAKE_VOID_FUNC(mmu_enable_global_pages);
 DECLARE_FAKE_VOID_FUNC(mmu_enable_paging, uint32_t);
 DECLARE_FAKE_VOID_FUNC(mmu_disable_paging);
 DECLARE_FAKE_VALUE_FUNC(bool, mmu_paging_enabled);
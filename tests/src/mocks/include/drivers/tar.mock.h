@@ -0,0 +1,21 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "drivers/tar.h"
+#include "fff.h"
+
+DECLARE_FAKE_VALUE_FUNC(size_t, tar_file_size, tar_fs_t *, size_t);
+DECLARE_FAKE_VALUE_FUNC(int, tar_file_index, tar_fs_t *, const char *);
+DECLARE_FAKE_VALUE_FUNC(tar_fs_file_t *, tar_file_open_i, tar_fs_t *, size_t);
+DECLARE_FAKE_VOID_FUNC(tar_file_close, tar_fs_file_t *);
+DECLARE_FAKE_VALUE_FUNC(bool, tar_file_seek, tar_fs_file_t *, int, enum TAR_SEEK_ORIGIN);
+DECLARE_FAKE_VALUE_FUNC(size_t, tar_file_read, tar_fs_file_t *, char *, size_t);
+
+void reset_drivers_tar_mock(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -8,6 +8,7 @@ extern "C" {
 #include "libc/memory.h"
 
 DECLARE_FAKE_VALUE_FUNC(void *, pmalloc, size_t);
+DECLARE_FAKE_VALUE_FUNC(void *, pmalloc_aligned, size_t, size_t);
 DECLARE_FAKE_VALUE_FUNC(void *, prealloc, void *, size_t);
 DECLARE_FAKE_VOID_FUNC(pfree, void *);
 
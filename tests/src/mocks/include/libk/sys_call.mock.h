@@ -8,10 +8,14 @@ extern "C" {
 #include "libk/sys_call.h"
 
 DECLARE_FAKE_VALUE_FUNC(void *, _sys_page_alloc, size_t);
+DECLARE_FAKE_VALUE_FUNC(int, _sys_page_free, void *, size_t);
+DECLARE_FAKE_VALUE_FUNC(void *, _sys_map_file, const char *);
+DECLARE_FAKE_VALUE_FUNC(int, _sys_unmap_file, void *);
 DECLARE_FAKE_VOID_FUNC(_sys_proc_exit, uint8_t);
 DECLARE_FAKE_VOID_FUNC(_sys_proc_abort, uint8_t, const char *);
 DECLARE_FAKE_VOID_FUNC(_sys_proc_panic, const char *, const char *, unsigned int);
 DECLARE_FAKE_VALUE_FUNC(int, _sys_proc_getpid);
+DECLARE_FAKE_VALUE_FUNC(int, _sys_proc_fork);
 DECLARE_FAKE_VOID_FUNC(_sys_register_signals, void *);
 DECLARE_FAKE_VOID_FUNC(_sys_queue_event, ebus_event_t *);
 DECLARE_FAKE_VALUE_FUNC(int, _sys_yield, int, ebus_event_t *);
@@ -7,10 +7,14 @@ extern "C" {
 #include "fff.h"
 #include "memory_alloc.h"
 
-DECLARE_FAKE_VALUE_FUNC(int, memory_init, memory_t *, memory_alloc_pages_t);
+DECLARE_FAKE_VALUE_FUNC(int, memory_init, memory_t *, memory_alloc_pages_t, memory_free_pages_t);
 DECLARE_FAKE_VALUE_FUNC(void *, memory_alloc, memory_t *, size_t);
+DECLARE_FAKE_VALUE_FUNC(void *, memory_alloc_aligned, memory_t *, size_t, size_t);
 DECLARE_FAKE_VALUE_FUNC(void *, memory_realloc, memory_t *, void *, size_t);
 DECLARE_FAKE_VALUE_FUNC(int, memory_free, memory_t *, void *);
+DECLARE_FAKE_VALUE_FUNC(void *, memory_alloc_pages, memory_t *, size_t);
+DECLARE_FAKE_VALUE_FUNC(int, memory_free_pages, memory_t *, void *, size_t);
+DECLARE_FAKE_VALUE_FUNC(int, memory_profile_top, memory_t *, memory_profile_site_t *, size_t, enum MEMORY_PROFILE_SORT);
 
 void reset_memory_alloc_mock(void);
 
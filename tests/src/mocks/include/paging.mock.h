@@ -9,6 +9,7 @@ extern "C" {
 #include "paging.h"
 
 DECLARE_FAKE_VOID_FUNC(paging_init);
+DECLARE_FAKE_VALUE_FUNC(int, paging_enable_large_pages);
 DECLARE_FAKE_VALUE_FUNC(void *, paging_temp_map, uint32_t);
 DECLARE_FAKE_VOID_FUNC(paging_temp_free, uint32_t);
 DECLARE_FAKE_VALUE_FUNC(size_t, paging_temp_available);
@@ -18,6 +19,15 @@ DECLARE_FAKE_VALUE_FUNC(int, paging_add_pages, mmu_dir_t *, size_t, size_t);
 DECLARE_FAKE_VALUE_FUNC(int, paging_remove_pages, mmu_dir_t *, size_t, size_t);
 DECLARE_FAKE_VALUE_FUNC(int, paging_add_table, mmu_dir_t *, size_t);
 DECLARE_FAKE_VALUE_FUNC(int, paging_remove_table, mmu_dir_t *, size_t);
+DECLARE_FAKE_VALUE_FUNC(int, paging_share_table, mmu_dir_t *, mmu_dir_t *, size_t, int *);
+DECLARE_FAKE_VALUE_FUNC(int, paging_copy_table, mmu_dir_t *, mmu_dir_t *, size_t);
+DECLARE_FAKE_VALUE_FUNC(int, paging_copy_on_write, mmu_dir_t *, size_t);
+DECLARE_FAKE_VALUE_FUNC(int, paging_clean_page, mmu_dir_t *, size_t);
+DECLARE_FAKE_VALUE_FUNC(int, paging_drop_clean_pages, mmu_dir_t *, size_t, size_t);
+DECLARE_FAKE_VALUE_FUNC(uint32_t, paging_alloc_zeroed);
+DECLARE_FAKE_VALUE_FUNC(int, paging_alloc_zeroed_n, uint32_t *, size_t);
+DECLARE_FAKE_VALUE_FUNC(size_t, paging_zero_pool_fill, size_t);
+DECLARE_FAKE_VALUE_FUNC(size_t, paging_zero_pool_count);
 
 void reset_paging_mock(void);
 
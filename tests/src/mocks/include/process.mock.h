@@ -12,6 +12,13 @@ DECLARE_FAKE_VALUE_FUNC(int, process_free, process_t *);
 DECLARE_FAKE_VALUE_FUNC(int, process_set_entrypoint, process_t *, void *);
 DECLARE_FAKE_VALUE_FUNC(int, process_resume, process_t *, const ebus_event_t *);
 DECLARE_FAKE_VALUE_FUNC(void *, process_add_pages, process_t *, size_t);
+DECLARE_FAKE_VALUE_FUNC(void *, process_reserve_pages, process_t *, size_t);
+DECLARE_FAKE_VALUE_FUNC(int, process_remove_pages, process_t *, void *, size_t);
+DECLARE_FAKE_VALUE_FUNC(void *, process_map_file, process_t *, tar_fs_t *, size_t);
+DECLARE_FAKE_VALUE_FUNC(int, process_unmap_file, process_t *, void *);
+DECLARE_FAKE_VALUE_FUNC(int, process_drop_file_pages, process_t *);
+DECLARE_FAKE_VALUE_FUNC(int, process_page_fault, process_t *, uint32_t);
+DECLARE_FAKE_VALUE_FUNC(int, process_fork, process_t *, process_t *, uint32_t);
 DECLARE_FAKE_VALUE_FUNC(int, process_grow_stack, process_t *);
 DECLARE_FAKE_VALUE_FUNC(int, process_load_heap, process_t *, const char *, size_t);
 DECLARE_FAKE_VOID_FUNC(set_active_task, process_t *);
@@ -14,6 +14,16 @@ DECLARE_FAKE_VALUE_FUNC(size_t, ram_max_pages);
 DECLARE_FAKE_VALUE_FUNC(uint32_t, ram_page_alloc);
 DECLARE_FAKE_VALUE_FUNC(uint32_t, ram_page_palloc);
 DECLARE_FAKE_VALUE_FUNC(int, ram_page_free, uint32_t);
+DECLARE_FAKE_VALUE_FUNC(int, ram_page_alloc_n, uint32_t *, size_t);
+DECLARE_FAKE_VALUE_FUNC(int, ram_page_free_n, const uint32_t *, size_t);
+DECLARE_FAKE_VALUE_FUNC(uint32_t, ram_page_alloc_range, size_t, size_t);
+DECLARE_FAKE_VALUE_FUNC(int, ram_page_free_range, uint32_t, size_t);
+DECLARE_FAKE_VALUE_FUNC(size_t, ram_frame_db_size);
+DECLARE_FAKE_VALUE_FUNC(int, ram_frame_db_init, ram_frame_t *);
+DECLARE_FAKE_VALUE_FUNC(int, ram_frame_ref, uint32_t);
+DECLARE_FAKE_VALUE_FUNC(int, ram_frame_ref_count, uint32_t);
+DECLARE_FAKE_VALUE_FUNC(int, ram_frame_set_flags, uint32_t, uint16_t);
+DECLARE_FAKE_VALUE_FUNC(int, ram_frame_get_flags, uint32_t);
 
 void reset_ram_mock(void);
 
@@ -21,9 +21,11 @@ extern "C" {
 extern void * memcpy(void *, const void *, size_t);
 extern void * memset(void *, int, size_t);
 
+#include "cpu/isr.mock.h"
 #include "cpu/mmu.mock.h"
 #include "cpu/ports.mock.h"
 #include "cpu/tss.mock.h"
+#include "drivers/tar.mock.h"
 #include "ebus.mock.h"
 #include "libc/datastruct/array.mock.h"
 #include "libc/memory.mock.h"
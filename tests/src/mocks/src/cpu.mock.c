@@ -1,7 +1,19 @@
+#include "cpu/isr.h"
+#include "cpu/isr.mock.h"
 #include "cpu/mmu.mock.h"
 #include "cpu/ports.mock.h"
 #include "cpu/tss.mock.h"
 
+// cpu/isr.h
+
+DEFINE_FAKE_VOID_FUNC(disable_interrupts);
+DEFINE_FAKE_VOID_FUNC(enable_interrupts);
+
+void reset_cpu_isr_mock() {
+    RESET_FAKE(disable_interrupts);
+    RESET_FAKE(enable_interrupts);
+}
+
 // cpu/mmu.h
 
 DEFINE_FAKE_VOID_FUNC(mmu_dir_clear, mmu_dir_t *);
@@ -17,6 +29,10 @@ DEFINE_FAKE_VALUE_FUNC(int, mmu_table_set, mmu_table_t *, size_t, uint32_t, uint
 DEFINE_FAKE_VALUE_FUNC(uint32_t, mmu_table_get_addr, mmu_table_t *, size_t);
 DEFINE_FAKE_VALUE_FUNC(uint32_t, mmu_table_get_flags, mmu_table_t *, size_t);
 DEFINE_FAKE_VOID_FUNC(mmu_flush_tlb, uint32_t);
+DEFINE_FAKE_VALUE_FUNC(bool, mmu_pse_supported);
+DEFINE_FAKE_VOID_FUNC(mmu_enable_pse);
+DEFINE_FAKE_VALUE_FUNC(bool, mmu_pge_supported);
+DEFINE_FAKE_VOID_FUNC(mmu_enable_global_pages);
 DEFINE_FAKE_VOID_FUNC(mmu_enable_paging, uint32_t);
 DEFINE_FAKE_VOID_FUNC(mmu_disable_paging);
 DEFINE_FAKE_VALUE_FUNC(bool, mmu_paging_enabled);
@@ -38,6 +54,10 @@ void reset_cpu_mmu_mock() {
     RESET_FAKE(mmu_table_get_addr);
     RESET_FAKE(mmu_table_get_flags);
     RESET_FAKE(mmu_flush_tlb);
+    RESET_FAKE(mmu_pse_supported);
+    RESET_FAKE(mmu_enable_pse);
+    RESET_FAKE(mmu_pge_supported);
+    RESET_FAKE(mmu_enable_global_pages);
     RESET_FAKE(mmu_enable_paging);
     RESET_FAKE(mmu_disable_paging);
     RESET_FAKE(mmu_paging_enabled);
@@ -0,0 +1,19 @@
+#include "drivers/tar.mock.h"
+
+// drivers/tar.h
+
+DEFINE_FAKE_VALUE_FUNC(size_t, tar_file_size, tar_fs_t *, size_t);
+DEFINE_FAKE_VALUE_FUNC(int, tar_file_index, tar_fs_t *, const char *);
+DEFINE_FAKE_VALUE_FUNC(tar_fs_file_t *, tar_file_open_i, tar_fs_t *, size_t);
+DEFINE_FAKE_VOID_FUNC(tar_file_close, tar_fs_file_t *);
+DEFINE_FAKE_VALUE_FUNC(bool, tar_file_seek, tar_fs_file_t *, int, enum TAR_SEEK_ORIGIN);
+DEFINE_FAKE_VALUE_FUNC(size_t, tar_file_read, tar_fs_file_t *, char *, size_t);
+
+void reset_drivers_tar_mock() {
+    RESET_FAKE(tar_file_size);
+    RESET_FAKE(tar_file_index);
+    RESET_FAKE(tar_file_open_i);
+    RESET_FAKE(tar_file_close);
+    RESET_FAKE(tar_file_seek);
+    RESET_FAKE(tar_file_read);
+}
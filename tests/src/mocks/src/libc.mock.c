@@ -9,11 +9,13 @@
 // libc/memory.h
 
 DEFINE_FAKE_VALUE_FUNC(void *, pmalloc, size_t);
+DEFINE_FAKE_VALUE_FUNC(void *, pmalloc_aligned, size_t, size_t);
 DEFINE_FAKE_VALUE_FUNC(void *, prealloc, void *, size_t);
 DEFINE_FAKE_VOID_FUNC(pfree, void *);
 
 void reset_libc_memory_mock(void) {
     RESET_FAKE(pmalloc);
+    RESET_FAKE(pmalloc_aligned);
     RESET_FAKE(prealloc);
     RESET_FAKE(pfree);
 
@@ -1,14 +1,22 @@
 
 #include "memory_alloc.mock.h"
 
-DEFINE_FAKE_VALUE_FUNC(int, memory_init, memory_t *, memory_alloc_pages_t);
+DEFINE_FAKE_VALUE_FUNC(int, memory_init, memory_t *, memory_alloc_pages_t, memory_free_pages_t);
 DEFINE_FAKE_VALUE_FUNC(void *, memory_alloc, memory_t *, size_t);
+DEFINE_FAKE_VALUE_FUNC(void *, memory_alloc_aligned, memory_t *, size_t, size_t);
 DEFINE_FAKE_VALUE_FUNC(void *, memory_realloc, memory_t *, void *, size_t);
 DEFINE_FAKE_VALUE_FUNC(int, memory_free, memory_t *, void *);
+DEFINE_FAKE_VALUE_FUNC(void *, memory_alloc_pages, memory_t *, size_t);
+DEFINE_FAKE_VALUE_FUNC(int, memory_free_pages, memory_t *, void *, size_t);
+DEFINE_FAKE_VALUE_FUNC(int, memory_profile_top, memory_t *, memory_profile_site_t *, size_t, enum MEMORY_PROFILE_SORT);
 
 void reset_memory_alloc_mock() {
     RESET_FAKE(memory_init);
     RESET_FAKE(memory_alloc);
+    RESET_FAKE(memory_alloc_aligned);
     RESET_FAKE(memory_realloc);
     RESET_FAKE(memory_free);
+    RESET_FAKE(memory_alloc_pages);
+    RESET_FAKE(memory_free_pages);
+    RESET_FAKE(memory_profile_top);
 }
@@ -2,6 +2,7 @@
 #include "paging.mock.h"
 
 DEFINE_FAKE_VOID_FUNC(paging_init);
+DEFINE_FAKE_VALUE_FUNC(int, paging_enable_large_pages);
 DEFINE_FAKE_VALUE_FUNC(void *, paging_temp_map, uint32_t);
 DEFINE_FAKE_VOID_FUNC(paging_temp_free, uint32_t);
 DEFINE_FAKE_VALUE_FUNC(size_t, paging_temp_available);
@@ -11,9 +12,19 @@ DEFINE_FAKE_VALUE_FUNC(int, paging_add_pages, mmu_dir_t *, size_t, size_t);
 DEFINE_FAKE_VALUE_FUNC(int, paging_remove_pages, mmu_dir_t *, size_t, size_t);
 DEFINE_FAKE_VALUE_FUNC(int, paging_add_table, mmu_dir_t *, size_t);
 DEFINE_FAKE_VALUE_FUNC(int, paging_remove_table, mmu_dir_t *, size_t);
+DEFINE_FAKE_VALUE_FUNC(int, paging_share_table, mmu_dir_t *, mmu_dir_t *, size_t, int *);
+DEFINE_FAKE_VALUE_FUNC(int, paging_copy_table, mmu_dir_t *, mmu_dir_t *, size_t);
+DEFINE_FAKE_VALUE_FUNC(int, paging_copy_on_write, mmu_dir_t *, size_t);
+DEFINE_FAKE_VALUE_FUNC(int, paging_clean_page, mmu_dir_t *, size_t);
+DEFINE_FAKE_VALUE_FUNC(int, paging_drop_clean_pages, mmu_dir_t *, size_t, size_t);
+DEFINE_FAKE_VALUE_FUNC(uint32_t, paging_alloc_zeroed);
+DEFINE_FAKE_VALUE_FUNC(int, paging_alloc_zeroed_n, uint32_t *, size_t);
+DEFINE_FAKE_VALUE_FUNC(size_t, paging_zero_pool_fill, size_t);
+DEFINE_FAKE_VALUE_FUNC(size_t, paging_zero_pool_count);
 
 void reset_paging_mock() {
     RESET_FAKE(paging_init);
+    RESET_FAKE(paging_enable_large_pages);
     RESET_FAKE(paging_temp_map);
     RESET_FAKE(paging_temp_free);
     RESET_FAKE(paging_temp_available);
@@ -23,4 +34,13 @@ void reset_paging_mock() {
     RESET_FAKE(paging_remove_pages);
     RESET_FAKE(paging_add_table);
     RESET_FAKE(paging_remove_table);
+    RESET_FAKE(paging_share_table);
+    RESET_FAKE(paging_copy_table);
+    RESET_FAKE(paging_copy_on_write);
+    RESET_FAKE(paging_clean_page);
+    RESET_FAKE(paging_drop_clean_pages);
+    RESET_FAKE(paging_alloc_zeroed);
+    RESET_FAKE(paging_alloc_zeroed_n);
+    RESET_FAKE(paging_zero_pool_fill);
+    RESET_FAKE(paging_zero_pool_count);
 }
@@ -6,6 +6,13 @@ DEFINE_FAKE_VALUE_FUNC(int, process_free, process_t *);
 DEFINE_FAKE_VALUE_FUNC(int, process_set_entrypoint, process_t *, void *);
 DEFINE_FAKE_VALUE_FUNC(int, process_resume, process_t *, const ebus_event_t *);
 DEFINE_FAKE_VALUE_FUNC(void *, process_add_pages, process_t *, size_t);
+DEFINE_FAKE_VALUE_FUNC(void *, process_reserve_pages, process_t *, size_t);
+DEFINE_FAKE_VALUE_FUNC(int, process_remove_pages, process_t *, void *, size_t);
+DEFINE_FAKE_VALUE_FUNC(void *, process_map_file, process_t *, tar_fs_t *, size_t);
+DEFINE_FAKE_VALUE_FUNC(int, process_unmap_file, process_t *, void *);
+DEFINE_FAKE_VALUE_FUNC(int, process_drop_file_pages, process_t *);
+DEFINE_FAKE_VALUE_FUNC(int, process_page_fault, process_t *, uint32_t);
+DEFINE_FAKE_VALUE_FUNC(int, process_fork, process_t *, process_t *, uint32_t);
 DEFINE_FAKE_VALUE_FUNC(int, process_grow_stack, process_t *);
 DEFINE_FAKE_VALUE_FUNC(int, process_load_heap, process_t *, const char *, size_t);
 DEFINE_FAKE_VOID_FUNC(set_active_task, process_t *);
@@ -18,6 +25,13 @@ void reset_process_mock() {
     RESET_FAKE(process_set_entrypoint);
     RESET_FAKE(process_resume);
     RESET_FAKE(process_add_pages);
+    RESET_FAKE(process_reserve_pages);
+    RESET_FAKE(process_remove_pages);
+    RESET_FAKE(process_map_file);
+    RESET_FAKE(process_unmap_file);
+    RESET_FAKE(process_drop_file_pages);
+    RESET_FAKE(process_page_fault);
+    RESET_FAKE(process_fork);
     RESET_FAKE(process_grow_stack);
     RESET_FAKE(process_load_heap);
     RESET_FAKE(set_active_task);
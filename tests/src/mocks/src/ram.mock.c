@@ -8,6 +8,16 @@ DEFINE_FAKE_VALUE_FUNC(size_t, ram_max_pages);
 DEFINE_FAKE_VALUE_FUNC(uint32_t, ram_page_alloc);
 DEFINE_FAKE_VALUE_FUNC(uint32_t, ram_page_palloc);
 DEFINE_FAKE_VALUE_FUNC(int, ram_page_free, uint32_t);
+DEFINE_FAKE_VALUE_FUNC(int, ram_page_alloc_n, uint32_t *, size_t);
+DEFINE_FAKE_VALUE_FUNC(int, ram_page_free_n, const uint32_t *, size_t);
+DEFINE_FAKE_VALUE_FUNC(uint32_t, ram_page_alloc_range, size_t, size_t);
+DEFINE_FAKE_VALUE_FUNC(int, ram_page_free_range, uint32_t, size_t);
+DEFINE_FAKE_VALUE_FUNC(size_t, ram_frame_db_size);
+DEFINE_FAKE_VALUE_FUNC(int, ram_frame_db_init, ram_frame_t *);
+DEFINE_FAKE_VALUE_FUNC(int, ram_frame_ref, uint32_t);
+DEFINE_FAKE_VALUE_FUNC(int, ram_frame_ref_count, uint32_t);
+DEFINE_FAKE_VALUE_FUNC(int, ram_frame_set_flags, uint32_t, uint16_t);
+DEFINE_FAKE_VALUE_FUNC(int, ram_frame_get_flags, uint32_t);
 
 void reset_ram_mock() {
     RESET_FAKE(ram_init);
@@ -17,4 +27,14 @@ void reset_ram_mock() {
     RESET_FAKE(ram_page_alloc);
     RESET_FAKE(ram_page_palloc);
     RESET_FAKE(ram_page_free);
+    RESET_FAKE(ram_page_alloc_n);
+    RESET_FAKE(ram_page_free_n);
+    RESET_FAKE(ram_page_alloc_range);
+    RESET_FAKE(ram_page_free_range);
+    RESET_FAKE(ram_frame_db_size);
+    RESET_FAKE(ram_frame_db_init);
+    RESET_FAKE(ram_frame_ref);
+    RESET_FAKE(ram_frame_ref_count);
+    RESET_FAKE(ram_frame_set_flags);
+    RESET_FAKE(ram_frame_get_flags);
 }
@@ -5,9 +5,11 @@ DEFINE_FFF_GLOBALS;
 void init_mocks() {
     FFF_RESET_HISTORY();
 
+    reset_cpu_isr_mock();
     reset_cpu_mmu_mock();
     reset_cpu_ports_mock();
     reset_cpu_tss_mock();
+    reset_drivers_tar_mock();
     reset_libc_datastruct_array_mock();
     reset_libc_memory_mock();
     reset_libc_proc_mock();